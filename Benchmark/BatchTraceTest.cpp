@@ -0,0 +1,81 @@
+//  Records a short pipeline run with several inference runs per frame, replays the keypoint trace and checks that
+//  every batch entry of every record holds a run of its own: 2D keypoints, 3D keypoints, joint angles and confidences
+//  An output the driver does not rotate between runs leaves the older entries stale. Run by ctest, exits non-zero on failure
+//
+//    ./build-benchmark/batch_trace_test
+#include "pch.h"
+#include "CPipelineBenchmark.h"
+#include "CKeypointTraceReplay.h"
+#include "TestCheck.h"
+
+//  Counted by main.cpp of the benchmark, CPipelineBenchmark reads it
+std::atomic<uint64_t> g_allocations(0u);
+
+#define BATCH_TEST_RUNS 3
+#define BATCH_TEST_FRAMES 60u
+
+//  No two runs of a frame share the given output, an entry the driver left stale would repeat another one
+template<class T>
+static bool Distinct(const KeypointFrame *runs, int count, const T (KeypointFrame::*field)[BODY_JOINT_COUNT])
+{
+    for (int first = 0; first < count; first++)
+    {
+        for (int second = first + 1; second < count; second++)
+        {
+            if (!memcmp(runs[first].*field, runs[second].*field, sizeof(runs[first].*field)))
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    CScratchDirectory scratch("batch_trace_test");
+    if (scratch.GetPath().empty())
+        return 2;
+    std::string path = scratch.GetPath() + "/keypoints";
+
+    //  The synthetic body draws new noise for every run, so no two runs of a frame report the same output
+    BenchmarkOptions options;
+    options.frames = BATCH_TEST_FRAMES;
+    options.warmup = 0u;
+    options.batches = BATCH_TEST_RUNS;
+    options.recordPath = path.c_str();
+    {
+        //  The recorder writes out what it still holds when the driver is cleaned up
+        CPipelineBenchmark benchmark(options);
+        if (!benchmark.Run())
+        {
+            fprintf(stderr, "The recording run could not be set up\n");
+            return 2;
+        }
+    }
+
+    std::string file = path + ".bin";
+    CKeypointTraceReplay replay;
+    bool opened = replay.Open(file.c_str());
+    Check(opened, "replay: the recorded trace opens");
+    if (opened)
+    {
+        Check(replay.GetBatches() == (uint32_t)BATCH_TEST_RUNS, "replay: every run of a frame was recorded");
+
+        size_t stale2D = 0u, stale3D = 0u, staleAngles = 0u, staleConfidence = 0u;
+        KeypointFrame runs[BATCH_TEST_RUNS];
+        for (size_t index = 0; index < replay.GetFrameCount(); index++)
+        {
+            for (int run = 0; run < BATCH_TEST_RUNS; run++)
+                replay.Sample(replay.GetFrameTime(index), run, runs[run]);
+            stale2D += Distinct(runs, BATCH_TEST_RUNS, &KeypointFrame::keypoints) ? 0u : 1u;
+            stale3D += Distinct(runs, BATCH_TEST_RUNS, &KeypointFrame::keypoints3D) ? 0u : 1u;
+            staleAngles += Distinct(runs, BATCH_TEST_RUNS, &KeypointFrame::jointAngles) ? 0u : 1u;
+            staleConfidence += Distinct(runs, BATCH_TEST_RUNS, &KeypointFrame::confidence) ? 0u : 1u;
+        }
+        Check(stale2D == 0u, "batches: every entry has its own 2D keypoints");
+        Check(stale3D == 0u, "batches: every entry has its own 3D keypoints");
+        Check(staleAngles == 0u, "batches: every entry has its own joint angles");
+        Check(staleConfidence == 0u, "batches: every entry has its own confidences");
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "CBenchmarkHost.h"
+
+char g_modulePath[2048U];
+
+CBenchmarkHost::CBenchmarkHost(bool verbose)
+{
+    memset(m_poses, 0, sizeof(m_poses));
+    memset(m_rawPoses, 0, sizeof(m_rawPoses));
+    m_submitted = 0u;
+    m_verbose = verbose;
+}
+
+void *CBenchmarkHost::GetGenericInterface(const char *pchInterfaceVersion, vr::EVRInitError *peError)
+{
+    void *result = nullptr;
+    if (!strcmp(pchInterfaceVersion, vr::IVRServerDriverHost_Version))
+        result = static_cast<vr::IVRServerDriverHost *>(this);
+    else if (!strcmp(pchInterfaceVersion, vr::IVRProperties_Version))
+        result = static_cast<vr::IVRProperties *>(this);
+    else if (!strcmp(pchInterfaceVersion, vr::IVRDriverLog_Version))
+        result = static_cast<vr::IVRDriverLog *>(this);
+    if (peError != nullptr)
+        *peError = result != nullptr ? vr::VRInitError_None : vr::VRInitError_Init_InterfaceNotFound;
+    return result;
+}
+
+vr::DriverHandle_t CBenchmarkHost::GetDriverHandle()
+{
+    return 1u;
+}
+
+bool CBenchmarkHost::TrackedDeviceAdded(const char *pchDeviceSerialNumber, vr::ETrackedDeviceClass eDeviceClass, vr::ITrackedDeviceServerDriver *pDriver)
+{
+    uint32_t index = (uint32_t)m_devices.size();
+    m_devices.push_back(pDriver);
+    return pDriver->Activate(index) == vr::VRInitError_None;
+}
+
+void CBenchmarkHost::TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t &newPose, uint32_t unPoseStructSize)
+{
+    if (unWhichDevice < HOST_MAX_DEVICES)
+        m_poses[unWhichDevice] = newPose;
+    m_submitted++;
+}
+
+void CBenchmarkHost::VsyncEvent(double vsyncTimeOffsetSeconds)
+{
+}
+
+void CBenchmarkHost::VendorSpecificEvent(uint32_t unWhichDevice, vr::EVREventType eventType, const vr::VREvent_Data_t &eventData, double eventTimeOffset)
+{
+}
+
+bool CBenchmarkHost::IsExiting()
+{
+    return false;
+}
+
+bool CBenchmarkHost::PollNextEvent(vr::VREvent_t *pEvent, uint32_t uncbVREvent)
+{
+    return false;
+}
+
+void CBenchmarkHost::GetRawTrackedDevicePoses(float fPredictedSecondsFromNow, vr::TrackedDevicePose_t *pTrackedDevicePoseArray, uint32_t unTrackedDevicePoseArrayCount)
+{
+    for (uint32_t index = 0; index < unTrackedDevicePoseArrayCount; index++)
+    {
+        if (index < 3u)
+            pTrackedDevicePoseArray[index] = m_rawPoses[index];
+        else
+            memset(&pTrackedDevicePoseArray[index], 0, sizeof(vr::TrackedDevicePose_t));
+    }
+}
+
+void CBenchmarkHost::RequestRestart(const char *pchLocalizedReason, const char *pchExecutableToStart, const char *pchArguments, const char *pchWorkingDirectory)
+{
+}
+
+uint32_t CBenchmarkHost::GetFrameTimings(vr::Compositor_FrameTiming *pTiming, uint32_t nFrames)
+{
+    return 0u;
+}
+
+void CBenchmarkHost::SetDisplayEyeToHead(uint32_t unWhichDevice, const vr::HmdMatrix34_t &eyeToHeadLeft, const vr::HmdMatrix34_t &eyeToHeadRight)
+{
+}
+
+void CBenchmarkHost::SetDisplayProjectionRaw(uint32_t unWhichDevice, const vr::HmdRect2_t &eyeLeft, const vr::HmdRect2_t &eyeRight)
+{
+}
+
+void CBenchmarkHost::SetRecommendedRenderTargetSize(uint32_t unWhichDevice, uint32_t nWidth, uint32_t nHeight)
+{
+}
+
+vr::ETrackedPropertyError CBenchmarkHost::ReadPropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyRead_t *pBatch, uint32_t unBatchEntryCount)
+{
+    for (uint32_t index = 0; index < unBatchEntryCount; index++)
+    {
+        pBatch[index].eError = vr::TrackedProp_UnknownProperty;
+        pBatch[index].unRequiredBufferSize = 0u;
+    }
+    return vr::TrackedProp_Success;
+}
+
+vr::ETrackedPropertyError CBenchmarkHost::WritePropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyWrite_t *pBatch, uint32_t unBatchEntryCount)
+{
+    //  Nothing reads the properties back, they only have to be accepted
+    for (uint32_t index = 0; index < unBatchEntryCount; index++)
+        pBatch[index].eError = vr::TrackedProp_Success;
+    return vr::TrackedProp_Success;
+}
+
+const char *CBenchmarkHost::GetPropErrorNameFromEnum(vr::ETrackedPropertyError error)
+{
+    return error == vr::TrackedProp_Success ? "TrackedProp_Success" : "TrackedProp_Error";
+}
+
+vr::PropertyContainerHandle_t CBenchmarkHost::TrackedDeviceToPropertyContainer(vr::TrackedDeviceIndex_t nDevice)
+{
+    return (vr::PropertyContainerHandle_t)nDevice + 1u;
+}
+
+void CBenchmarkHost::Log(const char *pchLogMessage)
+{
+    if (!m_verbose)
+        return;
+    //  Most driver messages already end in a newline
+    size_t length = strlen(pchLogMessage);
+    fprintf(stderr, length > 0u && pchLogMessage[length - 1u] == '\n' ? "%s" : "%s\n", pchLogMessage);
+}
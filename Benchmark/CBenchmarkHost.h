@@ -0,0 +1,59 @@
+#pragma once
+
+//  Normally filled in by DllMain, CDriverSettings derives the settings.ini path from it
+//  Defined once for every benchmark and test, empty unless one of them sets it
+extern char g_modulePath[2048U];
+
+//  Devices the host keeps the submitted poses of, beyond that they are only counted
+#define HOST_MAX_DEVICES 32
+
+//  Plays vrserver for the benchmark: devices are activated as soon as they are added, submitted poses are kept
+//  so the output can be measured, properties are accepted and dropped, and the log goes to stderr when verbose
+class CBenchmarkHost : public vr::IVRDriverContext, public vr::IVRServerDriverHost, public vr::IVRProperties, public vr::IVRDriverLog
+{
+    std::vector<vr::ITrackedDeviceServerDriver *> m_devices;
+    vr::DriverPose_t m_poses[HOST_MAX_DEVICES];
+    uint64_t m_submitted;
+    //  What GetRawTrackedDevicePoses reports for the HMD and controllers
+    vr::TrackedDevicePose_t m_rawPoses[3];
+    bool m_verbose;
+
+    CBenchmarkHost(const CBenchmarkHost &that) = delete;
+    CBenchmarkHost &operator=(const CBenchmarkHost &that) = delete;
+public:
+    explicit CBenchmarkHost(bool verbose);
+
+    inline size_t GetDeviceCount() const { return m_devices.size(); }
+    //  The pose the device last submitted, as vrserver would keep showing it
+    inline const vr::DriverPose_t &GetPose(size_t index) const { return m_poses[index]; }
+    inline uint64_t GetSubmitted() const { return m_submitted; }
+    inline void SetRawPoses(const vr::TrackedDevicePose_t (&poses)[3]) { std::copy(poses, poses + 3, m_rawPoses); }
+
+    // vr::IVRDriverContext
+    void *GetGenericInterface(const char *pchInterfaceVersion, vr::EVRInitError *peError) override;
+    vr::DriverHandle_t GetDriverHandle() override;
+
+    // vr::IVRServerDriverHost
+    bool TrackedDeviceAdded(const char *pchDeviceSerialNumber, vr::ETrackedDeviceClass eDeviceClass, vr::ITrackedDeviceServerDriver *pDriver) override;
+    void TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t &newPose, uint32_t unPoseStructSize) override;
+    void VsyncEvent(double vsyncTimeOffsetSeconds) override;
+    void VendorSpecificEvent(uint32_t unWhichDevice, vr::EVREventType eventType, const vr::VREvent_Data_t &eventData, double eventTimeOffset) override;
+    bool IsExiting() override;
+    bool PollNextEvent(vr::VREvent_t *pEvent, uint32_t uncbVREvent) override;
+    void GetRawTrackedDevicePoses(float fPredictedSecondsFromNow, vr::TrackedDevicePose_t *pTrackedDevicePoseArray, uint32_t unTrackedDevicePoseArrayCount) override;
+    void RequestRestart(const char *pchLocalizedReason, const char *pchExecutableToStart, const char *pchArguments, const char *pchWorkingDirectory) override;
+    uint32_t GetFrameTimings(vr::Compositor_FrameTiming *pTiming, uint32_t nFrames) override;
+    //  Only declared by newer headers, so these are not marked override
+    virtual void SetDisplayEyeToHead(uint32_t unWhichDevice, const vr::HmdMatrix34_t &eyeToHeadLeft, const vr::HmdMatrix34_t &eyeToHeadRight);
+    virtual void SetDisplayProjectionRaw(uint32_t unWhichDevice, const vr::HmdRect2_t &eyeLeft, const vr::HmdRect2_t &eyeRight);
+    virtual void SetRecommendedRenderTargetSize(uint32_t unWhichDevice, uint32_t nWidth, uint32_t nHeight);
+
+    // vr::IVRProperties
+    vr::ETrackedPropertyError ReadPropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyRead_t *pBatch, uint32_t unBatchEntryCount) override;
+    vr::ETrackedPropertyError WritePropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyWrite_t *pBatch, uint32_t unBatchEntryCount) override;
+    const char *GetPropErrorNameFromEnum(vr::ETrackedPropertyError error) override;
+    vr::PropertyContainerHandle_t TrackedDeviceToPropertyContainer(vr::TrackedDeviceIndex_t nDevice) override;
+
+    // vr::IVRDriverLog
+    void Log(const char *pchLogMessage) override;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include "CServerDriver.h"
+#include "CNvSDKInterface.h"
+#include "CCameraDriver.h"
+
+//  The one friend the driver classes grant the benchmarks and tests: each harness sets up and inspects the internals
+//  it needs through here, instead of being listed as a friend of every class it touches
+class CDriverTestAccess
+{
+public:
+    //  CServerDriver
+    static inline CDriverSettings *&Settings(CServerDriver &driver) { return driver.m_driverSettings; }
+    static inline CNvSDKInterface *&NvInterface(CServerDriver &driver) { return driver.m_nvInterface; }
+    static inline const CNvSDKInterface *NvInterface(const CServerDriver &driver) { return driver.m_nvInterface; }
+    static inline CCameraDriver *&Camera(CServerDriver &driver) { return driver.m_cameraDriver; }
+    static inline CVirtualBaseStation *&Station(CServerDriver &driver) { return driver.m_station; }
+    static inline const CVirtualBaseStation *Station(const CServerDriver &driver) { return driver.m_station; }
+    static inline CPosePublisher *&Publisher(CServerDriver &driver) { return driver.m_publisher; }
+    static inline CSessionRecorder *&Recorder(CServerDriver &driver) { return driver.m_recorder; }
+    static inline CTrackerBank *&TrackerBank(CServerDriver &driver) { return driver.m_trackerBank; }
+    static inline CSnapshotBuffer<PoseSnapshot> *&PoseSnapshots(CServerDriver &driver) { return driver.m_poseSnapshots; }
+    static inline CSnapshotBuffer<DevicePoses> &DevicePoseBuffer(CServerDriver &driver) { return driver.m_devicePoses; }
+    static inline const std::vector<CVirtualBodyTracker *> &Trackers(const CServerDriver &driver) { return driver.m_trackers; }
+    static inline Proportions *&BodyProportions(CServerDriver &driver) { return driver.m_proportions; }
+    static inline CThreadSupervisor &Threads(CServerDriver &driver) { return driver.m_threads; }
+    static inline CManagedThread *&CameraThread(CServerDriver &driver) { return driver.m_camThread; }
+    static inline TRACKING_FLAG &TrackingMode(CServerDriver &driver) { return driver.m_trackingMode; }
+    static inline INTERP_MODE &Interpolation(CServerDriver &driver) { return driver.m_interpolation; }
+    static inline SubmitPolicy &Policy(CServerDriver &driver) { return driver.m_submitPolicy; }
+    static inline int &FrameCacheSize(CServerDriver &driver) { return driver.frameCacheSize; }
+    static inline bool &CacheImmediate(CServerDriver &driver) { return driver.cacheImmediate; }
+    static inline bool &PosePrediction(CServerDriver &driver) { return driver.posePrediction; }
+    static inline double &LastClock(CServerDriver &driver) { return driver.m_lastClock; }
+    static inline float GetMoveSpeed(const CServerDriver &driver) { return driver.m_moveSpeed; }
+    static inline float GetScaleSpeed(const CServerDriver &driver) { return driver.m_scaleSpeed; }
+    static inline const glm::vec3 &GetScaleFactor(const CServerDriver &driver) { return driver.m_scaleFactor; }
+    static inline bool IsMirrored(const CServerDriver &driver) { return driver.mirrored; }
+    static inline void SetupTracker(CServerDriver &driver, const char *name, TRACKING_FLAG flag, TRACKER_ROLE role) { driver.SetupTracker(name, flag, role); }
+    static inline void SetupTracker(CServerDriver &driver, const char *name, TRACKING_FLAG flag, TRACKER_ROLE role, TRACKER_ROLE secondary) { driver.SetupTracker(name, flag, role, secondary); }
+    static inline void BindInputs(CServerDriver &driver) { driver.BindInputs(); }
+
+    //  CNvSDKInterface
+    static inline glm::vec3 &Offset(CNvSDKInterface &inter) { return inter.m_offset; }
+    static inline const glm::vec3 &GetAxisScale(const CNvSDKInterface &inter) { return inter.m_axisScale; }
+    static inline unsigned int &NumKeyPoints(CNvSDKInterface &inter) { return inter.m_numKeyPoints; }
+    static inline std::vector<NvAR_Point3f> &Keypoints3D(CNvSDKInterface &inter) { return inter.m_keypoints3D; }
+    static inline std::vector<NvAR_Quaternion> &JointAngles(CNvSDKInterface &inter) { return inter.m_jointAngles; }
+    static inline std::vector<float> &KeypointsConfidence(CNvSDKInterface &inter) { return inter.m_keypointsConfidence; }
+    static inline void EmptyKeypoints(CNvSDKInterface &inter) { inter.EmptyKeypoints(); }
+    static inline void FillConfidence(CNvSDKInterface &inter) { inter.FillBatched(inter.m_keypointsConfidence, inter.m_realConfidence); }
+    static inline void FillKeypoints(CNvSDKInterface &inter) { inter.FillBatched(inter.m_keypoints3D, inter.m_realKeypoints3D); }
+    static inline void FillAngles(CNvSDKInterface &inter) { inter.FillBatched(inter.m_jointAngles, inter.m_realJointAngles); }
+    static inline void ComputeRotations(CNvSDKInterface &inter) { inter.ComputeRotations(); }
+    static inline void ComputeAvgConfidence(CNvSDKInterface &inter) { inter.ComputeAvgConfidence(); }
+    static inline void AlignToHMD(CNvSDKInterface &inter, const vr::TrackedDevicePose_t &pose) { inter.AlignToHMD(pose); }
+    static inline void AlignToControllers(CNvSDKInterface &inter, const vr::TrackedDevicePose_t &pose1, const vr::TrackedDevicePose_t &pose2) { inter.AlignToControllers(pose1, pose2); }
+    static inline void AlignWithOffset(CNvSDKInterface &inter) { inter.AlignWithOffset(); }
+    static inline void AlignToMirror(CNvSDKInterface &inter) { inter.AlignToMirror(); }
+
+    //  CCameraDriver
+    static inline std::vector<CameraInfo> &Cameras(CCameraDriver &camera) { return camera.m_cameras; }
+    static inline std::atomic<int> &CameraCount(CCameraDriver &camera) { return camera.m_cameraCount; }
+    static inline void ApplyRequests(CCameraDriver &camera) { camera.ApplyRequests(); }
+};
@@ -0,0 +1,193 @@
+#include "pch.h"
+#include "CKeypointTraceReplay.h"
+#include "CServerDriver.h"
+#include "CPoseCodec.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//  Slack when matching times to records, camera times are computed from the records themselves
+#define REPLAY_TIME_EPSILON 1e-9
+
+CKeypointTraceReplay::CKeypointTraceReplay(double speed)
+{
+    m_data = nullptr;
+    m_size = 0u;
+    m_header = nullptr;
+    m_count = 0u;
+    m_speed = speed > 0.0 ? speed : 1.0;
+    m_cursor = 0u;
+}
+
+CKeypointTraceReplay::~CKeypointTraceReplay()
+{
+    if (m_data != nullptr && m_decoded.empty())
+        munmap((void *)m_data, m_size);
+}
+
+bool CKeypointTraceReplay::Open(const char *path)
+{
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+    {
+        fprintf(stderr, "Unable to open the keypoint trace %s\n", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0 || (size_t)info.st_size < sizeof(KeypointTraceHeader))
+    {
+        fprintf(stderr, "%s is not a keypoint trace\n", path);
+        close(file);
+        return false;
+    }
+    void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    //  The mapping keeps the file referenced on its own
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        fprintf(stderr, "Unable to map the keypoint trace %s\n", path);
+        return false;
+    }
+    m_data = (const uint8_t *)data;
+    m_size = (size_t)info.st_size;
+    m_header = (const KeypointTraceHeader *)m_data;
+
+    if (m_header->IsValid() && m_header->IsEncoded() && m_header->recordSize == 0u)
+        return Decode(path);
+    if (!m_header->IsValid() || m_header->recordSize != sizeof(KeypointTraceFrame) + m_header->batches * sizeof(KeypointTraceEntry))
+    {
+        fprintf(stderr, "%s is not a keypoint trace of this version\n", path);
+        return false;
+    }
+    //  A trailing partial record is what a crash leaves behind, it is left out
+    m_count = (m_size - sizeof(KeypointTraceHeader)) / m_header->recordSize;
+    if (m_count == 0u)
+    {
+        fprintf(stderr, "%s holds no frames\n", path);
+        return false;
+    }
+    //  The benchmark reads records front to back
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    return true;
+}
+
+bool CKeypointTraceReplay::Decode(const char *path)
+{
+    size_t batches = m_header->batches;
+    size_t recordSize = sizeof(KeypointTraceFrame) + batches * sizeof(KeypointTraceEntry);
+    KeypointTraceHeader header = *m_header;
+    header.recordSize = (uint32_t)recordSize;
+    header.flags &= ~KEYPOINT_TRACE_ENCODED;
+    m_decoded.assign((const uint8_t *)&header, (const uint8_t *)(&header + 1));
+
+    //  Run n of every record continues the stream of run n of the record before
+    CPoseDecoder decoders[KEYPOINT_TRACE_BATCHES_MAX];
+    KeypointTraceEntry entry;
+    size_t offset = sizeof(KeypointTraceHeader);
+    while (offset + sizeof(KeypointTraceFrame) <= m_size)
+    {
+        KeypointTraceFrame frame;
+        memcpy(&frame, m_data + offset, sizeof(frame));
+        const uint8_t *packets = m_data + offset + sizeof(frame);
+        size_t left = m_size - offset - sizeof(frame);
+        //  Like a partial raw record, whatever a crash cut short is left out
+        size_t packetBytes = frame.packetBytes;
+        if (packetBytes > left)
+            break;
+        left = packetBytes;
+
+        size_t start = m_decoded.size();
+        m_decoded.resize(start + recordSize);
+        frame.packetBytes = 0u;
+        memcpy(m_decoded.data() + start, &frame, sizeof(frame));
+        size_t batch = 0;
+        for (; batch < batches; batch++)
+        {
+            size_t length = decoders[batch].Decode(packets, left, entry);
+            if (length == 0u)
+                break;
+            memcpy(m_decoded.data() + start + sizeof(frame) + batch * sizeof(KeypointTraceEntry), &entry, sizeof(entry));
+            packets += length;
+            left -= length;
+        }
+        if (batch < batches)
+        {
+            fprintf(stderr, "%s holds a broken record after %llu frames, the rest is left out\n", path,
+                (unsigned long long)((start - sizeof(KeypointTraceHeader)) / recordSize));
+            m_decoded.resize(start);
+            break;
+        }
+        offset += sizeof(frame) + packetBytes;
+    }
+
+    munmap((void *)m_data, m_size);
+    m_data = m_decoded.data();
+    m_size = m_decoded.size();
+    m_header = (const KeypointTraceHeader *)m_data;
+    m_count = (m_size - sizeof(KeypointTraceHeader)) / recordSize;
+    if (m_count == 0u)
+    {
+        fprintf(stderr, "%s holds no frames\n", path);
+        return false;
+    }
+    return true;
+}
+
+double CKeypointTraceReplay::GetFrameTime(size_t index) const
+{
+    return (GetFrame(index).captureTime - GetFrame(0).captureTime) / m_speed;
+}
+
+void CKeypointTraceReplay::GetCamera(glm::vec3 &position, glm::quat &rotation) const
+{
+    const float *camera = GetFrame(0).camera;
+    position = glm::vec3(camera[0], camera[1], camera[2]);
+    rotation = glm::quat(camera[6], camera[3], camera[4], camera[5]);
+}
+
+void CKeypointTraceReplay::GetImageSize(int &width, int &height) const
+{
+    width = GetFrame(0).width;
+    height = GetFrame(0).height;
+}
+
+size_t CKeypointTraceReplay::Find(double time)
+{
+    if (m_cursor >= m_count || GetFrameTime(m_cursor) > time + REPLAY_TIME_EPSILON)
+        m_cursor = 0u;
+    while (m_cursor + 1u < m_count && GetFrameTime(m_cursor + 1u) <= time + REPLAY_TIME_EPSILON)
+        m_cursor++;
+    return m_cursor;
+}
+
+bool CKeypointTraceReplay::Sample(double time, int run, KeypointFrame &frame)
+{
+    if (m_count == 0u)
+        return false;
+    size_t index = Find(time);
+    //  Entry 0 is the newest run of the frame, the first run is the last entry kept
+    size_t batches = m_header->batches;
+    size_t batch = (size_t)run < batches ? batches - 1u - (size_t)run : 0u;
+    const KeypointTraceEntry &entry = GetEntry(index, batch);
+    memcpy(frame.keypoints, entry.keypoints, sizeof(frame.keypoints));
+    memcpy(frame.keypoints3D, entry.keypoints3D, sizeof(frame.keypoints3D));
+    memcpy(frame.jointAngles, entry.jointAngles, sizeof(frame.jointAngles));
+    memcpy(frame.confidence, entry.confidence, sizeof(frame.confidence));
+    frame.bbox = GetFrame(index).box;
+    return index + 1u < m_count || time <= GetFrameTime(index) + REPLAY_TIME_EPSILON;
+}
+
+void CKeypointTraceReplay::GetDevicePoses(double time, DevicePoses &devices)
+{
+    const KeypointTraceFrame &record = GetFrame(Find(time));
+    for (int index = 0; index < 3; index++)
+    {
+        vr::TrackedDevicePose_t &pose = devices.poses[index];
+        memset(&pose, 0, sizeof(pose));
+        pose.mDeviceToAbsoluteTracking = record.devices[index];
+        pose.bPoseIsValid = (record.deviceFlags[index] & KEYPOINT_TRACE_POSE_VALID) != 0u;
+        pose.bDeviceIsConnected = (record.deviceFlags[index] & KEYPOINT_TRACE_POSE_CONNECTED) != 0u;
+        pose.eTrackingResult = pose.bPoseIsValid ? vr::TrackingResult_Running_OK : vr::TrackingResult_Running_OutOfRange;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "CReplayBackend.h"
+#include "CKeypointTrace.h"
+
+//  Plays a keypoint trace recorded by the driver (see CKeypointTrace.h) back through the replay backend
+//  The file is mapped read only and records are read in place, nothing is loaded up front
+//  An encoded trace is the exception: it can only be read front to back, so Open decodes it into raw records in memory
+//  Time 0 is the first record; a speed above 1 plays the session back faster than it was recorded
+class CKeypointTraceReplay : public CKeypointSource
+{
+    const uint8_t *m_data;
+    size_t m_size;
+    //  Header and raw records decoded from an encoded trace, m_data points into it instead of the mapping
+    std::vector<uint8_t> m_decoded;
+    const KeypointTraceHeader *m_header;
+    size_t m_count;
+    double m_speed;
+    //  Record the last lookup landed on, camera and display times only move forward
+    size_t m_cursor;
+
+    CKeypointTraceReplay(const CKeypointTraceReplay &that) = delete;
+    CKeypointTraceReplay &operator=(const CKeypointTraceReplay &that) = delete;
+
+    inline const KeypointTraceFrame &GetFrame(size_t index) const
+    {
+        return *(const KeypointTraceFrame *)(m_data + sizeof(KeypointTraceHeader) + index * m_header->recordSize);
+    }
+    inline const KeypointTraceEntry &GetEntry(size_t index, size_t batch) const
+    {
+        return ((const KeypointTraceEntry *)(&GetFrame(index) + 1))[batch];
+    }
+    //  The newest record at or before the given time
+    size_t Find(double time);
+    //  Replace the mapped encoded trace by its raw records, false when not a single record could be decoded
+    bool Decode(const char *path);
+public:
+    explicit CKeypointTraceReplay(double speed = 1.0);
+    ~CKeypointTraceReplay();
+
+    //  Map the file, errors are printed to stderr
+    bool Open(const char *path);
+
+    inline size_t GetFrameCount() const { return m_count; }
+    inline uint32_t GetBatches() const { return m_header->batches; }
+    //  When a record's frame was captured, on the replay clock (seconds)
+    double GetFrameTime(size_t index) const;
+    //  Where the camera was for the first record, and the size of the image
+    void GetCamera(glm::vec3 &position, glm::quat &rotation) const;
+    void GetImageSize(int &width, int &height) const;
+
+    //  Runs are mapped back to their batch entry, later runs than the trace kept repeat the newest one
+    bool Sample(double time, int run, KeypointFrame &frame) override;
+    //  The poses recorded with the newest camera frame, SteamVR's finer rate is not in the trace
+    void GetDevicePoses(double time, DevicePoses &devices) override;
+};
@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "CMathFixture.h"
+#include "CSyntheticBody.h"
+#include "CNvSDKInterface.h"
+#include "CDriverTestAccess.h"
+#include "CDriverSettings.h"
+#include "CCommon.h"
+
+//  Camera frame interval the tracker samples are taken at, the default CameraFPS
+#define MATH_FIXTURE_FRAME (1.0 / 30.0)
+//  Keypoint noise (meters) and seed of the synthetic body, the pipeline benchmark's defaults
+#define MATH_FIXTURE_NOISE .005f
+#define MATH_FIXTURE_SEED 1u
+
+CMathFixture::CMathFixture() : m_host(false)
+{
+    vr::InitServerDriverContext(&m_host);
+    m_body.reset(new CSyntheticBody(CSyntheticBody::c_camera, MATH_FIXTURE_NOISE, MATH_FIXTURE_SEED));
+
+    //  The proportions settings.ini ships with, GetTransformFromRole reads them through the driver
+    CDriverTestAccess::BodyProportions(m_driver) = new Proportions(0.f, -.3f, -.1f, 0.f, .4f);
+    m_interface = new CNvSDKInterface();
+    CDriverTestAccess::NvInterface(m_driver) = m_interface;
+    m_interface->driver = &m_driver;
+    m_interface->batchSize = 1;
+    CDriverTestAccess::NumKeyPoints(*m_interface) = (unsigned int)BODY_JOINT_COUNT;
+    m_interface->SetCamera(CSyntheticBody::c_camera, glm::quat(1.f, 0.f, 0.f, 0.f));
+    CDriverTestAccess::EmptyKeypoints(*m_interface);
+
+    //  Consecutive camera frames for the interpolation and pose codec benchmarks
+    for (size_t index = 0; index < MATH_FIXTURE_SAMPLES; index++)
+    {
+        LoadFrame(index * MATH_FIXTURE_FRAME, 1);
+        Reset(1);
+        SampleTrackers(m_trackerSamples[index]);
+        const KeypointFrame &frame = m_frames[0];
+        KeypointTraceEntry &entry = m_entrySamples[index];
+        memcpy(entry.keypoints, frame.keypoints, sizeof(entry.keypoints));
+        memcpy(entry.keypoints3D, frame.keypoints3D, sizeof(entry.keypoints3D));
+        memcpy(entry.jointAngles, frame.jointAngles, sizeof(entry.jointAngles));
+        memcpy(entry.confidence, frame.confidence, sizeof(entry.confidence));
+    }
+    //  Every role of every sample in turn, as the matrices the glm paths took and the transforms that replaced them
+    for (size_t index = 0; index < MATH_FIXTURE_TRANSFORMS; index++)
+    {
+        m_rigidSamples[index] = GetTrackerSample(index / MATH_FIXTURE_ROLES).Get(index % MATH_FIXTURE_ROLES);
+        m_matrixSamples[index] = m_rigidSamples[index].Matrix();
+    }
+    //  Then the one frame every other benchmark starts from, mid stride so no limb is at rest
+    LoadFrame(.25 / SYNTHETIC_STEP_RATE, MATH_FIXTURE_BATCHES_MAX);
+    Reset(1);
+}
+
+void CMathFixture::LoadFrame(double time, int batches)
+{
+    //  Every batch is an inference run on the same image, so only the noise differs between them
+    for (int batch = 0; batch < batches; batch++)
+        m_body->Sample(time, batch, m_frames[batch]);
+    m_body->GetDevicePoses(time, m_devicePoses);
+}
+
+void CMathFixture::Reset(int batches)
+{
+    CNvSDKInterface &inter = *m_interface;
+    size_t count = (size_t)batches * BODY_JOINT_COUNT;
+    inter.realBatches = batches;
+    std::vector<NvAR_Point3f> &keypoints3D = CDriverTestAccess::Keypoints3D(inter);
+    std::vector<NvAR_Quaternion> &jointAngles = CDriverTestAccess::JointAngles(inter);
+    std::vector<float> &confidence = CDriverTestAccess::KeypointsConfidence(inter);
+    keypoints3D.resize(count);
+    jointAngles.resize(count);
+    confidence.resize(count);
+    for (int batch = 0; batch < batches; batch++)
+    {
+        const KeypointFrame &frame = m_frames[batch];
+        std::copy(frame.keypoints3D, frame.keypoints3D + BODY_JOINT_COUNT, keypoints3D.begin() + batch * BODY_JOINT_COUNT);
+        std::copy(frame.jointAngles, frame.jointAngles + BODY_JOINT_COUNT, jointAngles.begin() + batch * BODY_JOINT_COUNT);
+        std::copy(frame.confidence, frame.confidence + BODY_JOINT_COUNT, confidence.begin() + batch * BODY_JOINT_COUNT);
+    }
+
+    //  The post-processing of RunFrame, so the real keypoints and rotations are what the trackers would see
+    ComputeAvgConfidence();
+    FillConfidence();
+    FillKeypoints();
+    AlignToHMD();
+    AlignToControllers();
+    AlignWithOffset();
+    ComputeRotations();
+}
+
+void CMathFixture::SampleTrackers(TransformLanes &out) const
+{
+    for (size_t role = 0; role < MATH_FIXTURE_ROLES; role++)
+        out.Set(role, m_interface->GetTransformFromRole((TRACKER_ROLE)role));
+}
+
+void CMathFixture::FillConfidence()
+{
+    CDriverTestAccess::FillConfidence(*m_interface);
+}
+
+void CMathFixture::FillKeypoints()
+{
+    CDriverTestAccess::FillKeypoints(*m_interface);
+}
+
+void CMathFixture::FillAngles()
+{
+    CDriverTestAccess::FillAngles(*m_interface);
+}
+
+void CMathFixture::ComputeRotations()
+{
+    CDriverTestAccess::ComputeRotations(*m_interface);
+}
+
+void CMathFixture::ComputeAvgConfidence()
+{
+    CDriverTestAccess::ComputeAvgConfidence(*m_interface);
+}
+
+void CMathFixture::AlignToHMD()
+{
+    CDriverTestAccess::AlignToHMD(*m_interface, m_devicePoses.poses[0]);
+}
+
+void CMathFixture::AlignToControllers()
+{
+    CDriverTestAccess::AlignToControllers(*m_interface, m_devicePoses.poses[1], m_devicePoses.poses[2]);
+}
+
+void CMathFixture::AlignWithOffset()
+{
+    CDriverTestAccess::AlignWithOffset(*m_interface);
+}
+
+void CMathFixture::AlignToMirror()
+{
+    CDriverTestAccess::AlignToMirror(*m_interface);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "CServerDriver.h"
+#include "CBenchmarkHost.h"
+#include "CReplayBackend.h"
+#include "CRigidTransform.h"
+#include "CKeypointTrace.h"
+
+class CNvSDKInterface;
+class CSyntheticBody;
+
+//  Most inference runs per frame the fixture is filled for (BatchSize * Batches in settings.ini)
+#define MATH_FIXTURE_BATCHES_MAX 8
+//  Every tracker role, the most a tracker bank interpolates at once
+#define MATH_FIXTURE_ROLES ((size_t)TRACKER_ROLE::RIGHT_HAND + 1u)
+//  Tracker samples kept for pushing into histories, enough to cycle through the deepest cache twice
+#define MATH_FIXTURE_SAMPLES (2 * TRANSFORM_HISTORY_MAX)
+//  Single transforms taken from those samples for the glm / RigidTransform comparisons, a power of 2 so cycling is a mask
+#define MATH_FIXTURE_TRANSFORMS 256u
+
+//  Fixed inputs for the math microbenchmarks, and access to the CNvSDKInterface internals they measure
+//  Everything comes from CSyntheticBody with a fixed seed, so every run (and every commit) sees the same numbers
+//  The interface is set up by hand rather than through KeyInfoUpdated, nothing of the SDK is involved
+class CMathFixture
+{
+    //  Has to outlive the driver, which logs and clears the driver context when it is destroyed
+    CBenchmarkHost m_host;
+    CServerDriver m_driver;
+    //  Owned by m_driver
+    CNvSDKInterface *m_interface;
+    std::unique_ptr<CSyntheticBody> m_body;
+
+    //  Camera frames the batched SDK outputs are filled from, one per inference run
+    KeypointFrame m_frames[MATH_FIXTURE_BATCHES_MAX];
+    DevicePoses m_devicePoses;
+    //  Every role's transform at consecutive camera frames, as the tracker bank receives them
+    TransformLanes m_trackerSamples[MATH_FIXTURE_SAMPLES];
+    //  The SDK outputs of those frames, as the keypoint trace records them
+    KeypointTraceEntry m_entrySamples[MATH_FIXTURE_SAMPLES];
+    //  The same tracker transforms in both representations, so the paired benchmarks see identical inputs
+    RigidTransform m_rigidSamples[MATH_FIXTURE_TRANSFORMS];
+    glm::mat4x4 m_matrixSamples[MATH_FIXTURE_TRANSFORMS];
+
+    CMathFixture(const CMathFixture &that) = delete;
+    CMathFixture &operator=(const CMathFixture &that) = delete;
+
+    //  Sample the body for one camera frame and run the post-processing RunFrame does on it
+    void LoadFrame(double time, int batches);
+public:
+    CMathFixture();
+
+    //  Restore the fixed frame, with the given number of batched inference results
+    void Reset(int batches);
+
+    inline CNvSDKInterface &Interface() { return *m_interface; }
+    inline const TransformLanes &GetTrackerSample(size_t index) const { return m_trackerSamples[index % MATH_FIXTURE_SAMPLES]; }
+    void SampleTrackers(TransformLanes &out) const;
+    inline const KeypointTraceEntry &GetEntrySample(size_t index) const { return m_entrySamples[index % MATH_FIXTURE_SAMPLES]; }
+    inline const RigidTransform &GetRigidSample(size_t index) const { return m_rigidSamples[index & (MATH_FIXTURE_TRANSFORMS - 1u)]; }
+    inline const glm::mat4x4 &GetMatrixSample(size_t index) const { return m_matrixSamples[index & (MATH_FIXTURE_TRANSFORMS - 1u)]; }
+
+    //  Private to CNvSDKInterface, forwarded for the benchmarks
+    void FillConfidence();
+    void FillKeypoints();
+    void FillAngles();
+    void ComputeRotations();
+    void ComputeAvgConfidence();
+    void AlignToHMD();
+    void AlignToControllers();
+    void AlignWithOffset();
+    void AlignToMirror();
+};
@@ -0,0 +1,391 @@
+#include "pch.h"
+#include "CPipelineBenchmark.h"
+#include "CSyntheticBody.h"
+#include "CKeypointTraceReplay.h"
+#include "CDriverSettings.h"
+#include "CNvSDKInterface.h"
+#include "CVirtualBodyTracker.h"
+#include "CVirtualBaseStation.h"
+#include "CTrackerBank.h"
+#include "CPosePublisher.h"
+#include "CCameraDriver.h"
+#include "CSessionRecorder.h"
+#include "CDriverTestAccess.h"
+#include "CCommon.h"
+
+//  Counted by the global operator new in main.cpp
+extern std::atomic<uint64_t> g_allocations;
+
+//  Stages reported, in pipeline order, by the names of their trace spans
+static const char *const s_stageNames[] = {
+    "Upload",
+    "Inference",
+    "Fill",
+    "Align",
+    "Rotations",
+    "Tracker update",
+    "Publish",
+    "Submit"
+};
+
+BenchmarkOptions::BenchmarkOptions()
+{
+    frames = 3000u;
+    warmup = 60u;
+    cameraFps = 30.0;
+    displayHz = 90.0;
+    width = 640;
+    height = 480;
+    //  The trackers settings.ini enables out of the box
+    trackers = TRACKING_FLAG::HIP | TRACKING_FLAG::FEET | TRACKING_FLAG::ELBOW | TRACKING_FLAG::KNEE | TRACKING_FLAG::CHEST;
+    batches = 2;
+    interpolation = INTERP_MODE::LINEAR;
+    frameCache = 2;
+    prediction = false;
+    noise = .005f;
+    seed = 1u;
+    lag = 0.0;
+    replayPath = nullptr;
+    replaySpeed = 1.0;
+    recordPath = nullptr;
+    recordEncoded = false;
+    json = false;
+    verbose = false;
+    tracePath = nullptr;
+}
+
+CPipelineBenchmark::CPipelineBenchmark(const BenchmarkOptions &options) : m_options(options), m_host(options.verbose)
+{
+    vr::InitServerDriverContext(&m_host);
+    m_replay = nullptr;
+    m_cameraAllocations = 0u;
+    m_displayAllocations = 0u;
+}
+
+bool CPipelineBenchmark::Setup()
+{
+    CServerDriver &driv = m_driver;
+
+    glm::vec3 cameraPosition = CSyntheticBody::c_camera;
+    glm::quat cameraRotation(1.f, 0.f, 0.f, 0.f);
+    if (m_options.replayPath != nullptr)
+    {
+        m_replay = new CKeypointTraceReplay(m_options.replaySpeed);
+        m_source.reset(m_replay);
+        if (!m_replay->Open(m_options.replayPath))
+            return false;
+        size_t count = m_replay->GetFrameCount();
+        if (count <= m_options.warmup)
+        {
+            fprintf(stderr, "The trace holds %llu frames, no more than the %u warmup frames\n", (unsigned long long)count, m_options.warmup);
+            return false;
+        }
+        //  At most as long as the trace, and the recorded rate, batches, camera and image take over from the options
+        m_options.frames = (std::min)(m_options.frames, (unsigned)(count - m_options.warmup));
+        double duration = m_replay->GetFrameTime(count - 1u);
+        if (duration > 0.0)
+            m_options.cameraFps = (double)(count - 1u) / duration;
+        m_options.batches = (int)m_replay->GetBatches();
+        m_replay->GetCamera(cameraPosition, cameraRotation);
+        int width, height;
+        m_replay->GetImageSize(width, height);
+        if (width > 0 && height > 0)
+        {
+            m_options.width = width;
+            m_options.height = height;
+        }
+    }
+    else
+        m_source.reset(new CSyntheticBody(CSyntheticBody::c_camera, m_options.noise, m_options.seed, m_options.lag));
+
+    //  Every span of the run has to fit, about a dozen per camera frame plus two per display frame
+    double displayPerCamera = m_options.displayHz / m_options.cameraFps;
+    driv.GetTrace().Enable((size_t)((m_options.frames + m_options.warmup) * (16.0 + 2.0 * displayPerCamera)));
+
+    CDriverTestAccess::TrackingMode(driv) = m_options.trackers;
+    CDriverTestAccess::Interpolation(driv) = m_options.interpolation;
+    CDriverTestAccess::FrameCacheSize(driv) = m_options.frameCache;
+    CDriverTestAccess::CacheImmediate(driv) = false;
+    CDriverTestAccess::PosePrediction(driv) = m_options.prediction;
+    //  The proportions settings.ini ships with
+    CDriverTestAccess::BodyProportions(driv) = new Proportions(0.f, -.3f, -.1f, 0.f, .4f);
+    CDriverTestAccess::TrackerBank(driv) = new CTrackerBank(m_options.frameCache, m_options.prediction ? INTERP_MODE::NONE : m_options.interpolation, false);
+    CDriverTestAccess::PoseSnapshots(driv) = new CSnapshotBuffer<PoseSnapshot>();
+    SubmitPolicy &policy = CDriverTestAccess::Policy(driv);
+    policy.positionEpsilon = .0005f;
+    policy.rotationEpsilon = glm::radians(.05f);
+    policy.keepAlive = 1.0;
+
+    CReplayBackend::Instance().SetSource(m_source.get());
+    CNvSDKInterface *inter = new CNvSDKInterface();
+    CDriverTestAccess::NvInterface(driv) = inter;
+    inter->driver = &driv;
+    inter->batchSize = 1;
+    inter->realBatches = m_options.batches;
+    inter->confidenceRequirement = .01f;
+    inter->trackingActive = true;
+    //  Unrotated, and the axis scale stays at one: the replayed keypoints are already in meters
+    inter->SetCamera(cameraPosition, cameraRotation);
+    inter->Initialize(m_options.width, m_options.height);
+    inter->KeyInfoUpdated(true);
+    inter->ready = true;
+    if (m_options.recordPath != nullptr)
+    {
+        //  No recorder thread either, the queue is drained after every camera frame
+        CSessionRecorder *recorder = new CSessionRecorder();
+        CDriverTestAccess::Recorder(driv) = recorder;
+        if (!recorder->OpenKeypoints(m_options.recordPath, (uint32_t)m_options.batches, inter->focalLength, m_options.recordEncoded))
+        {
+            fprintf(stderr, "Unable to create the keypoint trace %s.bin\n", m_options.recordPath);
+            return false;
+        }
+    }
+
+    //  No capture device is opened, frames are injected
+    CDriverTestAccess::Camera(driv) = new CCameraDriver(&driv);
+    m_image = cv::Mat(m_options.height, m_options.width, CV_8UC3, cv::Scalar(64, 64, 64));
+
+    CVirtualBaseStation *station = new CVirtualBaseStation(&driv);
+    CDriverTestAccess::Station(driv) = station;
+    station->SetSubmitPolicy(policy);
+    vr::VRServerDriverHost()->TrackedDeviceAdded(station->GetSerial().c_str(), vr::ETrackedDeviceClass::TrackedDeviceClass_TrackingReference, station);
+
+    CDriverTestAccess::SetupTracker(driv, KEY_HIP_ON, TRACKING_FLAG::HIP, TRACKER_ROLE::HIPS);
+    CDriverTestAccess::SetupTracker(driv, KEY_FEET_ON, TRACKING_FLAG::FEET, TRACKER_ROLE::LEFT_FOOT, TRACKER_ROLE::RIGHT_FOOT);
+    CDriverTestAccess::SetupTracker(driv, KEY_ELBOW_ON, TRACKING_FLAG::ELBOW, TRACKER_ROLE::LEFT_ELBOW, TRACKER_ROLE::RIGHT_ELBOW);
+    CDriverTestAccess::SetupTracker(driv, KEY_KNEE_ON, TRACKING_FLAG::KNEE, TRACKER_ROLE::LEFT_KNEE, TRACKER_ROLE::RIGHT_KNEE);
+    CDriverTestAccess::SetupTracker(driv, KEY_CHEST_ON, TRACKING_FLAG::CHEST, TRACKER_ROLE::CHEST);
+    CDriverTestAccess::SetupTracker(driv, KEY_SHOULDER_ON, TRACKING_FLAG::SHOULDER, TRACKER_ROLE::LEFT_SHOULDER, TRACKER_ROLE::RIGHT_SHOULDER);
+    CDriverTestAccess::SetupTracker(driv, KEY_TOE_ON, TRACKING_FLAG::TOE, TRACKER_ROLE::LEFT_TOE, TRACKER_ROLE::RIGHT_TOE);
+    CDriverTestAccess::SetupTracker(driv, KEY_HEAD_ON, TRACKING_FLAG::HEAD, TRACKER_ROLE::HEAD);
+    CDriverTestAccess::SetupTracker(driv, KEY_HAND_ON, TRACKING_FLAG::HAND, TRACKER_ROLE::LEFT_HAND, TRACKER_ROLE::RIGHT_HAND);
+
+    //  Never started, Publish is called directly on the simulated display clock
+    CDriverTestAccess::Publisher(driv) = new CPosePublisher(&driv);
+
+    m_outputs.assign(CDriverTestAccess::Trackers(driv).size(), std::vector<glm::vec3>());
+    for (auto &output : m_outputs)
+        output.reserve((size_t)(m_options.frames * displayPerCamera) + 1u);
+    m_cameraTimes.reserve(m_options.frames);
+    m_displayTimes.reserve((size_t)(m_options.frames * displayPerCamera) + 1u);
+    return true;
+}
+
+double CPipelineBenchmark::CameraTime(unsigned frame) const
+{
+    return m_replay != nullptr ? m_replay->GetFrameTime(frame) : frame / m_options.cameraFps;
+}
+
+void CPipelineBenchmark::CameraFrame(double time, bool measured)
+{
+    CReplayBackend::Instance().Advance(time);
+
+    uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+    int64_t start = LatencyNow();
+    CCameraDriver &camera = *CDriverTestAccess::Camera(m_driver);
+    camera.InjectFrame(m_image, time);
+    m_driver.DoImageUpdate(camera, time);
+    int64_t end = LatencyNow();
+    if (CSessionRecorder *recorder = CDriverTestAccess::Recorder(m_driver))
+        recorder->Drain();
+
+    if (!measured)
+        return;
+    m_cameraTimes.push_back(end - start);
+    m_cameraAllocations += g_allocations.load(std::memory_order_relaxed) - allocations;
+}
+
+void CPipelineBenchmark::DisplayFrame(double time, bool measured)
+{
+    //  What RunFrame would have published for the camera thread
+    DevicePoses &devices = CDriverTestAccess::DevicePoseBuffer(m_driver).Edit();
+    m_source->GetDevicePoses(time, devices);
+    devices.time = time;
+
+    uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+    int64_t start = LatencyNow();
+    CDriverTestAccess::DevicePoseBuffer(m_driver).Publish();
+    CDriverTestAccess::Publisher(m_driver)->Publish(time);
+    int64_t end = LatencyNow();
+
+    if (!measured)
+        return;
+    m_displayTimes.push_back(end - start);
+    m_displayAllocations += g_allocations.load(std::memory_order_relaxed) - allocations;
+
+    //  The station was added first, the trackers follow in order
+    for (size_t index = 0; index < m_outputs.size(); index++)
+    {
+        const vr::DriverPose_t &pose = m_host.GetPose(index + 1u);
+        if (pose.poseIsValid)
+            m_outputs[index].push_back(glm::vec3((float)pose.vecPosition[0], (float)pose.vecPosition[1], (float)pose.vecPosition[2]));
+    }
+}
+
+bool CPipelineBenchmark::Run()
+{
+    if (!Setup())
+        return false;
+
+    unsigned total = m_options.warmup + m_options.frames;
+    unsigned cameraFrame = 0u;
+    uint64_t displayFrame = 0u;
+    //  Both clocks start together, a camera frame goes first when they tie
+    while (cameraFrame < total)
+    {
+        double cameraTime = CameraTime(cameraFrame);
+        double displayTime = displayFrame / m_options.displayHz;
+        if (cameraTime <= displayTime)
+        {
+            CameraFrame(cameraTime, cameraFrame >= m_options.warmup);
+            cameraFrame++;
+        }
+        else
+        {
+            DisplayFrame(displayTime, cameraFrame > m_options.warmup);
+            displayFrame++;
+        }
+    }
+
+    Aggregate();
+    if (m_options.tracePath != nullptr)
+        m_driver.GetTrace().Export(m_options.tracePath);
+    return true;
+}
+
+static double Percentile(const std::vector<int64_t> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = (size_t)(fraction * (double)(sorted.size() - 1u) + .5);
+    return (double)sorted[(std::min)(index, sorted.size() - 1u)];
+}
+
+static StageResult Summarize(const char *name, std::vector<int64_t> values)
+{
+    StageResult result = { name, (uint64_t)values.size(), 0.0, 0.0, 0.0 };
+    if (values.empty())
+        return result;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (int64_t value : values)
+        sum += (double)value;
+    result.mean = sum / (double)values.size();
+    result.p50 = Percentile(values, .5);
+    result.p99 = Percentile(values, .99);
+    return result;
+}
+
+void CPipelineBenchmark::Aggregate()
+{
+    //  Spans of one stage and frame are added up (Inference runs once per batch), warmup frames are left out
+    std::vector<TraceSpan> spans = m_driver.GetTrace().Collect();
+    m_stages.clear();
+    for (const char *name : s_stageNames)
+    {
+        std::map<uint64_t, int64_t> frames;
+        for (auto &span : spans)
+        {
+            if (span.frame > m_options.warmup && !strcmp(span.name, name))
+                frames[span.frame] += span.duration;
+        }
+        std::vector<int64_t> values;
+        values.reserve(frames.size());
+        for (auto &frame : frames)
+            values.push_back(frame.second);
+        m_stages.push_back(Summarize(name, values));
+    }
+}
+
+void CPipelineBenchmark::ComputeJitter(double &mean, double &max) const
+{
+    mean = 0.0;
+    max = 0.0;
+    size_t counted = 0u;
+    for (auto &output : m_outputs)
+    {
+        if (output.size() < 3u)
+            continue;
+        double sum = 0.0;
+        for (size_t index = 2; index < output.size(); index++)
+        {
+            glm::vec3 acceleration = output[index] - 2.f * output[index - 1u] + output[index - 2u];
+            sum += (double)glm::dot(acceleration, acceleration);
+        }
+        double rms = sqrt(sum / (double)(output.size() - 2u)) * 1000.0;
+        mean += rms;
+        max = (std::max)(max, rms);
+        counted++;
+    }
+    if (counted > 0u)
+        mean /= (double)counted;
+}
+
+void CPipelineBenchmark::Report(FILE *out) const
+{
+    StageResult camera = Summarize("Camera frame", m_cameraTimes);
+    StageResult display = Summarize("Display frame", m_displayTimes);
+    double cameraAllocations = m_cameraTimes.empty() ? 0.0 : (double)m_cameraAllocations / (double)m_cameraTimes.size();
+    double displayAllocations = m_displayTimes.empty() ? 0.0 : (double)m_displayAllocations / (double)m_displayTimes.size();
+    double jitterMean, jitterMax;
+    ComputeJitter(jitterMean, jitterMax);
+
+    const CMotionLatency &motion = CDriverTestAccess::NvInterface(m_driver)->motionLatency;
+    const CVirtualBaseStation *station = CDriverTestAccess::Station(m_driver);
+    uint64_t submitted = station->GetSubmitCount(), skipped = station->GetSkipCount();
+    for (auto tracker : CDriverTestAccess::Trackers(m_driver))
+    {
+        submitted += tracker->GetSubmitCount();
+        skipped += tracker->GetSkipCount();
+    }
+
+    if (m_options.json)
+    {
+        fprintf(out, "{\n  \"config\": {");
+        fprintf(out, "\"frames\": %u, \"warmup\": %u, \"camera_fps\": %.3f, \"display_hz\": %.3f, ", m_options.frames, m_options.warmup, m_options.cameraFps, m_options.displayHz);
+        fprintf(out, "\"width\": %d, \"height\": %d, \"trackers\": %u, \"batches\": %d, ", m_options.width, m_options.height, (unsigned)CDriverTestAccess::Trackers(m_driver).size(), m_options.batches);
+        fprintf(out, "\"interpolation\": \"%s\", \"frame_cache\": %d, \"prediction\": %s, ", InterpModeName[(int)m_options.interpolation], m_options.frameCache, m_options.prediction ? "true" : "false");
+        fprintf(out, "\"noise_m\": %.6f, \"seed\": %u, \"lag_s\": %.6f, ", m_options.noise, m_options.seed, m_options.lag);
+        fprintf(out, "\"replay\": %s, \"replay_speed\": %.3f},\n", m_replay != nullptr ? "true" : "false", m_options.replaySpeed);
+        fprintf(out, "  \"stages\": [\n");
+        for (size_t index = 0; index < m_stages.size(); index++)
+        {
+            const StageResult &stage = m_stages[index];
+            fprintf(
+                out,
+                "    {\"name\": \"%s\", \"frames\": %llu, \"mean_ns\": %.0f, \"p50_ns\": %.0f, \"p99_ns\": %.0f}%s\n",
+                stage.name, (unsigned long long)stage.frames, stage.mean, stage.p50, stage.p99,
+                index + 1u < m_stages.size() ? "," : ""
+            );
+        }
+        fprintf(out, "  ],\n");
+        fprintf(out, "  \"camera_frame\": {\"frames\": %llu, \"mean_ns\": %.0f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"allocations\": %.2f},\n",
+            (unsigned long long)camera.frames, camera.mean, camera.p50, camera.p99, cameraAllocations);
+        fprintf(out, "  \"display_frame\": {\"frames\": %llu, \"mean_ns\": %.0f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"allocations\": %.2f},\n",
+            (unsigned long long)display.frames, display.mean, display.p50, display.p99, displayAllocations);
+        fprintf(out, "  \"jitter_mm\": {\"mean\": %.4f, \"max\": %.4f},\n", jitterMean, jitterMax);
+        fprintf(out, "  \"motion_latency\": {\"valid\": %s, \"latency_s\": %.6f, \"correlation\": %.4f},\n",
+            motion.HasEstimate() ? "true" : "false", motion.GetLatency(), motion.GetCorrelation());
+        fprintf(out, "  \"poses\": {\"submitted\": %llu, \"skipped\": %llu}\n}\n", (unsigned long long)submitted, (unsigned long long)skipped);
+        return;
+    }
+
+    if (m_replay != nullptr)
+        fprintf(out, "Replaying %s at %.2fx\n", m_options.replayPath, m_options.replaySpeed);
+    fprintf(out, "%u camera frames at %.1f fps (after %u warmup), display at %.1f Hz, %dx%d image\n",
+        m_options.frames, m_options.cameraFps, m_options.warmup, m_options.displayHz, m_options.width, m_options.height);
+    fprintf(out, "%u trackers, %d batches, %s interpolation over %d frames, prediction %s, noise %.1f mm\n\n",
+        (unsigned)CDriverTestAccess::Trackers(m_driver).size(), m_options.batches, InterpModeName[(int)m_options.interpolation], m_options.frameCache,
+        m_options.prediction ? "on" : "off", m_options.noise * 1000.f);
+    fprintf(out, "%-16s %10s %10s %10s\n", "Stage (ns/frame)", "mean", "p50", "p99");
+    for (auto &stage : m_stages)
+        fprintf(out, "%-16s %10.0f %10.0f %10.0f\n", stage.name, stage.mean, stage.p50, stage.p99);
+    fprintf(out, "\n%-16s %10.0f %10.0f %10.0f  %.2f allocations\n", "Camera frame", camera.mean, camera.p50, camera.p99, cameraAllocations);
+    fprintf(out, "%-16s %10.0f %10.0f %10.0f  %.2f allocations\n", "Display frame", display.mean, display.p50, display.p99, displayAllocations);
+    fprintf(out, "\nOutput jitter: %.4f mm mean, %.4f mm worst tracker\n", jitterMean, jitterMax);
+    fprintf(out, "Poses: %llu submitted, %llu skipped\n", (unsigned long long)submitted, (unsigned long long)skipped);
+    if (motion.HasEstimate())
+        fprintf(out, "Motion latency: %.1f ms (correlation %.2f, %.1f ms simulated)\n", motion.GetLatency() * 1000.0, motion.GetCorrelation(), m_options.lag * 1000.0);
+    else
+        fprintf(out, "Motion latency: no estimate\n");
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "CServerDriver.h"
+#include "CBenchmarkHost.h"
+#include "CReplayBackend.h"
+
+class CKeypointTraceReplay;
+
+enum class TRACKING_FLAG;
+enum class INTERP_MODE;
+
+//  Everything a run can be configured with, see main.cpp for the command line
+struct BenchmarkOptions
+{
+    //  Camera frames measured, after the warmup frames
+    unsigned frames;
+    unsigned warmup;
+    //  Rates of the simulated camera and display clocks
+    double cameraFps;
+    double displayHz;
+    int width;
+    int height;
+
+    TRACKING_FLAG trackers;
+    int batches;
+    INTERP_MODE interpolation;
+    int frameCache;
+    bool prediction;
+
+    //  Keypoint noise of the synthetic body (meters), and its seed
+    float noise;
+    uint32_t seed;
+    //  How far the synthetic keypoints trail the devices (seconds), for checking the motion latency estimate
+    double lag;
+    //  Keypoint trace to replay instead of the synthetic body, nullptr for none, and how much faster than recorded
+    const char *replayPath;
+    double replaySpeed;
+    //  Keypoint trace the driver records during the run (.bin is appended), nullptr for none
+    const char *recordPath;
+    //  Record it as pose packets rather than raw SDK output
+    bool recordEncoded;
+
+    bool json;
+    bool verbose;
+    //  Chrome trace of the whole run, nullptr for none
+    const char *tracePath;
+
+    BenchmarkOptions();
+};
+
+//  Time spent per frame in one stage, from the trace spans of the measured frames (nanoseconds)
+struct StageResult
+{
+    const char *name;
+    uint64_t frames;
+    double mean;
+    double p50;
+    double p99;
+};
+
+//  Runs the pipeline the way the camera and publisher threads do, minus the threads: camera frames and display
+//  frames are interleaved on a simulated clock, so a run is repeatable and only measures the work itself
+//  Inference is replaced by CReplayBackend, so the numbers are everything the driver adds around the SDK
+class CPipelineBenchmark
+{
+    BenchmarkOptions m_options;
+    //  Has to outlive the driver, which logs and clears the driver context when it is destroyed
+    CBenchmarkHost m_host;
+    CServerDriver m_driver;
+    std::unique_ptr<CKeypointSource> m_source;
+    //  m_source when replaying a keypoint trace
+    CKeypointTraceReplay *m_replay;
+    cv::Mat m_image;
+
+    //  Per measured frame, wall time of the whole camera / display frame (ns) and the allocations made during it
+    std::vector<int64_t> m_cameraTimes;
+    std::vector<int64_t> m_displayTimes;
+    uint64_t m_cameraAllocations;
+    uint64_t m_displayAllocations;
+    //  Positions every tracker showed in each measured display frame (meters), tracker major
+    std::vector<std::vector<glm::vec3>> m_outputs;
+
+    std::vector<StageResult> m_stages;
+
+    CPipelineBenchmark(const CPipelineBenchmark &that) = delete;
+    CPipelineBenchmark &operator=(const CPipelineBenchmark &that) = delete;
+
+    bool Setup();
+    //  When a camera frame is captured on the simulated clock
+    double CameraTime(unsigned frame) const;
+    void CameraFrame(double time, bool measured);
+    void DisplayFrame(double time, bool measured);
+    void Aggregate();
+
+    //  Root mean square of the second difference of each tracker's output (millimeters), and the worst tracker
+    void ComputeJitter(double &mean, double &max) const;
+public:
+    explicit CPipelineBenchmark(const BenchmarkOptions &options);
+
+    //  False when the run could not be set up
+    bool Run();
+    void Report(FILE *out) const;
+};
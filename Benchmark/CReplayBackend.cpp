@@ -0,0 +1,204 @@
+#include "pch.h"
+#include "CReplayBackend.h"
+
+//  Handles only have to be distinct from nullptr, the backend serves a single feature
+static char s_feature;
+static char s_stream;
+
+CReplayBackend::CReplayBackend()
+{
+    m_source = nullptr;
+    memset(&m_frame, 0, sizeof(m_frame));
+    m_time = 0.0;
+    m_run = 0;
+    memset(m_referencePose, 0, sizeof(m_referencePose));
+    m_keypoints = nullptr;
+    m_keypoints3D = nullptr;
+    m_jointAngles = nullptr;
+    m_confidence = nullptr;
+    m_boxes = nullptr;
+    m_runs = 0u;
+    m_transfers = 0u;
+}
+
+CReplayBackend &CReplayBackend::Instance()
+{
+    static CReplayBackend backend;
+    return backend;
+}
+
+void CReplayBackend::SetSource(CKeypointSource *source)
+{
+    m_source = source;
+    if (m_source != nullptr && m_source->Sample(0.0, 0, m_frame))
+        memcpy(m_referencePose, m_frame.keypoints3D, sizeof(m_referencePose));
+}
+
+bool CReplayBackend::Advance(double time)
+{
+    m_time = time;
+    m_run = 0;
+    return m_source != nullptr && m_source->Sample(time, 0, m_frame);
+}
+
+void CReplayBackend::SetOutput(const char *name, void *ptr)
+{
+    if (!strcmp(name, NvAR_Parameter_Output(KeyPoints)))
+        m_keypoints = (NvAR_Point2f *)ptr;
+    else if (!strcmp(name, NvAR_Parameter_Output(KeyPoints3D)))
+        m_keypoints3D = (NvAR_Point3f *)ptr;
+    else if (!strcmp(name, NvAR_Parameter_Output(JointAngles)))
+        m_jointAngles = (NvAR_Quaternion *)ptr;
+    else if (!strcmp(name, NvAR_Parameter_Output(KeyPointsConfidence)))
+        m_confidence = (float *)ptr;
+    else if (!strcmp(name, NvAR_Parameter_Output(BoundingBoxes)))
+        m_boxes = (NvAR_BBoxes *)ptr;
+}
+
+void CReplayBackend::Run()
+{
+    //  The first run uses the sample Advance took, later runs of the same frame get their own
+    if (m_run > 0 && m_source != nullptr)
+        m_source->Sample(m_time, m_run, m_frame);
+    m_run++;
+
+    //  The driver rotates earlier batches out of entry 0 before every run, like the real feature it only writes that one
+    if (m_keypoints != nullptr)
+        memcpy(m_keypoints, m_frame.keypoints, sizeof(m_frame.keypoints));
+    if (m_keypoints3D != nullptr)
+        memcpy(m_keypoints3D, m_frame.keypoints3D, sizeof(m_frame.keypoints3D));
+    if (m_jointAngles != nullptr)
+        memcpy(m_jointAngles, m_frame.jointAngles, sizeof(m_frame.jointAngles));
+    if (m_confidence != nullptr)
+        memcpy(m_confidence, m_frame.confidence, sizeof(m_frame.confidence));
+    if (m_boxes != nullptr && m_boxes->boxes != nullptr && m_boxes->max_boxes > 0u)
+    {
+        m_boxes->boxes[0] = m_frame.bbox;
+        m_boxes->num_boxes = 1u;
+    }
+    m_runs++;
+}
+
+NvCV_Status NvAR_Create(NvAR_FeatureID featureID, NvAR_FeatureHandle *handle)
+{
+    *handle = (NvAR_FeatureHandle)&s_feature;
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_Load(NvAR_FeatureHandle handle)
+{
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_Run(NvAR_FeatureHandle handle)
+{
+    CReplayBackend::Instance().Run();
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_Destroy(NvAR_FeatureHandle handle)
+{
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_CudaStreamCreate(CUstream *stream)
+{
+    *stream = (CUstream)&s_stream;
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_CudaStreamDestroy(CUstream stream)
+{
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_SetU32(NvAR_FeatureHandle handle, const char *name, unsigned int val)
+{
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_SetF32(NvAR_FeatureHandle handle, const char *name, float val)
+{
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_SetString(NvAR_FeatureHandle handle, const char *name, const char *str)
+{
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_SetCudaStream(NvAR_FeatureHandle handle, const char *name, CUstream stream)
+{
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_SetObject(NvAR_FeatureHandle handle, const char *name, void *ptr, unsigned long typeSize)
+{
+    CReplayBackend::Instance().SetOutput(name, ptr);
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_SetF32Array(NvAR_FeatureHandle handle, const char *name, float *val, int count)
+{
+    if (count < (int)BODY_JOINT_COUNT)
+        return NVCV_ERR_PARAMETER;
+    CReplayBackend::Instance().SetOutput(name, val);
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_GetU32(NvAR_FeatureHandle handle, const char *name, unsigned int *val)
+{
+    if (strcmp(name, NvAR_Parameter_Config(NumKeyPoints)))
+        return NVCV_ERR_PARAMETER;
+    *val = (unsigned int)BODY_JOINT_COUNT;
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvAR_GetObject(NvAR_FeatureHandle handle, const char *name, const void **ptr, unsigned long typeSize)
+{
+    if (strcmp(name, NvAR_Parameter_Config(ReferencePose)))
+        return NVCV_ERR_PARAMETER;
+    *ptr = CReplayBackend::Instance().GetReferencePose();
+    return NVCV_SUCCESS;
+}
+
+NvCV_Status NvCVImage_Alloc(NvCVImage *im, unsigned width, unsigned height, NvCVImage_PixelFormat format,
+    NvCVImage_ComponentType type, unsigned layout, unsigned memSpace, unsigned alignment)
+{
+    unsigned char components = format == NVCV_BGRA || format == NVCV_RGBA ? 4u : format == NVCV_Y ? 1u : 3u;
+    im->width = width;
+    im->height = height;
+    im->pitch = (int)(width * components);
+    im->pixelFormat = format;
+    im->componentType = type;
+    im->pixelBytes = components;
+    im->componentBytes = 1u;
+    im->numComponents = components;
+    im->planar = (unsigned char)layout;
+    im->gpuMem = (unsigned char)memSpace;
+    im->bufferBytes = (unsigned long long)im->pitch * height;
+    im->pixels = new unsigned char[(size_t)im->bufferBytes];
+    im->deletePtr = im->pixels;
+    return NVCV_SUCCESS;
+}
+
+void NvCVImage_Dealloc(NvCVImage *im)
+{
+    delete[] (unsigned char *)im->deletePtr;
+    im->pixels = nullptr;
+    im->deletePtr = nullptr;
+    im->bufferBytes = 0u;
+}
+
+NvCV_Status NvCVImage_Transfer(const NvCVImage *src, NvCVImage *dst, float scale, CUstream stream, NvCVImage *tmp)
+{
+    if (src->pixels == nullptr || dst->pixels == nullptr)
+        return NVCV_ERR_PARAMETER;
+    //  Row by row, the source is a cv::Mat that may be padded
+    unsigned rows = (std::min)(src->height, dst->height);
+    size_t row = (size_t)(std::min)(src->width * src->pixelBytes, dst->width * dst->pixelBytes);
+    for (unsigned y = 0; y < rows; y++)
+        memcpy((unsigned char *)dst->pixels + (size_t)y * dst->pitch, (const unsigned char *)src->pixels + (size_t)y * src->pitch, row);
+    CReplayBackend::Instance().CountTransfer();
+    return NVCV_SUCCESS;
+}
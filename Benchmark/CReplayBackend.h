@@ -0,0 +1,71 @@
+#pragma once
+#include "CCommon.h"
+
+struct DevicePoses;
+
+//  Everything body pose estimation reports for one batch entry
+struct KeypointFrame
+{
+    NvAR_Point2f keypoints[BODY_JOINT_COUNT];
+    NvAR_Point3f keypoints3D[BODY_JOINT_COUNT];
+    NvAR_Quaternion jointAngles[BODY_JOINT_COUNT];
+    float confidence[BODY_JOINT_COUNT];
+    NvAR_Rect bbox;
+};
+
+//  Where the replayed body pose estimation takes its output from
+class CKeypointSource
+{
+public:
+    virtual ~CKeypointSource() {}
+
+    //  Fill in the body seen at the given time (seconds since the start of the run) by one of the frame's inference runs,
+    //  false once the source ran out. Runs count up from 0, sources that do not tell runs apart may ignore it
+    virtual bool Sample(double time, int run, KeypointFrame &frame) = 0;
+    //  The HMD and controllers at the same time, as SteamVR hands them to RunFrame
+    virtual void GetDevicePoses(double time, DevicePoses &devices) = 0;
+};
+
+//  Stands in for the NVIDIA AR SDK in the benchmark: the NvAR_* / NvCVImage_* functions the driver calls are
+//  implemented on top of it, and NvAR_Run copies the current keypoint frame into the registered outputs instead
+//  of running a model. Images are host memory and transfers plain copies, so the upload still costs a memcpy
+//  Only touched from the thread driving the pipeline, like the SDK on the camera thread
+class CReplayBackend
+{
+    CKeypointSource *m_source;
+    KeypointFrame m_frame;
+    //  Time of the current camera frame, and the inference runs made on it so far
+    double m_time;
+    int m_run;
+    NvAR_Point3f m_referencePose[BODY_JOINT_COUNT];
+
+    //  Outputs registered with NvAR_SetObject / NvAR_SetF32Array, batch entry 0 is written by every run
+    NvAR_Point2f *m_keypoints;
+    NvAR_Point3f *m_keypoints3D;
+    NvAR_Quaternion *m_jointAngles;
+    float *m_confidence;
+    NvAR_BBoxes *m_boxes;
+
+    uint64_t m_runs;
+    uint64_t m_transfers;
+
+    CReplayBackend();
+    CReplayBackend(const CReplayBackend &that) = delete;
+    CReplayBackend &operator=(const CReplayBackend &that) = delete;
+public:
+    static CReplayBackend &Instance();
+
+    //  The source is not owned, its first sample also serves as the reference pose
+    void SetSource(CKeypointSource *source);
+    //  Move on to the camera frame at the given time, each NvAR_Run until the next call samples another run of it
+    bool Advance(double time);
+
+    void SetOutput(const char *name, void *ptr);
+    void Run();
+    inline void CountTransfer() { m_transfers++; }
+
+    inline const NvAR_Point3f *GetReferencePose() const { return m_referencePose; }
+    inline const KeypointFrame &GetFrame() const { return m_frame; }
+    inline uint64_t GetRuns() const { return m_runs; }
+    inline uint64_t GetTransfers() const { return m_transfers; }
+};
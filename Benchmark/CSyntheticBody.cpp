@@ -0,0 +1,205 @@
+#include "pch.h"
+#include "CSyntheticBody.h"
+#include "CServerDriver.h"
+
+//  Standing pose, indexed by BODY_JOINT (meters, the person's left is +x)
+static const glm::vec3 s_restPose[BODY_JOINT_COUNT] = {
+    { 0.f, .95f, 0.f },         //  Pelvis
+    { .10f, .92f, 0.f },        //  Left hip
+    { -.10f, .92f, 0.f },       //  Right hip
+    { 0.f, 1.25f, 0.f },        //  Torso
+    { .10f, .50f, .04f },       //  Left knee
+    { -.10f, .50f, .04f },      //  Right knee
+    { 0.f, 1.50f, 0.f },        //  Neck
+    { .10f, .08f, 0.f },        //  Left ankle
+    { -.10f, .08f, 0.f },       //  Right ankle
+    { .08f, .02f, .17f },       //  Left big toe
+    { -.08f, .02f, .17f },      //  Right big toe
+    { .14f, .02f, .15f },       //  Left small toe
+    { -.14f, .02f, .15f },      //  Right small toe
+    { .10f, .02f, -.06f },      //  Left heel
+    { -.10f, .02f, -.06f },     //  Right heel
+    { 0.f, 1.63f, .10f },       //  Nose
+    { .03f, 1.66f, .08f },      //  Left eye
+    { -.03f, 1.66f, .08f },     //  Right eye
+    { .07f, 1.64f, 0.f },       //  Left ear
+    { -.07f, 1.64f, 0.f },      //  Right ear
+    { .19f, 1.45f, 0.f },       //  Left shoulder
+    { -.19f, 1.45f, 0.f },      //  Right shoulder
+    { .22f, 1.17f, -.02f },     //  Left elbow
+    { -.22f, 1.17f, -.02f },    //  Right elbow
+    { .22f, 1.02f, .20f },      //  Left wrist
+    { -.22f, 1.02f, .20f },     //  Right wrist
+    { .24f, .98f, .26f },       //  Left pinky knuckle
+    { -.24f, .98f, .26f },      //  Right pinky knuckle
+    { .22f, .96f, .32f },       //  Left middle tip
+    { -.22f, .96f, .32f },      //  Right middle tip
+    { .20f, .99f, .27f },       //  Left index knuckle
+    { -.20f, .99f, .27f },      //  Right index knuckle
+    { .18f, 1.f, .28f },        //  Left thumb tip
+    { -.18f, 1.f, .28f }        //  Right thumb tip
+};
+
+//  Focal length and image center the 2D keypoints are projected with (pixels)
+#define SYNTHETIC_FOCAL 800.f
+#define SYNTHETIC_CENTER_X 320.f
+#define SYNTHETIC_CENTER_Y 240.f
+
+const glm::vec3 CSyntheticBody::c_camera = glm::vec3(0.f, 1.f, 2.5f);
+
+enum class BODY_SIDE
+{
+    CENTER,
+    LEFT,
+    RIGHT
+};
+
+enum class BODY_PART
+{
+    TRUNK,
+    KNEE,
+    FOOT,
+    ELBOW,
+    HAND
+};
+
+static BODY_SIDE SideOf(BODY_JOINT joint)
+{
+    float x = s_restPose[(int)joint].x;
+    return x > 0.f ? BODY_SIDE::LEFT : x < 0.f ? BODY_SIDE::RIGHT : BODY_SIDE::CENTER;
+}
+
+static BODY_PART PartOf(BODY_JOINT joint)
+{
+    switch (joint)
+    {
+    case BODY_JOINT::LEFT_KNEE:
+    case BODY_JOINT::RIGHT_KNEE:
+        return BODY_PART::KNEE;
+    case BODY_JOINT::LEFT_ANKLE:
+    case BODY_JOINT::RIGHT_ANKLE:
+    case BODY_JOINT::LEFT_BIG_TOE:
+    case BODY_JOINT::RIGHT_BIG_TOE:
+    case BODY_JOINT::LEFT_SMALL_TOE:
+    case BODY_JOINT::RIGHT_SMALL_TOE:
+    case BODY_JOINT::LEFT_HEEL:
+    case BODY_JOINT::RIGHT_HEEL:
+        return BODY_PART::FOOT;
+    case BODY_JOINT::LEFT_ELBOW:
+    case BODY_JOINT::RIGHT_ELBOW:
+        return BODY_PART::ELBOW;
+    default:
+        return (int)joint >= (int)BODY_JOINT::LEFT_WRIST ? BODY_PART::HAND : BODY_PART::TRUNK;
+    }
+}
+
+CSyntheticBody::CSyntheticBody(const glm::vec3 &camera, float noise, uint32_t seed, double lag) : m_random(seed)
+{
+    m_camera = camera;
+    m_noise = noise;
+    m_lag = lag;
+    m_spare = 0.f;
+    m_hasSpare = false;
+}
+
+float CSyntheticBody::Gaussian()
+{
+    if (m_hasSpare)
+    {
+        m_hasSpare = false;
+        return m_spare;
+    }
+    //  Uniform in (0, 1) straight from the generator's 32 bits, the standard distributions differ between libraries
+    double u1 = ((double)m_random() + .5) / 4294967296.0;
+    double u2 = ((double)m_random() + .5) / 4294967296.0;
+    double radius = sqrt(-2.0 * log(u1));
+    m_spare = (float)(radius * sin(2.0 * M_PI * u2));
+    m_hasSpare = true;
+    return (float)(radius * cos(2.0 * M_PI * u2));
+}
+
+glm::vec3 CSyntheticBody::Joint(BODY_JOINT joint, double time) const
+{
+    glm::vec3 position = s_restPose[(int)joint];
+    float step = (float)sin(M_PI * SYNTHETIC_STEP_RATE * time);
+    //  Each leg is lifted on alternate steps, the arms swing against the legs
+    float lift = 0.f;
+    if (SideOf(joint) == BODY_SIDE::LEFT)
+        lift = (std::max)(step, 0.f) * .15f;
+    else if (SideOf(joint) == BODY_SIDE::RIGHT)
+        lift = (std::max)(-step, 0.f) * .15f;
+    float swing = (SideOf(joint) == BODY_SIDE::LEFT ? -step : step) * .06f;
+
+    switch (PartOf(joint))
+    {
+    case BODY_PART::KNEE:
+        position += glm::vec3(0.f, lift, lift * .8f);
+        break;
+    case BODY_PART::FOOT:
+        position += glm::vec3(0.f, lift * .7f, lift * .3f);
+        break;
+    case BODY_PART::ELBOW:
+        position.z += swing * .5f;
+        break;
+    case BODY_PART::HAND:
+        position.z += swing;
+        break;
+    default:
+        break;
+    }
+    //  The whole body sways over the stance leg
+    position.x += step * .015f;
+    return position;
+}
+
+bool CSyntheticBody::Sample(double time, int run, KeypointFrame &frame)
+{
+    float left = std::numeric_limits<float>::max(), top = left, right = -left, bottom = -left;
+    for (size_t index = 0; index < BODY_JOINT_COUNT; index++)
+    {
+        glm::vec3 position = Joint((BODY_JOINT)index, time - m_lag) - m_camera;
+        position += glm::vec3(Gaussian(), Gaussian(), Gaussian()) * m_noise;
+        frame.keypoints3D[index] = { position.x, position.y, position.z };
+
+        float depth = (std::max)(-position.z, .1f);
+        NvAR_Point2f &point = frame.keypoints[index];
+        point.x = SYNTHETIC_CENTER_X + SYNTHETIC_FOCAL * position.x / depth;
+        point.y = SYNTHETIC_CENTER_Y - SYNTHETIC_FOCAL * position.y / depth;
+        left = (std::min)(left, point.x);
+        right = (std::max)(right, point.x);
+        top = (std::min)(top, point.y);
+        bottom = (std::max)(bottom, point.y);
+
+        //  The driver derives its own rotations, the SDK's joint angles are passed through untouched
+        //  They only get noise (radians) so every inference run of a frame reports something of its own
+        glm::quat angle = glm::normalize(glm::quat(1.f, Gaussian() * m_noise, Gaussian() * m_noise, Gaussian() * m_noise));
+        frame.jointAngles[index] = { angle.x, angle.y, angle.z, angle.w };
+        frame.confidence[index] = SYNTHETIC_CONFIDENCE - std::fabs(Gaussian()) * m_noise;
+    }
+    frame.bbox = { left, top, right - left, bottom - top };
+    return true;
+}
+
+static void SetDevicePose(vr::TrackedDevicePose_t &pose, const glm::vec3 &position)
+{
+    memset(&pose, 0, sizeof(pose));
+    for (int row = 0; row < 3; row++)
+        pose.mDeviceToAbsoluteTracking.m[row][row] = 1.f;
+    pose.mDeviceToAbsoluteTracking.m[0][3] = position.x;
+    pose.mDeviceToAbsoluteTracking.m[1][3] = position.y;
+    pose.mDeviceToAbsoluteTracking.m[2][3] = position.z;
+    pose.eTrackingResult = vr::TrackingResult_Running_OK;
+    pose.bPoseIsValid = true;
+    pose.bDeviceIsConnected = true;
+}
+
+void CSyntheticBody::GetDevicePoses(double time, DevicePoses &devices)
+{
+    //  Half way from the ears toward the eyes, where AlignToHMD puts the headset on the skeleton
+    glm::vec3 ears = glm::mix(Joint(BODY_JOINT::LEFT_EAR, time), Joint(BODY_JOINT::RIGHT_EAR, time), .5f);
+    glm::vec3 eyes = glm::mix(Joint(BODY_JOINT::LEFT_EYE, time), Joint(BODY_JOINT::RIGHT_EYE, time), .5f);
+    float reach = glm::distance(ears, Joint(BODY_JOINT::NOSE, time)) * .5f;
+    SetDevicePose(devices.poses[0], ears + glm::normalize(eyes - ears) * reach);
+    SetDevicePose(devices.poses[1], Joint(BODY_JOINT::LEFT_WRIST, time));
+    SetDevicePose(devices.poses[2], Joint(BODY_JOINT::RIGHT_WRIST, time));
+}
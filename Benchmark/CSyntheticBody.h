@@ -0,0 +1,39 @@
+#pragma once
+#include "CReplayBackend.h"
+#include <random>
+
+//  Steps per second of the walk in place
+#define SYNTHETIC_STEP_RATE 1.0
+//  Confidence reported for every joint, less the noise
+#define SYNTHETIC_CONFIDENCE 0.9f
+
+//  A person walking in place in front of the camera, with gaussian noise on every keypoint, joint angle and confidence
+//  Joints are generated in world space (meters, y up, facing the camera along +z) and reported relative to the camera,
+//  which the benchmark leaves unrotated and at unit axis scale. The noise comes from a seeded mt19937 and its own
+//  gaussian transform, so a seed gives the same run with any compiler
+class CSyntheticBody : public CKeypointSource
+{
+    glm::vec3 m_camera;
+    float m_noise;
+    double m_lag;
+    std::mt19937 m_random;
+    //  The second value of the last Box-Muller pair, if still unused
+    float m_spare;
+    bool m_hasSpare;
+
+    float Gaussian();
+public:
+    //  Where the benchmarks put the camera, unrotated and looking along -z at the body
+    static const glm::vec3 c_camera;
+
+    //  Noise is the standard deviation per axis, in meters; keypoints show the body lag seconds before their frame time,
+    //  as a camera with that much delay would, while the devices are always on time
+    CSyntheticBody(const glm::vec3 &camera, float noise, uint32_t seed, double lag = 0.0);
+
+    //  Noise free position of a joint at the given time, in world space
+    glm::vec3 Joint(BODY_JOINT joint, double time) const;
+
+    bool Sample(double time, int run, KeypointFrame &frame) override;
+    //  The HMD on the head and the controllers in the hands, without noise
+    void GetDevicePoses(double time, DevicePoses &devices) override;
+};
@@ -0,0 +1,275 @@
+//  Drives the calibration hotkeys through a CScriptedKeySource and CServerDriver::DoRunFrame, and checks what
+//  each binding did to the driver. Run by ctest, exits non-zero when any binding misbehaved
+//
+//    ./build-benchmark/hotkey_test
+#include "pch.h"
+#include "CBenchmarkHost.h"
+#include "CServerDriver.h"
+#include "CDriverSettings.h"
+#include "CNvSDKInterface.h"
+#include "CPosePublisher.h"
+#include "CVirtualBaseStation.h"
+#include "CCameraDriver.h"
+#include "CKeySource.h"
+#include "CCommon.h"
+#include "CDriverTestAccess.h"
+#include "TestCheck.h"
+
+//  Simulated display rate the frames are run at
+#define HOTKEY_FRAME (1.0 / 90.0)
+//  Frames a held key is kept down for
+#define HOTKEY_HOLD 30
+//  How long the test waits for a trace export to be written (seconds)
+#define HOTKEY_EXPORT_TIMEOUT 5.0
+//  Fake capture devices, enough to step through a few of them
+#define HOTKEY_CAMERAS 3
+
+static bool Near(float value, float expected)
+{
+    return std::fabs(value - expected) <= 1e-4f * (std::max)(1.f, std::fabs(expected));
+}
+
+//  A driver with just enough of it set up for DoRunFrame: no camera is opened, no thread but an idle stand-in
+//  for the camera thread runs, and nothing is submitted to SteamVR
+class CHotkeyTest
+{
+    //  Has to outlive the driver, which logs and clears the driver context when it is destroyed
+    CBenchmarkHost m_host;
+    CServerDriver m_driver;
+    //  Owned by m_driver
+    CScriptedKeySource *m_keys;
+    double m_now;
+
+    CHotkeyTest(const CHotkeyTest &that) = delete;
+    CHotkeyTest &operator=(const CHotkeyTest &that) = delete;
+
+    void Frame();
+    void Frames(int count);
+    //  A press and release within one frame, then a frame for the binding to settle
+    void Tap(int key);
+    void Hold(int key, int frames);
+    void SwitchCamera(int key);
+public:
+    CHotkeyTest();
+
+    void TestCameraSwitch();
+    void TestScale();
+    void TestOffset();
+    void TestMirror();
+    void TestExportTrace(const std::string &directory);
+};
+
+CHotkeyTest::CHotkeyTest() : m_host(false)
+{
+    vr::InitServerDriverContext(&m_host);
+    CServerDriver &driv = m_driver;
+
+    driv.GetTrace().Enable(1024u);
+    CDriverTestAccess::Settings(driv) = new CDriverSettings();
+    CNvSDKInterface *inter = new CNvSDKInterface();
+    CDriverTestAccess::NvInterface(driv) = inter;
+    inter->driver = &driv;
+    inter->SetCamera(glm::vec3(0.f), glm::quat(1.f, 0.f, 0.f, 0.f));
+    CDriverTestAccess::Offset(*inter) = glm::vec3(0.f);
+
+    CCameraDriver *camera = new CCameraDriver(&driv);
+    CDriverTestAccess::Camera(driv) = camera;
+    cv::VideoCapture unopened;
+    for (int id = 0; id < HOTKEY_CAMERAS; id++)
+        CDriverTestAccess::Cameras(*camera).push_back(CameraInfo(unopened, id));
+    CDriverTestAccess::CameraCount(*camera) = HOTKEY_CAMERAS;
+
+    CDriverTestAccess::Station(driv) = new CVirtualBaseStation(&driv);
+    //  Never started, RunFrame only reports the display period to it
+    CDriverTestAccess::Publisher(driv) = new CPosePublisher(&driv);
+    //  RunFrame does nothing until the camera thread exists
+    CDriverTestAccess::CameraThread(driv) = CDriverTestAccess::Threads(driv).Spawn("Camera", [](const CStopToken &token) {
+        while (token.SleepFor(1.0))
+            ;
+    });
+
+    m_keys = new CScriptedKeySource();
+    driv.SetKeySource(m_keys);
+    CDriverTestAccess::BindInputs(driv);
+
+    m_now = 0.0;
+    CDriverTestAccess::LastClock(driv) = m_now;
+    Frame();
+}
+
+void CHotkeyTest::Frame()
+{
+    m_now += HOTKEY_FRAME;
+    m_driver.DoRunFrame(m_now);
+}
+
+void CHotkeyTest::Frames(int count)
+{
+    for (int frame = 0; frame < count; frame++)
+        Frame();
+}
+
+void CHotkeyTest::Tap(int key)
+{
+    m_keys->Tap(key);
+    Frames(2);
+}
+
+//  A binding is active from the frame after its key went down up to the frame its release is seen,
+//  so it applies for exactly the given number of frames
+void CHotkeyTest::Hold(int key, int frames)
+{
+    m_keys->Press(key);
+    Frames(frames);
+    m_keys->Release(key);
+    Frame();
+}
+
+//  The switch is only queued by RunFrame, the camera thread carries it out before its next frame
+void CHotkeyTest::SwitchCamera(int key)
+{
+    Tap(key);
+    CDriverTestAccess::ApplyRequests(*CDriverTestAccess::Camera(m_driver));
+}
+
+void CHotkeyTest::TestCameraSwitch()
+{
+    CCameraDriver &camera = *CDriverTestAccess::Camera(m_driver);
+    Check(camera.GetIndex() == 0, "camera: starts on the first camera");
+    Tap('G');
+    Check(camera.GetIndex() == 0, "camera: G leaves the switch to the camera thread");
+    CDriverTestAccess::ApplyRequests(camera);
+    Check(camera.GetIndex() == 1, "camera: G switches to the next camera");
+    SwitchCamera('G');
+    Check(camera.GetIndex() == 2, "camera: G again switches to the one after");
+    SwitchCamera('F');
+    Check(camera.GetIndex() == 1, "camera: F switches to the previous camera");
+    SwitchCamera('G');
+    SwitchCamera('G');
+    Check(camera.GetIndex() == 0, "camera: G on the last camera wraps to the first");
+    SwitchCamera('F');
+    Check(camera.GetIndex() == HOTKEY_CAMERAS - 1, "camera: F on the first camera wraps to the last");
+    Tap('F');
+    Tap('F');
+    CDriverTestAccess::ApplyRequests(camera);
+    Check(camera.GetIndex() == 0, "camera: switches queued over several frames add up");
+}
+
+void CHotkeyTest::TestScale()
+{
+    //  Both follow the driver as the bindings change it
+    const glm::vec3 &scale = CDriverTestAccess::GetScaleFactor(m_driver);
+    const glm::vec3 &axisScale = CDriverTestAccess::GetAxisScale(*CDriverTestAccess::NvInterface(m_driver));
+    glm::vec3 before = scale;
+    float step = (float)(CDriverTestAccess::GetScaleSpeed(m_driver) * HOTKEY_FRAME);
+
+    Hold('T', HOTKEY_HOLD);
+    Check(Near(scale.x, before.x + HOTKEY_HOLD * step), "scale: holding T scales the X axis up");
+    Hold('R', HOTKEY_HOLD / 2);
+    Check(Near(scale.x, before.x + (HOTKEY_HOLD - HOTKEY_HOLD / 2) * step), "scale: holding R scales the X axis down");
+    Hold('U', HOTKEY_HOLD);
+    Check(Near(scale.y, before.y + HOTKEY_HOLD * step), "scale: holding U scales the Y axis up");
+    Hold('I', HOTKEY_HOLD);
+    Check(Near(scale.z, before.z - HOTKEY_HOLD * step), "scale: holding I scales the Z axis down");
+    Check(Near(axisScale.y, -0.001f * scale.y), "scale: the SDK axis scale follows the scale factor");
+}
+
+void CHotkeyTest::TestOffset()
+{
+    CNvSDKInterface &inter = *CDriverTestAccess::NvInterface(m_driver);
+    glm::vec3 before = CDriverTestAccess::Offset(inter);
+    glm::vec3 camera = inter.GetCameraPos();
+    float step = (float)(CDriverTestAccess::GetMoveSpeed(m_driver) * HOTKEY_FRAME);
+
+    m_keys->Press(VK_SHIFT);
+    Frame();
+    Hold('W', HOTKEY_HOLD);
+    Hold('A', HOTKEY_HOLD);
+    Hold('Q', HOTKEY_HOLD / 2);
+    m_keys->Release(VK_SHIFT);
+    Frames(2);
+
+    Check(Near(CDriverTestAccess::Offset(inter).z, before.z + HOTKEY_HOLD * step), "offset: Shift + W moves the HMD offset forward");
+    Check(Near(CDriverTestAccess::Offset(inter).x, before.x + HOTKEY_HOLD * step), "offset: Shift + A moves the HMD offset left");
+    Check(Near(CDriverTestAccess::Offset(inter).y, before.y - (HOTKEY_HOLD / 2) * step), "offset: Shift + Q moves the HMD offset down");
+    Check(inter.GetCameraPos() == camera, "offset: the base station stays where it was while Shift is held");
+
+    Hold('E', HOTKEY_HOLD);
+    Check(Near(inter.GetCameraPos().y, camera.y + HOTKEY_HOLD * step), "offset: E without Shift raises the base station");
+}
+
+void CHotkeyTest::TestMirror()
+{
+    const glm::vec3 &axisScale = CDriverTestAccess::GetAxisScale(*CDriverTestAccess::NvInterface(m_driver));
+    bool before = CDriverTestAccess::IsMirrored(m_driver);
+    Tap('X');
+    bool mirrored = CDriverTestAccess::IsMirrored(m_driver);
+    Check(mirrored != before, "mirror: X toggles mirroring");
+    Check((axisScale.x < 0.f) == mirrored, "mirror: the X axis scale flips with it");
+    Tap('X');
+    mirrored = CDriverTestAccess::IsMirrored(m_driver);
+    Check(mirrored == before, "mirror: X again toggles it back");
+    Check((axisScale.x < 0.f) == mirrored, "mirror: and the X axis scale flips back");
+}
+
+static size_t CountTraces(const std::string &directory)
+{
+    size_t count = 0u;
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr)
+        return 0u;
+    while (dirent *entry = readdir(dir))
+    {
+        if (strstr(entry->d_name, "trace-") != nullptr && strstr(entry->d_name, ".json") != nullptr)
+            count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+void CHotkeyTest::TestExportTrace(const std::string &directory)
+{
+    size_t before = CountTraces(directory);
+    Tap('P');
+    Check(m_driver.GetTrace().BeginExport(), "export: P without Ctrl does not export");
+    m_driver.GetTrace().EndExport();
+
+    m_keys->Press(VK_CONTROL);
+    Frame();
+    Tap('P');
+    m_keys->Release(VK_CONTROL);
+    Frames(2);
+
+    //  The export runs on a thread of its own, it is done once another one could begin
+    double waited = 0.0;
+    while (!m_driver.GetTrace().BeginExport() && waited < HOTKEY_EXPORT_TIMEOUT)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        waited += .01;
+    }
+    m_driver.GetTrace().EndExport();
+    Check(waited < HOTKEY_EXPORT_TIMEOUT, "export: Ctrl + P finishes writing the trace");
+    Check(CountTraces(directory) == before + 1u, "export: Ctrl + P writes one trace next to settings.ini");
+}
+
+int main(int argc, char **argv)
+{
+    //  settings.ini and the traces end up in a scratch directory, the driver cuts the module path at \bin
+    //  It outlives the driver, whose cleanup writes the trace once more
+    CScratchDirectory scratch("hotkey_test");
+    const std::string &directory = scratch.GetPath();
+    if (directory.empty())
+        return 2;
+    sprintf_s(g_modulePath, sizeof(g_modulePath), "%s/driver\\bin\\linux64\\driver_nvidiaBodyTracking.so", directory.c_str());
+
+    {
+        CHotkeyTest test;
+        test.TestCameraSwitch();
+        test.TestScale();
+        test.TestOffset();
+        test.TestMirror();
+        test.TestExportTrace(directory);
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,156 @@
+//  Writes an encoded keypoint trace of the synthetic body with CKeypointRecorder, replays it with CKeypointTraceReplay
+//  and checks every decoded value against what was recorded: positions, confidences and joint angles have to stay
+//  within the quantization error of their 16 bit steps, in keyframes as well as in the delta packets between them
+//  Run by ctest, exits non-zero on failure
+//
+//    ./build-benchmark/keypoint_codec_test
+#include "pch.h"
+#include "CKeypointTrace.h"
+#include "CKeypointTraceReplay.h"
+#include "CPoseCodec.h"
+#include "CSyntheticBody.h"
+#include "TestCheck.h"
+#include <sys/stat.h>
+
+#define CODEC_TEST_BATCHES 2u
+//  Three keyframes in, and a few delta packets after the last one
+#define CODEC_TEST_FRAMES (3u * POSE_CODEC_KEYFRAME_INTERVAL + 10u)
+#define CODEC_TEST_FPS 30.0
+//  Every so often the body skips ahead, so some channels move too far for 8 bit differences
+#define CODEC_TEST_JUMP_EVERY 25u
+#define CODEC_TEST_JUMP 0.75
+
+//  Largest error of each kind of value, over keyframes or over delta packets
+struct CodecError
+{
+    uint64_t entries;
+    float position3D;
+    float position2D;
+    float confidence;
+    float quaternion;
+
+    CodecError() : entries(0u), position3D(0.f), position2D(0.f), confidence(0.f), quaternion(0.f) {}
+};
+
+static void Compare(const KeypointFrame &decoded, const KeypointTraceEntry &recorded, CodecError &error)
+{
+    error.entries++;
+    for (size_t joint = 0; joint < BODY_JOINT_COUNT; joint++)
+    {
+        const NvAR_Point3f &p3 = recorded.keypoints3D[joint], &d3 = decoded.keypoints3D[joint];
+        error.position3D = (std::max)(error.position3D, (std::max)(std::fabs(p3.x - d3.x), (std::max)(std::fabs(p3.y - d3.y), std::fabs(p3.z - d3.z))));
+        const NvAR_Point2f &p2 = recorded.keypoints[joint], &d2 = decoded.keypoints[joint];
+        error.position2D = (std::max)(error.position2D, (std::max)(std::fabs(p2.x - d2.x), std::fabs(p2.y - d2.y)));
+        error.confidence = (std::max)(error.confidence, std::fabs(recorded.confidence[joint] - decoded.confidence[joint]));
+
+        //  q and -q are the same rotation, the codec keeps the sign that makes the dropped component positive
+        const NvAR_Quaternion &pq = recorded.jointAngles[joint], &dq = decoded.jointAngles[joint];
+        float sign = pq.x * dq.x + pq.y * dq.y + pq.z * dq.z + pq.w * dq.w < 0.f ? -1.f : 1.f;
+        float components[4] = { pq.x - sign * dq.x, pq.y - sign * dq.y, pq.z - sign * dq.z, pq.w - sign * dq.w };
+        for (float component : components)
+            error.quaternion = (std::max)(error.quaternion, std::fabs(component));
+    }
+}
+
+static void Report(const char *name, const CodecError &error)
+{
+    printf("%-10s %5llu entries  3D %.6f m  2D %.4f px  confidence %.6f  quaternion %.6f\n", name,
+        (unsigned long long)error.entries, error.position3D, error.position2D, error.confidence, error.quaternion);
+}
+
+//  Half a step of rounding, with float slack for the largest values; the dropped quaternion component is rebuilt from
+//  the other three, whose errors it can add up to a bit less than twice of
+static void CheckBounds(const char *name, const CodecError &error)
+{
+    char what[128];
+    sprintf_s(what, sizeof(what), "%s: 3D keypoints within half a quantization step", name);
+    Check(error.position3D <= .5f / POSE_CODEC_SCALE_3D + 1e-6f, what);
+    sprintf_s(what, sizeof(what), "%s: 2D keypoints within half a quantization step", name);
+    Check(error.position2D <= .5f / POSE_CODEC_SCALE_2D + 1e-4f, what);
+    sprintf_s(what, sizeof(what), "%s: confidences within half a quantization step", name);
+    Check(error.confidence <= .5f / POSE_CODEC_SCALE_CONFIDENCE + 1e-6f, what);
+    sprintf_s(what, sizeof(what), "%s: joint angles within the quantization error", name);
+    Check(error.quaternion <= 2.f / POSE_CODEC_SCALE_QUAT + 1e-6f, what);
+}
+
+int main(int argc, char **argv)
+{
+    CScratchDirectory scratch("keypoint_codec_test");
+    if (scratch.GetPath().empty())
+        return 2;
+    std::string path = scratch.GetPath() + "/keypoints.bin";
+
+    //  Entry b of a record holds run batches - 1 - b, the way the driver keeps them
+    std::vector<KeypointTraceEntry> recorded(CODEC_TEST_FRAMES * CODEC_TEST_BATCHES);
+    {
+        CKeypointRecorder recorder;
+        if (!recorder.Open(path.c_str(), CODEC_TEST_BATCHES, 600.f, true))
+        {
+            fprintf(stderr, "Unable to create the keypoint trace %s\n", path.c_str());
+            return 2;
+        }
+        CSyntheticBody body(CSyntheticBody::c_camera, .005f, 1u);
+        NvAR_Point2f keypoints[CODEC_TEST_BATCHES * BODY_JOINT_COUNT];
+        NvAR_Point3f keypoints3D[CODEC_TEST_BATCHES * BODY_JOINT_COUNT];
+        NvAR_Quaternion jointAngles[CODEC_TEST_BATCHES * BODY_JOINT_COUNT];
+        float confidence[CODEC_TEST_BATCHES * BODY_JOINT_COUNT];
+        double bodyTime = 0.0;
+        for (unsigned frame = 0; frame < CODEC_TEST_FRAMES; frame++)
+        {
+            bodyTime += frame % CODEC_TEST_JUMP_EVERY == 0u ? CODEC_TEST_JUMP : 1.0 / CODEC_TEST_FPS;
+            for (size_t batch = 0; batch < CODEC_TEST_BATCHES; batch++)
+            {
+                KeypointFrame sample;
+                body.Sample(bodyTime, (int)(CODEC_TEST_BATCHES - 1u - batch), sample);
+                KeypointTraceEntry &entry = recorded[frame * CODEC_TEST_BATCHES + batch];
+                memcpy(entry.keypoints, sample.keypoints, sizeof(entry.keypoints));
+                memcpy(entry.keypoints3D, sample.keypoints3D, sizeof(entry.keypoints3D));
+                memcpy(entry.jointAngles, sample.jointAngles, sizeof(entry.jointAngles));
+                memcpy(entry.confidence, sample.confidence, sizeof(entry.confidence));
+                size_t first = batch * BODY_JOINT_COUNT;
+                memcpy(keypoints + first, entry.keypoints, sizeof(entry.keypoints));
+                memcpy(keypoints3D + first, entry.keypoints3D, sizeof(entry.keypoints3D));
+                memcpy(jointAngles + first, entry.jointAngles, sizeof(entry.jointAngles));
+                memcpy(confidence + first, entry.confidence, sizeof(entry.confidence));
+            }
+            KeypointTraceFrame record{};
+            record.frameId = frame;
+            record.captureTime = frame / CODEC_TEST_FPS;
+            recorder.Append(record, keypoints, keypoints3D, jointAngles, confidence);
+        }
+        Check(recorder.GetRecords() == CODEC_TEST_FRAMES, "record: every frame was appended");
+    }
+
+    struct stat info;
+    size_t raw = sizeof(KeypointTraceHeader) + CODEC_TEST_FRAMES * (sizeof(KeypointTraceFrame) + CODEC_TEST_BATCHES * sizeof(KeypointTraceEntry));
+    Check(stat(path.c_str(), &info) == 0 && (size_t)info.st_size < raw / 2u, "record: the encoded trace is less than half the raw size");
+
+    CKeypointTraceReplay replay;
+    bool opened = replay.Open(path.c_str());
+    Check(opened, "replay: the encoded trace opens");
+    if (opened)
+    {
+        Check(replay.GetFrameCount() == CODEC_TEST_FRAMES, "replay: every record decodes");
+        Check(replay.GetBatches() == CODEC_TEST_BATCHES, "replay: every run of a record decodes");
+
+        //  Each run's stream starts with a keyframe and has one every POSE_CODEC_KEYFRAME_INTERVAL packets
+        CodecError keyframes, deltas;
+        KeypointFrame decoded;
+        for (size_t index = 0; index < replay.GetFrameCount() && index < CODEC_TEST_FRAMES; index++)
+        {
+            CodecError &error = index % POSE_CODEC_KEYFRAME_INTERVAL == 0u ? keyframes : deltas;
+            for (unsigned run = 0; run < CODEC_TEST_BATCHES; run++)
+            {
+                replay.Sample(replay.GetFrameTime(index), (int)run, decoded);
+                Compare(decoded, recorded[index * CODEC_TEST_BATCHES + (CODEC_TEST_BATCHES - 1u - run)], error);
+            }
+        }
+        Report("keyframes", keyframes);
+        Report("deltas", deltas);
+        Check(keyframes.entries > 0u && deltas.entries > 0u, "replay: both keyframes and delta packets were checked");
+        CheckBounds("keyframes", keyframes);
+        CheckBounds("deltas", deltas);
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,512 @@
+//  Microbenchmarks of the per frame math, on the fixed inputs of CMathFixture
+//  Built on Google Benchmark: --benchmark_format=json (or --benchmark_out=FILE) gives results that
+//  tools/compare.py from the Google Benchmark sources can diff between two commits
+#include "pch.h"
+#include "CMathFixture.h"
+#include "CNvSDKInterface.h"
+#include "CInterpolator.h"
+#include "CTransformHistory.h"
+#include "CPoseCodec.h"
+#include "CDriverSettings.h"
+#include "CCommon.h"
+#include <benchmark/benchmark.h>
+
+//  Created by main before any benchmark runs
+static CMathFixture *s_fixture = nullptr;
+
+//  Interpolation factors cycled through, so no benchmark runs on a single constant
+#define MATH_STEPS 16u
+static inline float Step(unsigned &step) { return (float)(step++ % MATH_STEPS) / (float)MATH_STEPS; }
+
+static void BatchArgs(benchmark::internal::Benchmark *bench)
+{
+    bench->ArgName("batches")->RangeMultiplier(2)->Range(1, MATH_FIXTURE_BATCHES_MAX);
+}
+
+static void DepthArgs(benchmark::internal::Benchmark *bench)
+{
+    bench->ArgName("depth")->DenseRange(1, TRANSFORM_HISTORY_MAX);
+}
+
+static void BM_InterpolateMatrix(benchmark::State &state)
+{
+    glm::mat4x4 from = s_fixture->GetTrackerSample(0).Get((size_t)TRACKER_ROLE::LEFT_FOOT).Matrix();
+    glm::mat4x4 to = s_fixture->GetTrackerSample(1).Get((size_t)TRACKER_ROLE::LEFT_FOOT).Matrix();
+    unsigned step = 0u;
+    for (auto _ : state)
+    {
+        glm::mat4x4 result = CNvSDKInterface::InterpolateMatrix(from, to, Step(step));
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_InterpolateMatrix);
+
+//  The glm::mat4x4 paths RigidTransform replaced, as CNvSDKInterface had them before
+//  Each BM_*Glm benchmark below is paired with a BM_*Rigid one over the same fixture transforms
+namespace GlmPath
+{
+    static inline glm::mat4x4 Slide(glm::mat4x4 mat, const glm::vec3 vector)
+    {
+        mat[3][0] += vector.x;
+        mat[3][1] += vector.y;
+        mat[3][2] += vector.z;
+        return mat;
+    }
+    static inline glm::mat4x4 CastMatrix(const glm::vec3 &point, const glm::quat &quat) { return Slide(glm::mat4_cast(quat), point); }
+    static inline glm::mat4x4 InverseRotation(glm::mat4x4 mat)
+    {
+        glm::vec3 temp = glm::vec3(mat[3]);
+        mat = glm::inverse(mat);
+        mat[3][0] = temp.x;
+        mat[3][1] = temp.y;
+        mat[3][2] = temp.z;
+        return mat;
+    }
+    static inline glm::mat4x4 InterpolateMatrix(const glm::mat4x4 &mat1, const glm::mat4x4 &mat2, const float &delta)
+    {
+        glm::mat4x4 output = glm::mat4_cast(glm::slerp(glm::quat_cast(mat1), glm::quat_cast(mat2), delta));
+        output[3] = mat2[3] * delta + mat1[3] * (1.f - delta);
+        return output;
+    }
+    //  The two-sample blend of the old interpolation, a normalized lerp of the rotations
+    static inline glm::mat4x4 NlerpMatrix(const glm::mat4x4 &mat1, const glm::mat4x4 &mat2, const float &delta)
+    {
+        glm::quat from = glm::quat_cast(mat1), to = glm::quat_cast(mat2);
+        if (glm::dot(from, to) < 0.f)
+            to = -to;
+        glm::mat4x4 output = glm::mat4_cast(glm::normalize(glm::lerp(from, to, delta)));
+        output[3] = mat2[3] * delta + mat1[3] * (1.f - delta);
+        return output;
+    }
+    static inline glm::vec3 ObjectToWorldVector(const glm::mat4x4 &mat, const glm::vec3 &vec) { return glm::translate(mat, vec)[3]; }
+    static inline glm::vec3 WorldToObjectVector(const glm::mat4x4 &mat, const glm::vec3 &vec) { return glm::translate(glm::inverse(mat), vec)[3]; }
+    static inline glm::mat4x4 MirrorRotationX(const glm::mat4x4 &ref)
+    {
+        return CastMatrix(glm::vec3(ref[3]), CNvSDKInterface::MirrorQuaternionX(glm::quat_cast(ref)));
+    }
+}
+
+static void BM_CastGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        const RigidTransform &sample = s_fixture->GetRigidSample(index++);
+        glm::mat4x4 result = GlmPath::CastMatrix(sample.Position(), sample.Rotation());
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_CastGlm);
+
+static void BM_CastRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        const RigidTransform &sample = s_fixture->GetRigidSample(index++);
+        RigidTransform result(sample.Position(), sample.Rotation());
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_CastRigid);
+
+static void BM_ComposeGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        glm::mat4x4 result = s_fixture->GetMatrixSample(index) * s_fixture->GetMatrixSample(index + 1u);
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ComposeGlm);
+
+static void BM_ComposeRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        RigidTransform result = s_fixture->GetRigidSample(index) * s_fixture->GetRigidSample(index + 1u);
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ComposeRigid);
+
+static void BM_InverseGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        glm::mat4x4 result = glm::inverse(s_fixture->GetMatrixSample(index++));
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_InverseGlm);
+
+static void BM_InverseRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        RigidTransform result = s_fixture->GetRigidSample(index++).Inverse();
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_InverseRigid);
+
+static void BM_InverseRotationGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        glm::mat4x4 result = GlmPath::InverseRotation(s_fixture->GetMatrixSample(index++));
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_InverseRotationGlm);
+
+static void BM_InverseRotationRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        RigidTransform result = s_fixture->GetRigidSample(index++).InverseRotation();
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_InverseRotationRigid);
+
+static void BM_SlerpGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    unsigned step = 0u;
+    for (auto _ : state)
+    {
+        glm::mat4x4 result = GlmPath::InterpolateMatrix(s_fixture->GetMatrixSample(index), s_fixture->GetMatrixSample(index + MATH_FIXTURE_ROLES), Step(step));
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_SlerpGlm);
+
+static void BM_SlerpRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    unsigned step = 0u;
+    for (auto _ : state)
+    {
+        RigidTransform result = RigidTransform::Slerp(s_fixture->GetRigidSample(index), s_fixture->GetRigidSample(index + MATH_FIXTURE_ROLES), Step(step));
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_SlerpRigid);
+
+static void BM_NlerpGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    unsigned step = 0u;
+    for (auto _ : state)
+    {
+        glm::mat4x4 result = GlmPath::NlerpMatrix(s_fixture->GetMatrixSample(index), s_fixture->GetMatrixSample(index + MATH_FIXTURE_ROLES), Step(step));
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_NlerpGlm);
+
+static void BM_NlerpRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    unsigned step = 0u;
+    for (auto _ : state)
+    {
+        RigidTransform result = RigidTransform::Nlerp(s_fixture->GetRigidSample(index), s_fixture->GetRigidSample(index + MATH_FIXTURE_ROLES), Step(step));
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_NlerpRigid);
+
+//  CamToWorld, a point through a transform
+static void BM_ApplyGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        const glm::mat4x4 &point = s_fixture->GetMatrixSample(index + 1u);
+        glm::vec3 result = GlmPath::ObjectToWorldVector(s_fixture->GetMatrixSample(index), glm::vec3(point[3]));
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ApplyGlm);
+
+static void BM_ApplyRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        glm::vec3 result = s_fixture->GetRigidSample(index).Apply(s_fixture->GetRigidSample(index + 1u).Position());
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ApplyRigid);
+
+//  WorldToCam, a point through an inverted transform
+static void BM_ApplyInverseGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        const glm::mat4x4 &point = s_fixture->GetMatrixSample(index + 1u);
+        glm::vec3 result = GlmPath::WorldToObjectVector(s_fixture->GetMatrixSample(index), glm::vec3(point[3]));
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ApplyInverseGlm);
+
+static void BM_ApplyInverseRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        glm::vec3 result = s_fixture->GetRigidSample(index).Inverse().Apply(s_fixture->GetRigidSample(index + 1u).Position());
+        index++;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_ApplyInverseRigid);
+
+static void BM_MirrorGlm(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        glm::mat4x4 result = GlmPath::MirrorRotationX(s_fixture->GetMatrixSample(index++));
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_MirrorGlm);
+
+static void BM_MirrorRigid(benchmark::State &state)
+{
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        RigidTransform result = s_fixture->GetRigidSample(index++).MirrorX();
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_MirrorRigid);
+
+static void BM_ComputeRotations(benchmark::State &state)
+{
+    s_fixture->Reset(1);
+    for (auto _ : state)
+    {
+        s_fixture->ComputeRotations();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ComputeRotations);
+
+static void BM_FillBatchedConfidence(benchmark::State &state)
+{
+    s_fixture->Reset((int)state.range(0));
+    for (auto _ : state)
+    {
+        s_fixture->FillConfidence();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_FillBatchedConfidence)->Apply(BatchArgs);
+
+static void BM_FillBatchedKeypoints(benchmark::State &state)
+{
+    s_fixture->Reset((int)state.range(0));
+    for (auto _ : state)
+    {
+        s_fixture->FillKeypoints();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_FillBatchedKeypoints)->Apply(BatchArgs);
+
+static void BM_FillBatchedAngles(benchmark::State &state)
+{
+    s_fixture->Reset((int)state.range(0));
+    for (auto _ : state)
+    {
+        s_fixture->FillAngles();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_FillBatchedAngles)->Apply(BatchArgs);
+
+static void BM_ComputeAvgConfidence(benchmark::State &state)
+{
+    s_fixture->Reset((int)state.range(0));
+    for (auto _ : state)
+    {
+        s_fixture->ComputeAvgConfidence();
+        benchmark::DoNotOptimize(s_fixture->Interface().GetConfidence());
+    }
+}
+BENCHMARK(BM_ComputeAvgConfidence)->Apply(BatchArgs);
+
+//  The alignments move every keypoint by an offset computed from the current ones, so repeating them
+//  converges instead of drifting and every iteration does the same work
+static void BM_AlignToHMD(benchmark::State &state)
+{
+    s_fixture->Reset(1);
+    for (auto _ : state)
+    {
+        s_fixture->AlignToHMD();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_AlignToHMD);
+
+static void BM_AlignToControllers(benchmark::State &state)
+{
+    s_fixture->Reset(1);
+    for (auto _ : state)
+    {
+        s_fixture->AlignToControllers();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_AlignToControllers);
+
+static void BM_AlignWithOffset(benchmark::State &state)
+{
+    s_fixture->Reset(1);
+    for (auto _ : state)
+    {
+        s_fixture->AlignWithOffset();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_AlignWithOffset);
+
+static void BM_AlignToMirror(benchmark::State &state)
+{
+    s_fixture->Reset(1);
+    for (auto _ : state)
+    {
+        s_fixture->AlignToMirror();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_AlignToMirror);
+
+static void BM_GetTransformFromRole(benchmark::State &state, TRACKER_ROLE role)
+{
+    s_fixture->Reset(1);
+    const CNvSDKInterface &inter = s_fixture->Interface();
+    for (auto _ : state)
+    {
+        RigidTransform transform = inter.GetTransformFromRole(role);
+        benchmark::DoNotOptimize(transform);
+    }
+}
+
+//  What the tracker bank does once per camera frame, for every role at once
+static void BM_HistoryPush(benchmark::State &state)
+{
+    size_t depth = (size_t)state.range(0);
+    CTransformHistory history(depth, MATH_FIXTURE_ROLES);
+    size_t index = 0u;
+    for (auto _ : state)
+    {
+        history.Push(s_fixture->GetTrackerSample(index++));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_HistoryPush)->Apply(DepthArgs);
+
+//  What the tracker bank does once per SteamVR frame, for every role at once
+static void BM_Interpolate(benchmark::State &state, INTERP_MODE mode)
+{
+    size_t depth = (size_t)state.range(0);
+    CTransformHistory history(depth, MATH_FIXTURE_ROLES);
+    for (size_t index = 0; index < depth; index++)
+        history.Push(s_fixture->GetTrackerSample(index));
+    InterpolatorFn interpolator = SelectInterpolator(mode, depth);
+    const TransformLanes &targets = s_fixture->GetTrackerSample(depth);
+    TransformLanes output = s_fixture->GetTrackerSample(0);
+    unsigned step = 0u;
+    for (auto _ : state)
+    {
+        interpolator(history, targets, output, Step(step));
+        benchmark::DoNotOptimize(output);
+    }
+}
+
+//  Consecutive camera frames encoded as one stream, bytes_per_frame is how much of KeypointTraceEntry is left
+static void BM_EncodePose(benchmark::State &state)
+{
+    CPoseEncoder encoder;
+    uint8_t packet[POSE_PACKET_MAX];
+    size_t index = 0u, bytes = 0u;
+    for (auto _ : state)
+    {
+        bytes += encoder.Encode(s_fixture->GetEntrySample(index++), packet);
+        benchmark::DoNotOptimize(packet);
+    }
+    state.counters["bytes_per_frame"] = benchmark::Counter((double)bytes / (double)index);
+    state.counters["ratio"] = benchmark::Counter((double)(index * sizeof(KeypointTraceEntry)) / (double)bytes);
+}
+BENCHMARK(BM_EncodePose);
+
+//  The stream starts on a keyframe, so going back to its start resynchronizes the decoder
+static void BM_DecodePose(benchmark::State &state)
+{
+    CPoseEncoder encoder;
+    std::vector<uint8_t> stream(MATH_FIXTURE_SAMPLES * POSE_PACKET_MAX);
+    size_t length = 0u;
+    for (size_t index = 0; index < MATH_FIXTURE_SAMPLES; index++)
+        length += encoder.Encode(s_fixture->GetEntrySample(index), stream.data() + length);
+    CPoseDecoder decoder;
+    KeypointTraceEntry entry;
+    size_t offset = 0u;
+    for (auto _ : state)
+    {
+        offset += decoder.Decode(stream.data() + offset, length - offset, entry);
+        if (offset >= length)
+            offset = 0u;
+        benchmark::DoNotOptimize(entry);
+    }
+}
+BENCHMARK(BM_DecodePose);
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    CMathFixture fixture;
+    s_fixture = &fixture;
+
+    for (size_t role = 0; role < MATH_FIXTURE_ROLES; role++)
+    {
+        std::string name = std::string("BM_GetTransformFromRole/") + TrackerRoleName[role];
+        benchmark::RegisterBenchmark(name.c_str(), BM_GetTransformFromRole, (TRACKER_ROLE)role);
+    }
+    for (int mode = (int)INTERP_MODE::LINEAR; mode <= (int)INTERP_MODE::CUBIC; mode++)
+    {
+        std::string name = std::string("BM_Interpolate/") + InterpModeName[mode];
+        benchmark::RegisterBenchmark(name.c_str(), BM_Interpolate, (INTERP_MODE)mode)->Apply(DepthArgs);
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    s_fixture = nullptr;
+    return 0;
+}
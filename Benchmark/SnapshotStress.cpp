@@ -0,0 +1,151 @@
+//  Stress test of the pose handoff between the camera thread and the SteamVR thread (CSnapshotBuffer<PoseSnapshot>)
+//  Built with -fsanitize=thread by Benchmark/CMakeLists.txt and run by ctest, a data race fails it through TSAN
+//  The writer stamps a sequence number into every field of the snapshot, the reader checks each snapshot it
+//  acquires carries a single one (no torn read) and that it never goes back in time
+//
+//    ./build-benchmark/snapshot_stress [seconds per phase]
+#include "pch.h"
+#include "CTrackerBank.h"
+#include "CSnapshotBuffer.h"
+
+//  The default CameraFPS and the fastest display SteamVR commonly runs at
+#define STRESS_INFERENCE_RATE 30.0
+#define STRESS_DISPLAY_RATE 144.0
+#define STRESS_PHASE_SECONDS 2.0
+
+struct StressResult
+{
+    uint64_t published;
+    uint64_t acquired;
+    uint64_t torn;
+    uint64_t reordered;
+};
+
+//  Every field the pipeline reads, so a slot overwritten while being read always shows up
+static void Stamp(PoseSnapshot &snapshot, uint64_t sequence)
+{
+    float value = (float)sequence;
+    snapshot.sampleTime = (double)sequence;
+    snapshot.arrival = (double)sequence;
+    snapshot.captureStart = (int64_t)sequence;
+    snapshot.frameId = sequence;
+    snapshot.active = (sequence & 1u) != 0u;
+    snapshot.offset = RigidTransform(glm::vec3(value), glm::quat(value, value, value, value));
+    for (size_t lane = 0; lane < TRANSFORM_LANES_MAX; lane++)
+    {
+        snapshot.targets.Set(lane, snapshot.offset);
+        snapshot.valid[lane] = ((sequence + lane) & 1u) != 0u;
+        snapshot.trackerConfidence[lane] = value;
+    }
+    for (size_t joint = 0; joint < BODY_JOINT_COUNT; joint++)
+    {
+        snapshot.keypoints[joint] = glm::vec3(value);
+        snapshot.rotations[joint] = glm::quat(value, value, value, value);
+        snapshot.confidence[joint] = value;
+    }
+}
+
+static bool Consistent(const PoseSnapshot &snapshot)
+{
+    uint64_t sequence = snapshot.frameId;
+    float value = (float)sequence;
+    bool same = snapshot.sampleTime == (double)sequence && snapshot.arrival == (double)sequence &&
+        snapshot.captureStart == (int64_t)sequence && snapshot.active == ((sequence & 1u) != 0u);
+    for (size_t index = 0; index < 4u; index++)
+        same = same && snapshot.offset.q[index] == value && (index == 3u || snapshot.offset.p[index] == value);
+    for (size_t lane = 0; lane < TRANSFORM_LANES_MAX; lane++)
+    {
+        RigidTransform target = snapshot.targets.Get(lane);
+        same = same && target.Position() == glm::vec3(value) && target.Rotation() == glm::quat(value, value, value, value) &&
+            snapshot.valid[lane] == (((sequence + lane) & 1u) != 0u) && snapshot.trackerConfidence[lane] == value;
+    }
+    for (size_t joint = 0; joint < BODY_JOINT_COUNT; joint++)
+        same = same && snapshot.keypoints[joint] == glm::vec3(value) && snapshot.rotations[joint] == glm::quat(value, value, value, value) &&
+            snapshot.confidence[joint] == value;
+    return same;
+}
+
+//  One writer and one reader, the buffer's contract; a rate of 0 runs that side as fast as it can
+static StressResult RunPhase(double writeRate, double readRate, double seconds)
+{
+    typedef std::chrono::steady_clock Clock;
+    std::unique_ptr<CSnapshotBuffer<PoseSnapshot>> buffer(new CSnapshotBuffer<PoseSnapshot>());
+    std::atomic<bool> running(true);
+    StressResult result = {};
+    Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    std::thread writer([&]()
+    {
+        Clock::time_point next = Clock::now();
+        //  Starts at 1, slots that were never published hold 0
+        uint64_t sequence = 1u;
+        while (running.load(std::memory_order_relaxed))
+        {
+            Stamp(buffer->Edit(), sequence++);
+            buffer->Publish();
+            if (writeRate > 0.)
+            {
+                next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1. / writeRate));
+                std::this_thread::sleep_until(next);
+            }
+        }
+        result.published = sequence - 1u;
+    });
+
+    std::thread reader([&]()
+    {
+        Clock::time_point next = Clock::now();
+        uint64_t last = 0u;
+        while (Clock::now() < end)
+        {
+            if (buffer->Acquire())
+            {
+                const PoseSnapshot &snapshot = buffer->Read();
+                result.acquired++;
+                if (!Consistent(snapshot))
+                    result.torn++;
+                if (snapshot.frameId <= last)
+                    result.reordered++;
+                last = snapshot.frameId;
+            }
+            //  Nothing new: the value held since the last acquire must not have changed underneath
+            else if (last != 0u && (buffer->Read().frameId != last || !Consistent(buffer->Read())))
+                result.torn++;
+            if (readRate > 0.)
+            {
+                next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1. / readRate));
+                std::this_thread::sleep_until(next);
+            }
+        }
+        running.store(false, std::memory_order_relaxed);
+    });
+
+    reader.join();
+    writer.join();
+    return result;
+}
+
+static bool Report(const char *name, const StressResult &result)
+{
+    printf("%-10s published %10llu  acquired %10llu  torn %llu  reordered %llu\n", name,
+        (unsigned long long)result.published, (unsigned long long)result.acquired,
+        (unsigned long long)result.torn, (unsigned long long)result.reordered);
+    return result.acquired > 0u && result.torn == 0u && result.reordered == 0u;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : STRESS_PHASE_SECONDS;
+    if (seconds <= 0.)
+    {
+        fprintf(stderr, "usage: %s [seconds per phase]\n", argv[0]);
+        return 2;
+    }
+
+    bool passed = true;
+    //  The rates the driver runs at, then both sides unthrottled to make interleavings as dense as possible
+    passed = Report("paced", RunPhase(STRESS_INFERENCE_RATE, STRESS_DISPLAY_RATE, seconds)) && passed;
+    passed = Report("unpaced", RunPhase(0., 0., seconds)) && passed;
+    printf(passed ? "PASSED\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
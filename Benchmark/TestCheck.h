@@ -0,0 +1,65 @@
+#pragma once
+#include <dirent.h>
+#include <unistd.h>
+
+//  Shared by the tests ctest runs: every check prints an ok or FAIL line, TestResult turns them into the exit code
+
+inline int &TestFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void Check(bool condition, const char *what)
+{
+    printf("%s  %s\n", condition ? "ok  " : "FAIL", what);
+    if (!condition)
+        TestFailures()++;
+}
+
+//  Prints the verdict, 0 when every check passed
+inline int TestResult()
+{
+    int failures = TestFailures();
+    printf(failures == 0 ? "PASSED\n" : "FAILED (%d)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+//  A fresh directory under /tmp for the files a test writes, removed along with them when it goes out of scope
+//  Only files are removed, a test must not leave directories of its own in it
+class CScratchDirectory
+{
+    std::string m_path;
+
+    CScratchDirectory(const CScratchDirectory &that) = delete;
+    CScratchDirectory &operator=(const CScratchDirectory &that) = delete;
+public:
+    explicit CScratchDirectory(const char *name)
+    {
+        std::string pattern = std::string("/tmp/") + name + "_XXXXXX";
+        std::vector<char> path(pattern.begin(), pattern.end());
+        path.push_back('\0');
+        if (mkdtemp(path.data()) != nullptr)
+            m_path = path.data();
+        else
+            fprintf(stderr, "Unable to create a scratch directory\n");
+    }
+    ~CScratchDirectory()
+    {
+        if (m_path.empty())
+            return;
+        if (DIR *dir = opendir(m_path.c_str()))
+        {
+            while (dirent *entry = readdir(dir))
+            {
+                if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+                    unlink((m_path + "/" + entry->d_name).c_str());
+            }
+            closedir(dir);
+        }
+        rmdir(m_path.c_str());
+    }
+
+    //  Empty when the directory could not be created
+    inline const std::string &GetPath() const { return m_path; }
+};
@@ -0,0 +1,208 @@
+//  Headless end-to-end benchmark of the driver pipeline, see CPipelineBenchmark.h
+#include "pch.h"
+#include "CPipelineBenchmark.h"
+#include "CTransformHistory.h"
+#include "CDriverSettings.h"
+#include "CCommon.h"
+
+std::atomic<uint64_t> g_allocations(0u);
+
+void *operator new(size_t size)
+{
+    g_allocations.fetch_add(1u, std::memory_order_relaxed);
+    void *ptr = malloc(size == 0u ? 1u : size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+struct TrackerOption
+{
+    const char *name;
+    TRACKING_FLAG flag;
+};
+
+//  Named like their keys in the [EnabledTrackers] section of settings.ini
+static const TrackerOption s_trackerOptions[] = {
+    { KEY_HIP_ON, TRACKING_FLAG::HIP },
+    { KEY_FEET_ON, TRACKING_FLAG::FEET },
+    { KEY_ELBOW_ON, TRACKING_FLAG::ELBOW },
+    { KEY_KNEE_ON, TRACKING_FLAG::KNEE },
+    { KEY_CHEST_ON, TRACKING_FLAG::CHEST },
+    { KEY_SHOULDER_ON, TRACKING_FLAG::SHOULDER },
+    { KEY_TOE_ON, TRACKING_FLAG::TOE },
+    { KEY_HEAD_ON, TRACKING_FLAG::HEAD },
+    { KEY_HAND_ON, TRACKING_FLAG::HAND }
+};
+
+static void PrintUsage(const char *program)
+{
+    fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "  --frames N          camera frames measured (3000)\n"
+        "  --warmup N          camera frames run before measuring (60)\n"
+        "  --camera-fps F      simulated camera rate (30)\n"
+        "  --display-hz F      simulated display rate (90)\n"
+        "  --resolution WxH    camera image size (640x480)\n"
+        "  --trackers LIST     comma separated, from Hips,Feet,Elbows,Knees,Chest,Shoulders,Toes,Head,Hand, or all\n"
+        "                      (Hips,Feet,Elbows,Knees,Chest)\n"
+        "  --batches N         inference runs per frame (2)\n"
+        "  --interp MODE       None, Linear, Sinusoidal, Quadratic or Cubic (Linear)\n"
+        "  --cache N           frame cache depth, 1 to 16 (2)\n"
+        "  --prediction        submit camera samples with velocities instead of interpolating\n"
+        "  --noise MM          keypoint noise of the synthetic body, in millimeters (5)\n"
+        "  --seed N            seed of the keypoint noise (1)\n"
+        "  --lag MS            how far the synthetic keypoints trail the controllers, in milliseconds (0)\n"
+        "  --replay FILE       replay a keypoint trace instead of the synthetic body, its rate, batches,\n"
+        "                      camera and image size replace the options\n"
+        "  --speed X           replay X times faster than recorded (1)\n"
+        "  --record PATH       record the run as a keypoint trace to PATH.bin, queuing each record is part\n"
+        "                      of the camera frame and writing it is not\n"
+        "  --encode            record the keypoint trace as pose packets (EncodeKeypoints in settings.ini)\n"
+        "  --trace FILE        write the Chrome trace of the run\n"
+        "  --json              print the results as JSON\n"
+        "  --verbose           print the driver log to stderr\n",
+        program
+    );
+}
+
+static bool ParseTrackers(const char *list, TRACKING_FLAG &flags)
+{
+    flags = TRACKING_FLAG::NONE;
+    std::stringstream stream(list);
+    std::string name;
+    while (std::getline(stream, name, ','))
+    {
+        bool found = false;
+        for (auto &option : s_trackerOptions)
+        {
+            if (name == option.name || name == "all")
+            {
+                flags = flags | option.flag;
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            fprintf(stderr, "Unknown tracker: %s\n", name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ParseInterpolation(const char *name, INTERP_MODE &mode)
+{
+    for (int index = (int)INTERP_MODE::NONE; index <= (int)INTERP_MODE::CUBIC; index++)
+    {
+        if (!strcmp(name, InterpModeName[index]))
+        {
+            mode = (INTERP_MODE)index;
+            return true;
+        }
+    }
+    fprintf(stderr, "Unknown interpolation mode: %s\n", name);
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkOptions options;
+    for (int index = 1; index < argc; index++)
+    {
+        std::string arg = argv[index];
+        const char *value = index + 1 < argc ? argv[index + 1] : nullptr;
+        bool valid = true;
+        if (arg == "--prediction")
+            options.prediction = true;
+        else if (arg == "--json")
+            options.json = true;
+        else if (arg == "--verbose")
+            options.verbose = true;
+        else if (arg == "--encode")
+            options.recordEncoded = true;
+        else if (arg == "--help" || arg == "-h")
+        {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        else if (value == nullptr)
+            valid = false;
+        else
+        {
+            index++;
+            if (arg == "--frames")
+                valid = (options.frames = (unsigned)atoi(value)) > 0u;
+            else if (arg == "--warmup")
+                options.warmup = (unsigned)atoi(value);
+            else if (arg == "--camera-fps")
+                valid = (options.cameraFps = atof(value)) > 0.0;
+            else if (arg == "--display-hz")
+                valid = (options.displayHz = atof(value)) > 0.0;
+            else if (arg == "--resolution")
+                valid = sscanf(value, "%dx%d", &options.width, &options.height) == 2 && options.width > 0 && options.height > 0;
+            else if (arg == "--trackers")
+                valid = ParseTrackers(value, options.trackers);
+            else if (arg == "--batches")
+                valid = (options.batches = atoi(value)) > 0;
+            else if (arg == "--interp")
+                valid = ParseInterpolation(value, options.interpolation);
+            else if (arg == "--cache")
+                valid = (options.frameCache = atoi(value)) >= 1 && options.frameCache <= TRANSFORM_HISTORY_MAX;
+            else if (arg == "--noise")
+                valid = (options.noise = (float)atof(value) * .001f) >= 0.f;
+            else if (arg == "--seed")
+                options.seed = (uint32_t)strtoul(value, nullptr, 10);
+            else if (arg == "--lag")
+                valid = (options.lag = atof(value) * .001) >= 0.0;
+            else if (arg == "--replay")
+                options.replayPath = value;
+            else if (arg == "--speed")
+                valid = (options.replaySpeed = atof(value)) > 0.0;
+            else if (arg == "--record")
+                options.recordPath = value;
+            else if (arg == "--trace")
+                options.tracePath = value;
+            else
+                valid = false;
+        }
+        if (!valid)
+        {
+            fprintf(stderr, "Invalid argument: %s\n", arg.c_str());
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    CPipelineBenchmark benchmark(options);
+    if (!benchmark.Run())
+        return 1;
+    benchmark.Report(stdout);
+    return 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+//  Stand-in for the NVIDIA AR SDK's nvAR.h, implemented by CReplayBackend.cpp
+#include "nvAR_defs.h"
+#include "nvCVImage.h"
+
+NvCV_Status NvAR_Create(NvAR_FeatureID featureID, NvAR_FeatureHandle *handle);
+NvCV_Status NvAR_Load(NvAR_FeatureHandle handle);
+NvCV_Status NvAR_Run(NvAR_FeatureHandle handle);
+NvCV_Status NvAR_Destroy(NvAR_FeatureHandle handle);
+
+NvCV_Status NvAR_CudaStreamCreate(CUstream *stream);
+NvCV_Status NvAR_CudaStreamDestroy(CUstream stream);
+
+NvCV_Status NvAR_SetU32(NvAR_FeatureHandle handle, const char *name, unsigned int val);
+NvCV_Status NvAR_SetF32(NvAR_FeatureHandle handle, const char *name, float val);
+NvCV_Status NvAR_SetString(NvAR_FeatureHandle handle, const char *name, const char *str);
+NvCV_Status NvAR_SetCudaStream(NvAR_FeatureHandle handle, const char *name, CUstream stream);
+NvCV_Status NvAR_SetObject(NvAR_FeatureHandle handle, const char *name, void *ptr, unsigned long typeSize);
+NvCV_Status NvAR_SetF32Array(NvAR_FeatureHandle handle, const char *name, float *val, int count);
+
+NvCV_Status NvAR_GetU32(NvAR_FeatureHandle handle, const char *name, unsigned int *val);
+NvCV_Status NvAR_GetObject(NvAR_FeatureHandle handle, const char *name, const void **ptr, unsigned long typeSize);
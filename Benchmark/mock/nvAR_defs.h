@@ -0,0 +1,39 @@
+#pragma once
+//  Stand-in for the NVIDIA AR SDK's nvAR_defs.h, only what the driver uses
+#include <cstdint>
+
+typedef struct nvAR_Feature *NvAR_FeatureHandle;
+typedef const char *NvAR_FeatureID;
+
+#define NvAR_Feature_BodyPoseEstimation "BodyPoseEstimation"
+
+#define NvAR_Parameter_Input(Name) "NvAR_Parameter_Input_" #Name
+#define NvAR_Parameter_Output(Name) "NvAR_Parameter_Output_" #Name
+#define NvAR_Parameter_Config(Name) "NvAR_Parameter_Config_" #Name
+
+struct NvAR_Point2f
+{
+    float x, y;
+};
+
+struct NvAR_Point3f
+{
+    float x, y, z;
+};
+
+struct NvAR_Quaternion
+{
+    float x, y, z, w;
+};
+
+struct NvAR_Rect
+{
+    float x, y, width, height;
+};
+
+struct NvAR_BBoxes
+{
+    NvAR_Rect *boxes;
+    uint8_t num_boxes;
+    uint8_t max_boxes;
+};
@@ -0,0 +1,70 @@
+#pragma once
+//  Stand-in for the NVIDIA AR SDK's nvCVImage.h, only what the driver uses
+//  Images live in host memory, Transfer is a plain copy (see CReplayBackend.cpp)
+
+typedef struct CUstream_st *CUstream;
+
+enum NvCV_Status
+{
+    NVCV_SUCCESS = 0,
+    NVCV_ERR_GENERAL = -1,
+    NVCV_ERR_PARAMETER = -6,
+    NVCV_ERR_MEMORY = -8
+};
+
+enum NvCVImage_PixelFormat
+{
+    NVCV_FORMAT_UNKNOWN = 0,
+    NVCV_Y = 1,
+    NVCV_A = 2,
+    NVCV_YA = 3,
+    NVCV_RGB = 4,
+    NVCV_BGR = 5,
+    NVCV_RGBA = 6,
+    NVCV_BGRA = 7
+};
+
+enum NvCVImage_ComponentType
+{
+    NVCV_TYPE_UNKNOWN = 0,
+    NVCV_U8 = 1,
+    NVCV_U16 = 2,
+    NVCV_S16 = 3,
+    NVCV_F16 = 4,
+    NVCV_U32 = 5,
+    NVCV_S32 = 6,
+    NVCV_F32 = 7,
+    NVCV_U64 = 8,
+    NVCV_S64 = 9,
+    NVCV_F64 = 10
+};
+
+#define NVCV_INTERLEAVED 0
+#define NVCV_CHUNKY 0
+#define NVCV_PLANAR 1
+
+#define NVCV_CPU 0
+#define NVCV_GPU 1
+#define NVCV_CUDA 1
+
+struct NvCVImage
+{
+    unsigned width;
+    unsigned height;
+    int pitch;
+    NvCVImage_PixelFormat pixelFormat;
+    NvCVImage_ComponentType componentType;
+    unsigned char pixelBytes;
+    unsigned char componentBytes;
+    unsigned char numComponents;
+    unsigned char planar;
+    unsigned char gpuMem;
+    void *pixels;
+    void *deletePtr;
+    unsigned long long bufferBytes;
+};
+
+NvCV_Status NvCVImage_Alloc(NvCVImage *im, unsigned width, unsigned height, NvCVImage_PixelFormat format,
+    NvCVImage_ComponentType type, unsigned layout, unsigned memSpace, unsigned alignment);
+void NvCVImage_Dealloc(NvCVImage *im);
+NvCV_Status NvCVImage_Transfer(const NvCVImage *src, NvCVImage *dst, float scale, CUstream stream, NvCVImage *tmp);
@@ -0,0 +1,21 @@
+#pragma once
+//  Stand-in for the NVIDIA AR SDK's nvCVOpenCV.h
+#include "nvCVImage.h"
+
+//  Wraps a BGR8 cv::Mat without copying it
+inline void NVWrapperForCVMat(const cv::Mat *cvIm, NvCVImage *nvcvIm)
+{
+    nvcvIm->width = (unsigned)cvIm->cols;
+    nvcvIm->height = (unsigned)cvIm->rows;
+    nvcvIm->pitch = (int)cvIm->step[0];
+    nvcvIm->pixelFormat = cvIm->channels() == 4 ? NVCV_BGRA : NVCV_BGR;
+    nvcvIm->componentType = NVCV_U8;
+    nvcvIm->pixelBytes = (unsigned char)cvIm->elemSize();
+    nvcvIm->componentBytes = 1u;
+    nvcvIm->numComponents = (unsigned char)cvIm->channels();
+    nvcvIm->planar = NVCV_CHUNKY;
+    nvcvIm->gpuMem = NVCV_CPU;
+    nvcvIm->pixels = cvIm->data;
+    nvcvIm->deletePtr = nullptr;
+    nvcvIm->bufferBytes = 0u;
+}
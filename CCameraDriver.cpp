@@ -36,20 +36,31 @@ void CCameraDriver::LoadCameras()
 
         device_counts++;
     }
-    m_cameraIndex = m_cameraIndex % device_counts;
+    if (device_counts > 0)
+        m_cameraIndex = m_cameraIndex % device_counts;
+    m_cameraCount = device_counts;
     vr_log("CAMERA RESET");
-    ChangeCamera(0);
 }
 
 CCameraDriver::CCameraDriver(CServerDriver *driv, float scale) : m_currentCamera(), imageChanged(), cameraChanged(), m_cameras()
 {
     m_resScale = scale;
     m_cameraIndex = 0;
+    m_cameraCount = 0;
+    m_cameraStep = 0;
+    m_fpsScale = 1.f;
     show = false;
-    m_working = true;
+    releaseInStandby = false;
+    m_parked = false;
     m_cameraInfo = nullptr;
     driver = driv;
     m_fps = 0.f;
+    m_frameTime = systime();
+    m_captureStart = 0;
+    m_frameId = 0u;
+    m_openCamera = -1;
+    m_windowName[0] = '\0';
+    m_lastFrameTime = m_frameTime;
 }
 
 CCameraDriver::~CCameraDriver()
@@ -59,29 +70,47 @@ CCameraDriver::~CCameraDriver()
 
 void CCameraDriver::DoRunFrame()
 {
-    static char buff[150];
-    static int ccam = -1;
-    static double l_time = systime();
     double cur_time = systime();
-    double clock_diff;
 
-    if (ccam != m_cameraIndex)
+    if (m_cameras.empty())
     {
-        if (ccam > 0)
+        //  Nothing was plugged in at startup, look again once the backoff allows it
+        if (m_health.ShouldReopen(cur_time))
+        {
+            LoadCameras();
+            if (m_cameras.empty())
+                m_health.OnOpenFailed(cur_time);
+        }
+        return;
+    }
+    ApplyRequests();
+
+    //  Switching cameras happens right away, reopening a lost one waits for the backoff
+    bool switching = m_openCamera != m_cameraIndex;
+    if (switching || m_health.GetState() == CAMERA_HEALTH::DISCONNECTED)
+    {
+        if (!switching && !m_health.ShouldReopen(cur_time))
+            return;
+        if (m_openCamera >= 0)
         {
             cv::destroyAllWindows();
             m_currentCamera.release();
         }
-        ccam = m_cameraIndex;
+        m_openCamera = m_cameraIndex;
         m_cameraInfo = &m_cameras[m_cameraIndex];
 
-        m_currentCamera.open(m_cameraInfo->id);
+        if (!m_currentCamera.open(m_cameraInfo->id))
+        {
+            vr_log("Unable to open camera of index %d", m_cameraInfo->id);
+            m_health.OnOpenFailed(cur_time);
+            return;
+        }
 
         m_currentCamera.set(cv::CAP_PROP_FRAME_WIDTH, GetScaledWidth());
         m_currentCamera.set(cv::CAP_PROP_FRAME_HEIGHT, GetScaledHeight());
         m_currentCamera.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'));
 
-        sprintf_s(buff, 150, "Live (Camera %d) (%dx%d)@%.1ffps", (int)m_cameraIndex, GetWidth(), GetHeight(), (float)m_currentCamera.get(CV_CAP_PROP_FPS));
+        sprintf_s(m_windowName, 150, "Live (Camera %d) (%dx%d)@%.1ffps", (int)m_cameraIndex, GetWidth(), GetHeight(), (float)m_currentCamera.get(CV_CAP_PROP_FPS));
 
         vr_log("Switching to camera of index %d (%dx%d) (%.2f fps)\n", m_cameraInfo->id, GetWidth(), GetHeight(), (float)m_currentCamera.get(CV_CAP_PROP_FPS));
 
@@ -90,52 +119,138 @@ void CCameraDriver::DoRunFrame()
         cv::destroyAllWindows();
         cv::destroyAllWindows();
 
+        m_health.OnOpened(cur_time);
         cameraChanged(*this, m_cameraIndex);
     }
 
-    if (m_currentCamera.read(m_frame) && !m_frame.empty())
+    //  read() split in two, so waiting for the camera and decoding its frame are measured apart
+    int64_t grabStart = LatencyNow();
+    bool grabbed = m_currentCamera.grab();
+    int64_t grabEnd = LatencyNow();
+    if (grabbed && m_currentCamera.retrieve(m_frame) && !m_frame.empty())
     {
+        driver->GetLatency().Record(LATENCY_STAGE::CAPTURE, grabEnd - grabStart);
+        int64_t decodeEnd = LatencyNow();
+        driver->GetLatency().Record(LATENCY_STAGE::DECODE, decodeEnd - grabEnd);
+
         cur_time = systime();
-        clock_diff = cur_time - l_time;
-        l_time = cur_time;
+        m_health.OnFrame(cur_time);
+        DeliverFrame(cur_time, grabStart);
+        driver->GetTrace().Record("Grab", m_frameId, grabStart, grabEnd);
+        driver->GetTrace().Record("Decode", m_frameId, grabEnd, decodeEnd);
+    }
+    else if (m_health.OnReadFailed(cur_time))
+    {
+        //  Unplugged (or taken by another application), closed until the backoff allows a reopen
+        cv::destroyAllWindows();
+        m_currentCamera.release();
+    }
+}
 
-        m_fps = 1.f / clock_diff;
-        if (show) {
+void CCameraDriver::DeliverFrame(double time, int64_t captureStart)
+{
+    m_captureStart = captureStart;
+    m_frameId++;
 
-            cv::imshow(buff, m_frame);
-        }
-        imageChanged(*this, m_frame);
+    double clock_diff = time - m_lastFrameTime;
+    m_lastFrameTime = time;
+    m_frameTime = time;
+
+    m_fps = (float)(1. / clock_diff);
+    if (show) {
+
+        cv::imshow(m_windowName, m_frame);
     }
+    imageChanged(*this, m_frame);
+}
+
+void CCameraDriver::InjectFrame(const cv::Mat &frame, double time)
+{
+    m_frame = frame;
+    DeliverFrame(time, LatencyNow());
 }
 
-void CCameraDriver::RunAsync()
+void CCameraDriver::RunAsync(const CStopToken &token)
 {
-    m_working = true;
+    ApplyThreadPlacement(driver->GetThreadPlacement(THREAD_ROLE::CAMERA), THREAD_ROLE::CAMERA);
     vr_log("Initializing main camera loop");
-    while (m_working)
+    while (!token.StopRequested())
     {
+        if (m_parked)
+        {
+            Park(token);
+            continue;
+        }
         DoRunFrame();
-        cv::waitKey(1);
+        //  Sleep through failed reads and reopen backoffs instead of spinning on a missing device
+        double idle = m_health.GetIdleTime(systime());
+        if (idle > 0.0)
+        {
+            if (!token.SleepFor(idle))
+                break;
+        }
+        else
+        {
+            cv::waitKey(1);
+        }
     }     
 
     cv::destroyAllWindows();
     m_currentCamera.release();
 }
 
+void CCameraDriver::Park(const CStopToken &token)
+{
+    vr_log("Camera thread parked%s", releaseInStandby ? ", camera released" : "");
+    if (releaseInStandby && m_openCamera >= 0)
+    {
+        cv::destroyAllWindows();
+        m_currentCamera.release();
+        //  Forces DoRunFrame to reopen it right away on resume, without waiting for a health backoff
+        m_openCamera = -1;
+    }
+
+    //  Nothing is captured or inferred while parked, the thread only checks back a few times a second
+    while (m_parked && token.SleepFor(CAMERA_PARK_POLL))
+        ;
+    m_health.OnResumed();
+    vr_log("Camera thread resumed");
+}
+
 void CCameraDriver::ChangeCamera(int up)
 {
-    if(m_cameras.size() > 0)
+    m_cameraStep.fetch_add(up, std::memory_order_relaxed);
+}
+
+void CCameraDriver::SetFps(float mult)
+{
+    float scale = m_fpsScale.load(std::memory_order_relaxed);
+    while (!m_fpsScale.compare_exchange_weak(scale, scale * mult, std::memory_order_relaxed))
+        ;
+}
+
+void CCameraDriver::ApplyRequests()
+{
+    int step = m_cameraStep.exchange(0, std::memory_order_relaxed);
+    int count = (int)m_cameras.size();
+    if (step != 0 && count > 0)
     {
-        m_cameraIndex = (m_cameraIndex + up) % m_cameras.size();
+        //  Kept in int, so stepping back from the first camera lands on the last one
+        int index = (m_cameraIndex + step) % count;
+        m_cameraIndex = index < 0 ? index + count : index;
     }
+
+    float scale = m_fpsScale.exchange(1.f, std::memory_order_relaxed);
+    if (scale != 1.f && m_openCamera >= 0)
+        m_currentCamera.set(CV_CAP_PROP_FPS, m_currentCamera.get(CV_CAP_PROP_FPS) * scale);
 }
 
 void CCameraDriver::Cleanup()
 {
     //cv::destroyAllWindows();
-    m_working = false;
     //m_currentCamera.release();
     m_cameras.clear();
+    m_cameraCount = 0;
 
     cv::destroyAllWindows();
     m_currentCamera.release();
@@ -1,5 +1,7 @@
 #pragma once
 #include "CCallback.cpp"
+#include "CManagedThread.h"
+#include "CCameraHealth.h"
 
 struct CameraInfo
 {
@@ -16,29 +18,65 @@ class CCameraDriver
     CameraInfo *m_cameraInfo;
     std::atomic<int> m_cameraIndex;
     cv::Mat m_frame;
+    //  Only touched by the camera thread once it runs, other threads go through m_cameraCount and the requests below
     std::vector<CameraInfo> m_cameras;
-    std::atomic<bool> m_working;
+    std::atomic<int> m_cameraCount;
+    //  Requested from the SteamVR thread (the hotkeys), applied by the camera thread before its next frame:
+    //  cameras to step through, and the factor to scale the capture rate by
+    std::atomic<int> m_cameraStep;
+    std::atomic<float> m_fpsScale;
+
+    //  The camera currently opened by DoRunFrame (-1 when none), and the title of its preview window
+    int m_openCamera;
+    char m_windowName[150];
+    //  Timestamp of the previous frame, used for the fps estimate
+    double m_lastFrameTime;
+    //  Decides when a lost camera is reopened, and how long the thread sleeps meanwhile
+    CCameraHealth m_health;
+    //  Set while SteamVR is in standby, capture and inference stop until it is cleared
+    std::atomic<bool> m_parked;
+
+    void Park(const CStopToken &token);
+    //  Carry out the camera switch and capture rate change requested since the last frame
+    void ApplyRequests();
+    //  Bookkeeping for a frame that is now in m_frame, then hands it to imageChanged
+    void DeliverFrame(double time, int64_t captureStart);
 
     void Cleanup();
 protected:
     float m_resScale;
-    float m_fps;
+    std::atomic<float> m_fps;
+    //  Timestamp (systime) at which the current frame was read from the camera
+    double m_frameTime;
+    //  When grabbing the current frame started (LatencyNow)
+    int64_t m_captureStart;
+    //  Frames read since startup, ties the trace spans of one frame together across threads
+    uint64_t m_frameId;
     friend class CServerDriver;
+    friend class CDriverTestAccess;
 public:
     bool show;
+    //  Close the camera while parked, it is reopened (and the SDK image buffers reloaded) as soon as the thread resumes
+    bool releaseInStandby;
 
     CCameraDriver(CServerDriver *driv, float scale = 1.0);
     ~CCameraDriver();
 
     void LoadCameras();
-    void RunAsync();
+    //  Camera thread body, returns once a stop is requested
+    void RunAsync(const CStopToken &token);
     void DoRunFrame();
 
+    //  Step the camera index by up (wrapping both ways), from any thread
     void ChangeCamera(int up = 1);
+    //  Hand over a frame that did not come from the capture device (replays, the benchmark) as if it had just been read
+    void InjectFrame(const cv::Mat &frame, double time);
+    inline void SetParked(bool parked) { m_parked = parked; }
 
     inline const cv::Mat GetImage() const { return m_frame; }
-    inline const float GetFps() const { return m_cameras.size() > 0 ? m_fps : 0.f; }
-    inline void SetFps(float mult = 1.0) { m_currentCamera.set(CV_CAP_PROP_FPS, m_currentCamera.get(CV_CAP_PROP_FPS) * mult); }
+    inline const float GetFps() const { return m_cameraCount.load(std::memory_order_relaxed) > 0 ? m_fps.load(std::memory_order_relaxed) : 0.f; }
+    //  Scale the capture rate of the open camera, from any thread
+    void SetFps(float mult = 1.0);
 
     inline int GetWidth() const { return m_cameras[m_cameraIndex].width; }
     inline int GetHeight() const { return m_cameras[m_cameraIndex].height; }
@@ -46,6 +84,11 @@ public:
     inline int GetScaledHeight() const { return (int)(GetHeight() * m_resScale); }
     inline float GetScale() const { return m_resScale; }
     inline int GetIndex() const { return m_cameraIndex; }
+    inline double GetFrameTime() const { return m_frameTime; }
+    inline int64_t GetCaptureStart() const { return m_captureStart; }
+    inline uint64_t GetFrameId() const { return m_frameId; }
+    inline CAMERA_HEALTH GetHealth() const { return m_health.GetState(); }
+    inline uint64_t GetStalls() const { return m_health.GetStalls(); }
 
     inline cv::VideoCaptureModes const GetMode() { return (cv::VideoCaptureModes)(int)m_currentCamera.get(CV_CAP_PROP_MODE); }
 
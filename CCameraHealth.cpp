@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "CCameraHealth.h"
+#include "CCommon.h"
+
+const char *CameraHealthName[] = {
+    "Closed",
+    "Healthy",
+    "Stalled",
+    "Disconnected"
+};
+
+CCameraHealth::CCameraHealth()
+{
+    m_state = CAMERA_HEALTH::CLOSED;
+    m_failedReads = 0u;
+    m_lastFrame = -1.0;
+    m_interval = 0.0;
+    m_backoff = CAMERA_BACKOFF_MIN;
+    m_nextAttempt = 0.0;
+    m_frames = 0u;
+    m_readFailures = 0u;
+    m_stalls = 0u;
+    m_disconnects = 0u;
+    m_reopens = 0u;
+}
+
+void CCameraHealth::Transition(CAMERA_HEALTH state, double now)
+{
+    CAMERA_HEALTH previous = m_state.exchange(state, std::memory_order_relaxed);
+    if (previous == state)
+        return;
+    vr_log(
+        "Camera %s -> %s at %.2f s (%llu frames, %llu failed reads, %llu stalls, %llu disconnects)",
+        CameraHealthName[(int)previous],
+        CameraHealthName[(int)state],
+        now,
+        (unsigned long long)m_frames,
+        (unsigned long long)m_readFailures,
+        (unsigned long long)GetStalls(),
+        (unsigned long long)m_disconnects
+    );
+}
+
+void CCameraHealth::ScheduleReopen(double now)
+{
+    m_nextAttempt = now + m_backoff;
+    m_backoff = (std::min)(m_backoff * 2.0, CAMERA_BACKOFF_MAX);
+}
+
+void CCameraHealth::OnOpened(double now)
+{
+    if (GetState() != CAMERA_HEALTH::CLOSED)
+        m_reopens++;
+    m_failedReads = 0u;
+    m_lastFrame = -1.0;
+    m_interval = 0.0;
+    //  The backoff only resets once frames actually arrive, a device that opens but never delivers keeps backing off
+    Transition(CAMERA_HEALTH::HEALTHY, now);
+}
+
+void CCameraHealth::OnOpenFailed(double now)
+{
+    ScheduleReopen(now);
+    Transition(CAMERA_HEALTH::DISCONNECTED, now);
+}
+
+void CCameraHealth::OnFrame(double now)
+{
+    m_frames++;
+    m_failedReads = 0u;
+    m_backoff = CAMERA_BACKOFF_MIN;
+
+    if (m_lastFrame >= 0.0)
+    {
+        double interval = now - m_lastFrame;
+        if (m_interval > 0.0 && interval > m_interval * CAMERA_STALL_FACTOR)
+        {
+            //  Reported as a blip, the stall is over now that this frame arrived
+            m_stalls++;
+            Transition(CAMERA_HEALTH::STALLED, now);
+        }
+        //  Still averaged in, so a camera that was deliberately slowed down stops counting as stalled
+        m_interval = m_interval > 0.0 ? m_interval + (interval - m_interval) * CAMERA_INTERVAL_SMOOTHING : interval;
+    }
+    m_lastFrame = now;
+    Transition(CAMERA_HEALTH::HEALTHY, now);
+}
+
+bool CCameraHealth::OnReadFailed(double now)
+{
+    m_readFailures++;
+    m_failedReads++;
+    if (m_failedReads < CAMERA_FAILED_READS)
+    {
+        m_nextAttempt = now + CAMERA_READ_RETRY;
+        return false;
+    }
+
+    m_disconnects++;
+    m_failedReads = 0u;
+    ScheduleReopen(now);
+    Transition(CAMERA_HEALTH::DISCONNECTED, now);
+    return true;
+}
+
+bool CCameraHealth::ShouldReopen(double now) const
+{
+    CAMERA_HEALTH state = GetState();
+    return (state == CAMERA_HEALTH::CLOSED || state == CAMERA_HEALTH::DISCONNECTED) && now >= m_nextAttempt;
+}
+
+double CCameraHealth::GetIdleTime(double now) const
+{
+    if (GetState() != CAMERA_HEALTH::DISCONNECTED && m_failedReads == 0u)
+        return 0.0;
+    return (std::max)(m_nextAttempt - now, 0.0);
+}
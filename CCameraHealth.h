@@ -0,0 +1,68 @@
+#pragma once
+
+//  Consecutive failed reads before the camera is considered disconnected
+#define CAMERA_FAILED_READS 15
+//  Pause after a single failed read (seconds), so a failing device is never polled in a tight loop
+#define CAMERA_READ_RETRY 0.01
+//  A frame interval this many times the average counts as a stall
+#define CAMERA_STALL_FACTOR 4.0
+//  Weight given to each new frame interval in the running average
+#define CAMERA_INTERVAL_SMOOTHING 0.1
+//  Delay before the first reopen attempt, doubled after every failed one up to the maximum (seconds)
+#define CAMERA_BACKOFF_MIN 0.25
+#define CAMERA_BACKOFF_MAX 8.0
+//  How often a parked camera thread checks whether standby ended (seconds)
+#define CAMERA_PARK_POLL 0.05
+
+//  State of the capture device as seen by the camera thread
+enum class CAMERA_HEALTH
+{
+    CLOSED,
+    HEALTHY,
+    STALLED,
+    DISCONNECTED
+};
+extern const char *CameraHealthName[];
+
+//  Tracks read failures, frame interval anomalies and disconnects of the capture device
+//  Decides when a lost device is reopened (exponential backoff) and how long the camera thread sleeps meanwhile
+//  Only the camera thread calls into it, the state is atomic so other threads can read it
+class CCameraHealth
+{
+    std::atomic<CAMERA_HEALTH> m_state;
+    unsigned m_failedReads;
+    double m_lastFrame;
+    double m_interval;
+    double m_backoff;
+    double m_nextAttempt;
+
+    uint64_t m_frames;
+    uint64_t m_readFailures;
+    //  Read by the stats export as well
+    std::atomic<uint64_t> m_stalls;
+    uint64_t m_disconnects;
+    uint64_t m_reopens;
+
+    void Transition(CAMERA_HEALTH state, double now);
+    void ScheduleReopen(double now);
+public:
+    CCameraHealth();
+
+    void OnOpened(double now);
+    void OnOpenFailed(double now);
+    void OnFrame(double now);
+    //  Returns true once the device is considered gone and must be closed
+    bool OnReadFailed(double now);
+    //  Frames stopped on purpose (standby), the gap to the next one is not a stall
+    inline void OnResumed() { m_lastFrame = -1.0; }
+
+    //  A closed or lost device whose backoff has elapsed
+    bool ShouldReopen(double now) const;
+    //  How long the camera thread may sleep before its next attempt (0 while the device is healthy)
+    double GetIdleTime(double now) const;
+
+    inline CAMERA_HEALTH GetState() const { return m_state.load(std::memory_order_relaxed); }
+    inline uint64_t GetStalls() const { return m_stalls.load(std::memory_order_relaxed); }
+    inline uint64_t GetDisconnects() const { return m_disconnects; }
+    inline uint64_t GetReopens() const { return m_reopens; }
+};
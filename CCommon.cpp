@@ -1,8 +1,6 @@
 #include "pch.h"
 #include "CCommon.h"
 
-char logging_buffer[LOG_BUFFER_SIZE] = { NULL };
-
 const char *BodyJointName[] = {
     "Pelvis",
     "Left Hip",
@@ -1,21 +1,25 @@
 #pragma once
+#include "CLogger.h"
 
 #define M_PI 3.14159265358979323846f
 
+#ifdef _WIN32
 #define systime() ((double)clock() / CLOCKS_PER_SEC)
-
-//  The maximum size for our log buffer
-#define LOG_BUFFER_SIZE 1000
-
-//  General logging buffer used to report to vrserver.txt
-char logging_buffer[];
+#else
+//  clock() is processor time rather than wall time outside Windows
+#define systime() (std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count())
+#endif
 
 //  Shorthand for logging to vrserver.txt
+//  Formatted on the calling thread and written out by g_logger's thread, repeats of one format string are rate limited
 template<class... T>
 inline void vr_log(const char *fmt, const T&... args)
 {
-    sprintf_s(logging_buffer, LOG_BUFFER_SIZE, fmt, args...);
-    vr::VRDriverLog()->Log(logging_buffer);
+    if (!g_logger.Admit(fmt))
+        return;
+    char *buffer = vr_log_buffer();
+    sprintf_s(buffer, LOG_BUFFER_SIZE, fmt, args...);
+    g_logger.Post(buffer);
 }
 
 //  Delete a pointer safely
@@ -64,8 +68,10 @@ enum class BODY_JOINT
     LEFT_THUMB_TIP,
     RIGHT_THUMB_TIP
 };
+//  The number of body joints
+#define BODY_JOINT_COUNT ((size_t)BODY_JOINT::RIGHT_THUMB_TIP + 1u)
 //  The name of the associated body joints
-const char *BodyJointName[];
+extern const char *BodyJointName[];
 
 //  The roles body trackers will be able to play
 enum class TRACKER_ROLE
@@ -87,7 +93,7 @@ enum class TRACKER_ROLE
     RIGHT_HAND
 };
 //  The name of the associated roles
-const char *TrackerRoleName[];
+extern const char *TrackerRoleName[];
 
 //  Flags used to indicate which tracking modes are applicable / enabled
 enum class TRACKING_FLAG
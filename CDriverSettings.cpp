@@ -3,6 +3,7 @@
 #include "CServerDriver.h"
 #include "CNvSDKInterface.h"
 #include "CCameraDriver.h"
+#include "CThreadTopology.h"
 
 extern char g_modulePath[];
 
@@ -136,4 +137,25 @@ const Proportions CDriverSettings::GetConfigProportions(const char *section, con
     result.chestOffset  = GetConfigFloat(section, KEY_CHEST_POS, def.chestOffset);
     result.footOffset   = GetConfigFloat(section, KEY_FOOT_POS, def.footOffset);
     return result;
-}
\ No newline at end of file
+}
+
+const ThreadPlacement CDriverSettings::GetConfigThreadPlacement(const char *section, THREAD_ROLE role, const ThreadPlacement &def) const
+{
+    ThreadPlacement result = def;
+    std::string prefix = ThreadRoleName[(int)role];
+
+    //  Parsed by hand so hexadecimal masks and all 64 bits are accepted
+    const char *affinity = GetConfigCString(section, (prefix + KEY_THREAD_AFFINITY).c_str(), nullptr);
+    if (affinity != nullptr)
+        result.affinity = std::strtoull(affinity, nullptr, 0);
+
+    std::string priority = GetConfigString(section, (prefix + KEY_THREAD_PRIORITY).c_str(), "");
+    for (int level = 0; level <= (int)THREAD_PRIORITY::TIME_CRITICAL; level++)
+    {
+        if (priority == ThreadPriorityName[level])
+            result.priority = (THREAD_PRIORITY)level;
+    }
+
+    result.realtime = GetConfigBoolean(section, (prefix + KEY_THREAD_REALTIME).c_str(), def.realtime);
+    return result;
+}
@@ -37,6 +37,8 @@
 #define KEY_CAM_INDEX "Index"
 //  Whether or not the camera should be mirrored
 #define KEY_CAM_MIRROR "Mirrored"
+//  Whether the camera is closed while SteamVR is in standby (bool)
+#define KEY_CAM_RELEASE "ReleaseInStandby"
 
 //  Tracking scale on X, Y, and Z axis
 #define SECTION_TRACK_SCALE "TrackingScale"
@@ -55,6 +57,10 @@
 #define KEY_BATCH_SZ "BatchSize"
 //  NV AR mode (int)
 #define KEY_NVAR "NVARMode"
+//  Inference rate (Hz) while nobody is in frame, 0 always runs on every frame (float)
+#define KEY_PROBE_RATE "ProbeRate"
+//  Frames without a body before dropping to the probe rate (int)
+#define KEY_PROBE_AFTER "ProbeAfter"
 
 
 //  Which m_trackers are enabled currently
@@ -101,6 +107,18 @@
 //  Immediate frame caching
 #define KEY_CACHE_IMMEDIATE "ImmediateCache"
 
+//  Let SteamVR predict poses from the estimated velocities instead of interpolating every frame (bool)
+#define KEY_POSE_PREDICTION "PosePrediction"
+//  Date poses by the motion latency estimated from the controllers, so SteamVR predicts over the whole delay (bool)
+#define KEY_LATENCY_COMPENSATION "LatencyCompensation"
+
+//  Smallest movement (meters) that makes a tracker submit a new pose
+#define KEY_SUBMIT_DIST "SubmitDistance"
+//  Smallest rotation (degrees) that makes a tracker submit a new pose
+#define KEY_SUBMIT_ANGLE "SubmitAngle"
+//  Lowest rate (Hz) unchanged poses are still submitted at, 0 to never resubmit them
+#define KEY_KEEP_ALIVE "KeepAliveRate"
+
 //  The offset of the elbow trackers
 #define KEY_ELBOW_POS "ElbowTrackerPosition"
 //  The offset of the knee trackers
@@ -113,6 +131,36 @@
 #define KEY_FOOT_POS "FootTrackerPosition"
 
 
+//  Thread placement section, each key is prefixed with the thread's name (Camera, Publisher, Input)
+#define SECTION_THREADS "ThreadTopology"
+//  Cores the thread may run on as a bit mask, e.g. 0x2 for the second core (0 = any)
+#define KEY_THREAD_AFFINITY "Affinity"
+//  Thread priority (One of [Idle, Lowest, BelowNormal, Normal, AboveNormal, Highest, TimeCritical])
+#define KEY_THREAD_PRIORITY "Priority"
+//  Request real-time scheduling (bool)
+#define KEY_THREAD_REALTIME "Realtime"
+
+
+//  Pipeline tracing section, Ctrl + P writes the recorded spans as Chrome trace JSON
+#define SECTION_TRACE "Tracing"
+//  Record pipeline spans (bool)
+#define KEY_TRACE_ON "Enabled"
+//  Spans kept in the ring, the oldest are overwritten (int)
+#define KEY_TRACE_CAPACITY "Capacity"
+
+
+//  Session recording section, files are written next to settings.ini
+#define SECTION_RECORD "Recording"
+//  Write the raw SDK output of every inference frame to a keypoint trace (bool)
+#define KEY_RECORD_KEYPOINTS "Keypoints"
+//  Quantize the keypoint trace into delta coded pose packets, about a third of the size (bool)
+#define KEY_RECORD_ENCODED "EncodeKeypoints"
+//  Write every camera frame to an MJPEG video, with the frame ids and capture times alongside (bool)
+#define KEY_RECORD_VIDEO "Video"
+//  Frame rate in the video header, players use it but the real capture times are in the .csv (float)
+#define KEY_RECORD_VIDEO_FPS "VideoFPS"
+
+
 //  Zero
 #define C_0 "0"
 
@@ -120,6 +168,8 @@ class CServerDriver;
 
 enum class TRACKING_FLAG;
 enum class TRACKER_ROLE;
+enum class THREAD_ROLE;
+struct ThreadPlacement;
 
 //  The interpolation mode for the tracker
 enum class INTERP_MODE
@@ -130,7 +180,7 @@ enum class INTERP_MODE
     QUAD,
     CUBIC
 };
-const char *InterpModeName[];
+extern const char *InterpModeName[];
 
 //  Used to store the proportional information from the config file
 struct Proportions
@@ -164,8 +214,8 @@ public:
     CDriverSettings();
     ~CDriverSettings();
 
-    inline int GetConfigInteger(const char *section, const char *key, int def = 0) const { return atoi(m_iniFile.GetValue(section, key, C_0)); }
-    inline float GetConfigFloat(const char *section, const char *key, float def = 0.0f) const { return (float)m_iniFile.GetDoubleValue(section, key, 0.0); }
+    inline int GetConfigInteger(const char *section, const char *key, int def = 0) const { return (int)m_iniFile.GetLongValue(section, key, def); }
+    inline float GetConfigFloat(const char *section, const char *key, float def = 0.0f) const { return (float)m_iniFile.GetDoubleValue(section, key, def); }
     glm::vec3 GetConfigVector(const char *section, const glm::vec3 &def=glm::vec3(0.f, 0.f, 0.f)) const;
     glm::quat GetConfigQuaternion(const char *section, const glm::quat &def = glm::quat(0.f, 0.f, 0.f, 0.f)) const;
     inline  bool GetConfigBoolean(const char *section, const char *key, bool def = false) const { return m_iniFile.GetBoolValue(section, key, def); }
@@ -185,6 +235,7 @@ public:
 
     INTERP_MODE GetConfigInterpolationMode(const char *section, const char *key, INTERP_MODE def = INTERP_MODE::NONE) const;
     const Proportions GetConfigProportions(const char *section, const Proportions &def = Proportions()) const;
+    const ThreadPlacement GetConfigThreadPlacement(const char *section, THREAD_ROLE role, const ThreadPlacement &def) const;
 
     /// <summary>
     /// Update the configuration data with information from a source <b>CServerDriver</b>
@@ -0,0 +1,109 @@
+#pragma once
+
+//  Shared between the driver, which writes the block, and the overlay, which shows it; only fixed size types, no pointers
+//  Name of the shared memory mapping, per session so another user's driver is never read
+#define DRIVER_STATS_MAPPING "Local\\NvidiaBodyTrackingStats"
+//  Bumped whenever the layout of DriverStats changes, the overlay ignores a block of any other version
+#define DRIVER_STATS_VERSION 3u
+//  How often the driver writes the block (seconds)
+#define DRIVER_STATS_INTERVAL 0.25
+//  Entries the block has room for, and the length of their names (with the terminator)
+#define DRIVER_STATS_STAGES 8
+#define DRIVER_STATS_TRACKERS 16
+#define DRIVER_STATS_NAME_SIZE 24
+//  Tries a reader makes before giving up on a block that keeps changing under it
+#define DRIVER_STATS_READ_TRIES 8
+
+//  Percentiles of one pipeline stage over DriverStats::stageWindow (milliseconds)
+struct DriverStageStats
+{
+    char name[DRIVER_STATS_NAME_SIZE];
+    float p50;
+    float p95;
+    float p99;
+};
+
+struct DriverTrackerStats
+{
+    char name[DRIVER_STATS_NAME_SIZE];
+    //  Of the joints the tracker follows, in the newest inference
+    float confidence;
+    //  Failed its confidence check, shown to SteamVR as disconnected
+    uint8_t standby;
+};
+
+//  What the driver is doing, as of its latest write
+struct DriverStats
+{
+    //  Writes so far, a reader that sees it stop moving knows the driver is gone
+    uint64_t updates;
+
+    //  Camera frames delivered and inferences run per second, over the last interval
+    float captureFps;
+    float inferenceFps;
+    //  Inference time of a camera frame, every batch included, over the last interval (milliseconds)
+    float inferenceMs;
+    //  Share of the wall time the camera thread spent in GPU uploads and inference over the last interval
+    //  The SDK runs synchronously, so this is how busy this driver keeps the GPU at most
+    float gpuShare;
+    //  How far the wrists trail the controllers (milliseconds), negative while there is no estimate
+    float motionLatencyMs;
+
+    //  SteamVR standby, nobody in frame (inference only probes), and the camera state name
+    uint8_t standby;
+    uint8_t probing;
+    char cameraState[DRIVER_STATS_NAME_SIZE];
+
+    //  Totals since startup: camera stalls, frames not inferred while probing, frames and keypoint records the session
+    //  recorder could not queue, and display frames the publisher fell a whole period behind on
+    uint64_t cameraStalls;
+    uint64_t framesSkipped;
+    uint64_t recorderFramesDropped;
+    uint64_t recorderRecordsDropped;
+    uint64_t publisherOverruns;
+    //  Seconds since startup spent tracking a body and probing for one
+    double trackingTime;
+    double probingTime;
+
+    //  Seconds the stage percentiles cover: the last closed latency window, 0 while they still cover everything since startup
+    float stageWindow;
+    uint32_t stageCount;
+    DriverStageStats stages[DRIVER_STATS_STAGES];
+    uint32_t trackerCount;
+    DriverTrackerStats trackers[DRIVER_STATS_TRACKERS];
+};
+
+//  The shared memory itself, guarded by a sequence lock: the writer makes the sequence odd, writes, and makes it even
+//  again; a reader copies the stats and only keeps the copy when the sequence was the same even value on both ends
+//  The writer never waits for readers, a reader that keeps losing the race simply tries again on its next refresh
+struct DriverStatsBlock
+{
+    uint32_t version;
+    std::atomic<uint32_t> sequence;
+    DriverStats stats;
+
+    inline void Write(const DriverStats &value)
+    {
+        //  Rounded down, a writer that died half way must not leave the sequence odd for good
+        uint32_t start = sequence.load(std::memory_order_relaxed) & ~1u;
+        sequence.store(start + 1u, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&stats, &value, sizeof(DriverStats));
+        sequence.store(start + 2u, std::memory_order_release);
+    }
+
+    inline bool Read(DriverStats &value) const
+    {
+        for (int attempt = 0; attempt < DRIVER_STATS_READ_TRIES; attempt++)
+        {
+            uint32_t start = sequence.load(std::memory_order_acquire);
+            if ((start & 1u) != 0u)
+                continue;
+            memcpy(&value, &stats, sizeof(DriverStats));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == start)
+                return true;
+        }
+        return false;
+    }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+//  Bounded queue from one producer thread to one consumer thread (a ring buffer)
+//  Push and Pop never block or allocate, a full queue drops the new event and counts it
+//  N must be a power of two
+template<class T, size_t N>
+class CEventQueue
+{
+    static_assert(N > 1u && (N & (N - 1u)) == 0u, "Queue capacity must be a power of two");
+
+    T m_events[N];
+    //  Next slot to read (owned by the consumer) and to write (owned by the producer)
+    std::atomic<size_t> m_head;
+    std::atomic<size_t> m_tail;
+    std::atomic<uint64_t> m_dropped;
+
+    CEventQueue(const CEventQueue &that) = delete;
+    CEventQueue &operator=(const CEventQueue &that) = delete;
+public:
+    CEventQueue() : m_events(), m_head(0u), m_tail(0u), m_dropped(0u) {}
+
+    //  Producer
+    inline bool Push(const T &value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= N)
+        {
+            m_dropped.fetch_add(1u, std::memory_order_relaxed);
+            return false;
+        }
+        m_events[tail & (N - 1u)] = value;
+        m_tail.store(tail + 1u, std::memory_order_release);
+        return true;
+    }
+
+    //  Consumer
+    inline bool Pop(T &value)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        value = m_events[head & (N - 1u)];
+        m_head.store(head + 1u, std::memory_order_release);
+        return true;
+    }
+
+    inline uint64_t GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,37 @@
+#include "pch.h"
+#include "CInterpolator.h"
+#include "CDriverSettings.h"
+
+//  One entry per supported depth, from 2 up to TRANSFORM_HISTORY_MAX
+template<class Ease, size_t... Index>
+static InterpolatorFn SelectDepth(size_t depth, std::index_sequence<Index...>)
+{
+    static const InterpolatorFn table[] = { &Interpolate<Ease, Index + 2>... };
+    return table[depth - 2];
+}
+
+template<class Ease>
+static InterpolatorFn SelectDepth(size_t depth)
+{
+    return SelectDepth<Ease>(depth, std::make_index_sequence<TRANSFORM_HISTORY_MAX - 1>());
+}
+
+InterpolatorFn SelectInterpolator(INTERP_MODE mode, size_t depth)
+{
+    if (depth < 2 || depth > TRANSFORM_HISTORY_MAX)
+        return &InterpolatePassthrough;
+
+    switch (mode)
+    {
+    case INTERP_MODE::LINEAR:
+        return SelectDepth<EaseLinear>(depth);
+    case INTERP_MODE::SINE:
+        return SelectDepth<EaseSine>(depth);
+    case INTERP_MODE::QUAD:
+        return SelectDepth<EaseQuad>(depth);
+    case INTERP_MODE::CUBIC:
+        return SelectDepth<EaseCubic>(depth);
+    default:
+        return &InterpolatePassthrough;
+    }
+}
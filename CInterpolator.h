@@ -0,0 +1,64 @@
+#pragma once
+#include "CCommon.h"
+#include "CTransformHistory.h"
+
+enum class INTERP_MODE;
+
+//  Interpolates every tracker of a bank in one pass
+//  output holds the transforms last given to SteamVR and is blended in place, targets are the newest samples
+//  t is the progress towards the next camera sample, shared by all trackers
+typedef void (*InterpolatorFn)(const CTransformHistory &history, const TransformLanes &targets, TransformLanes &output, float t);
+
+//  Easing curves matching the INTERP_MODE values, written as polynomials so nothing transcendental runs per frame
+struct EaseLinear
+{
+    static inline float Apply(float t) { return t; }
+};
+struct EaseSine
+{
+    //  -(cos(pi * t) - 1) / 2 == (1 + sin(pi * (t - 0.5))) / 2, folded onto [-0.5, 0.5] and expanded to the 9th order
+    static inline float Apply(float t)
+    {
+        float x = t - 0.5f;
+        x = (std::min)(x, 1.f - x);
+        float y = (float)M_PI * x;
+        float y2 = y * y;
+        return 0.5f + 0.5f * y * (1.f + y2 * (-1.f / 6.f + y2 * (1.f / 120.f + y2 * (-1.f / 5040.f + y2 * (1.f / 362880.f)))));
+    }
+};
+struct EaseQuad
+{
+    static inline float Apply(float t)
+    {
+        float u = 2.f - 2.f * t;
+        return t < 0.5f ? 2.f * t * t : 1.f - u * u / 2.f;
+    }
+};
+struct EaseCubic
+{
+    static inline float Apply(float t)
+    {
+        float u = 2.f - 2.f * t;
+        return t < 0.5f ? 4.f * t * t * t : 1.f - u * u * u / 2.f;
+    }
+};
+
+//  Used when interpolation is disabled or the cache is too short to interpolate over
+inline void InterpolatePassthrough(const CTransformHistory &history, const TransformLanes &targets, TransformLanes &output, float t)
+{
+    output = targets;
+}
+
+//  Interpolation for an easing curve and a history of exactly N samples
+template<class Ease, size_t N>
+inline void Interpolate(const CTransformHistory &history, const TransformLanes &targets, TransformLanes &output, float t)
+{
+    float eased = Ease::Apply(t);
+    TransformLanes evaluated;
+    history.Evaluate<N>(eased, evaluated);
+    TransformLanes::LerpPositions(output, evaluated, eased * 0.5f, output, history.Lanes());
+    TransformLanes::NlerpRotations(output, evaluated, eased * 0.5f, output, history.Lanes());
+}
+
+//  Pick the instantiation for a mode and history depth, meant to be called once when the tracker bank is set up
+InterpolatorFn SelectInterpolator(INTERP_MODE mode, size_t depth);
@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "CKeySource.h"
+#include "CCommon.h"
+
+CKeySource *CKeySource::Create()
+{
+#ifdef _WIN32
+    return new CKeyboardHook();
+#else
+    return new CScriptedKeySource();
+#endif
+}
+
+#ifdef _WIN32
+std::atomic<CKeyboardHook *> CKeyboardHook::ms_instance(nullptr);
+
+CKeyboardHook::CKeyboardHook() : m_down()
+{
+    m_thread = nullptr;
+    m_threadId = 0u;
+}
+
+CKeyboardHook::~CKeyboardHook()
+{
+    Stop();
+}
+
+bool CKeyboardHook::Start()
+{
+    CKeyboardHook *expected = nullptr;
+    if (m_thread != nullptr || !ms_instance.compare_exchange_strong(expected, this))
+        return false;
+
+    //  The hook has to be installed on the thread that pumps its messages
+    std::promise<bool> started;
+    std::future<bool> result = started.get_future();
+    //  GetMessage never sees the stop token, so stopping also ends the message loop
+    m_thread = new CManagedThread(
+        "Input",
+        [this, &started](const CStopToken &) { Run(&started); },
+        [this]() { PostThreadMessage(m_threadId, WM_QUIT, 0, 0); }
+    );
+    if (result.get())
+        return true;
+
+    delptr(m_thread);
+    ms_instance = nullptr;
+    return false;
+}
+
+void CKeyboardHook::Stop()
+{
+    if (m_thread == nullptr)
+        return;
+    //  Deleting requests the stop and waits (bounded) for the message loop to end
+    delptr(m_thread);
+    ms_instance = nullptr;
+}
+
+void CKeyboardHook::Run(std::promise<bool> *started)
+{
+    ApplyThreadPlacement(m_placement, THREAD_ROLE::INPUT);
+
+    MSG msg;
+    //  Create the message queue before anyone can post WM_QUIT to it
+    PeekMessage(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    m_threadId = GetCurrentThreadId();
+
+    HHOOK hook = SetWindowsHookEx(WH_KEYBOARD_LL, HookProc, GetModuleHandle(nullptr), 0);
+    started->set_value(hook != nullptr);
+    if (hook == nullptr)
+        return;
+
+    while (GetMessage(&msg, nullptr, 0, 0) > 0)
+    {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    UnhookWindowsHookEx(hook);
+}
+
+LRESULT CALLBACK CKeyboardHook::HookProc(int code, WPARAM wParam, LPARAM lParam)
+{
+    //  Runs on the hook thread for every key in the system, so it only records the transition
+    CKeyboardHook *hook = ms_instance.load(std::memory_order_acquire);
+    if (code == HC_ACTION && hook != nullptr)
+    {
+        const KBDLLHOOKSTRUCT *info = reinterpret_cast<const KBDLLHOOKSTRUCT *>(lParam);
+        if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN)
+            hook->OnKey((int)info->vkCode, true);
+        else if (wParam == WM_KEYUP || wParam == WM_SYSKEYUP)
+            hook->OnKey((int)info->vkCode, false);
+    }
+    return CallNextHookEx(nullptr, code, wParam, lParam);
+}
+
+void CKeyboardHook::OnKey(int key, bool down)
+{
+    if (key < 0 || key >= KEY_CODE_COUNT || m_down[key] == down)
+        return;
+    m_down[key] = down;
+    m_events.Push({ key, down });
+
+    //  GetAsyncKeyState reported the generic modifier codes, the hook only sees the sided ones
+    int generic = 0;
+    bool held = false;
+    switch (key)
+    {
+    case VK_LSHIFT:
+    case VK_RSHIFT:
+        generic = VK_SHIFT;
+        held = m_down[VK_LSHIFT] || m_down[VK_RSHIFT];
+        break;
+    case VK_LCONTROL:
+    case VK_RCONTROL:
+        generic = VK_CONTROL;
+        held = m_down[VK_LCONTROL] || m_down[VK_RCONTROL];
+        break;
+    case VK_LMENU:
+    case VK_RMENU:
+        generic = VK_MENU;
+        held = m_down[VK_LMENU] || m_down[VK_RMENU];
+        break;
+    default:
+        return;
+    }
+    if (m_down[generic] != held)
+    {
+        m_down[generic] = held;
+        m_events.Push({ generic, held });
+    }
+}
+#endif
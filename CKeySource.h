@@ -0,0 +1,80 @@
+#pragma once
+#include "CEventQueue.h"
+#include "CThreadTopology.h"
+#include "CManagedThread.h"
+
+//  Number of virtual key codes tracked
+#define KEY_CODE_COUNT 256
+//  Key events buffered between driver frames before new ones are dropped
+#define KEY_QUEUE_SIZE 256
+
+//  A single key transition, using Windows virtual key codes
+struct KeyEvent
+{
+    int key;
+    bool down;
+};
+
+//  Where hotkey events come from
+//  Sources push transitions from their own thread, the driver drains them once per frame without blocking
+class CKeySource
+{
+    CKeySource(const CKeySource &that) = delete;
+    CKeySource &operator=(const CKeySource &that) = delete;
+protected:
+    CEventQueue<KeyEvent, KEY_QUEUE_SIZE> m_events;
+    //  Applied by sources that run their own thread
+    ThreadPlacement m_placement;
+
+    CKeySource() : m_placement({ 0u, THREAD_PRIORITY::NORMAL, false }) {}
+public:
+    virtual ~CKeySource() = default;
+
+    virtual bool Start() = 0;
+    virtual void Stop() = 0;
+
+    inline bool Poll(KeyEvent &evnt) { return m_events.Pop(evnt); }
+    inline uint64_t GetDropped() const { return m_events.GetDropped(); }
+    //  Must be set before Start
+    inline void SetPlacement(const ThreadPlacement &placement) { m_placement = placement; }
+
+    //  The system keyboard where one is available, otherwise a scripted source
+    static CKeySource *Create();
+};
+
+//  Events pushed by hand, for tests and platforms without a keyboard hook
+class CScriptedKeySource final : public CKeySource
+{
+public:
+    bool Start() override { return true; }
+    void Stop() override {}
+
+    inline bool Press(int key) { return m_events.Push({ key, true }); }
+    inline bool Release(int key) { return m_events.Push({ key, false }); }
+    inline bool Tap(int key) { return Press(key) && Release(key); }
+};
+
+#ifdef _WIN32
+//  System wide low level keyboard hook (WH_KEYBOARD_LL), installed on its own thread with a message loop
+//  Only transitions are queued (auto repeat is filtered), and left / right modifiers are also reported as VK_SHIFT, VK_CONTROL and VK_MENU
+//  Only one hook can be running at a time
+class CKeyboardHook final : public CKeySource
+{
+    static std::atomic<CKeyboardHook *> ms_instance;
+
+    CManagedThread *m_thread;
+    std::atomic<DWORD> m_threadId;
+    //  Keys currently held, only touched by the hook thread
+    bool m_down[KEY_CODE_COUNT];
+
+    static LRESULT CALLBACK HookProc(int code, WPARAM wParam, LPARAM lParam);
+    void Run(std::promise<bool> *started);
+    void OnKey(int key, bool down);
+public:
+    CKeyboardHook();
+    ~CKeyboardHook();
+
+    bool Start() override;
+    void Stop() override;
+};
+#endif
@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "CKeypointTrace.h"
+#include "CPoseCodec.h"
+
+CKeypointRecorder::CKeypointRecorder()
+{
+    m_file = nullptr;
+    memset(&m_header, 0, sizeof(m_header));
+    m_records = 0u;
+    m_encoders = nullptr;
+    m_packets = nullptr;
+}
+
+CKeypointRecorder::~CKeypointRecorder()
+{
+    Close();
+}
+
+bool CKeypointRecorder::Open(const char *path, uint32_t batches, float focalLength, bool encoded)
+{
+    Close();
+    if (fopen_s(&m_file, path, "wb") != 0 || m_file == nullptr)
+    {
+        m_file = nullptr;
+        return false;
+    }
+    setvbuf(m_file, nullptr, _IOFBF, KEYPOINT_TRACE_BUFFER);
+
+    memset(&m_header, 0, sizeof(m_header));
+    memcpy(m_header.magic, KEYPOINT_TRACE_MAGIC, sizeof(KEYPOINT_TRACE_MAGIC));
+    m_header.version = KEYPOINT_TRACE_VERSION;
+    m_header.joints = (uint32_t)BODY_JOINT_COUNT;
+    m_header.batches = (std::min)((std::max)(batches, 1u), KEYPOINT_TRACE_BATCHES_MAX);
+    m_header.recordSize = encoded ? 0u : (uint32_t)(sizeof(KeypointTraceFrame) + m_header.batches * sizeof(KeypointTraceEntry));
+    m_header.focalLength = focalLength;
+    m_header.flags = encoded ? KEYPOINT_TRACE_ENCODED : 0u;
+    m_records = 0u;
+    if (encoded)
+    {
+        //  Every run starts its stream with a keyframe
+        m_encoders = new CPoseEncoder[m_header.batches];
+        m_packets = new uint8_t[m_header.batches * POSE_PACKET_MAX];
+    }
+    if (fwrite(&m_header, sizeof(m_header), 1u, m_file) != 1u)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CKeypointRecorder::Close()
+{
+    delete[] m_encoders;
+    m_encoders = nullptr;
+    delete[] m_packets;
+    m_packets = nullptr;
+    if (m_file == nullptr)
+        return;
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+bool CKeypointRecorder::AppendEncoded(const KeypointTraceFrame &frame, const NvAR_Point2f *keypoints, const NvAR_Point3f *keypoints3D,
+    const NvAR_Quaternion *jointAngles, const float *confidence)
+{
+    KeypointTraceEntry entry;
+    size_t size = 0u;
+    for (size_t batch = 0; batch < m_header.batches; batch++)
+    {
+        size_t first = batch * BODY_JOINT_COUNT;
+        memcpy(entry.keypoints, keypoints + first, sizeof(entry.keypoints));
+        memcpy(entry.keypoints3D, keypoints3D + first, sizeof(entry.keypoints3D));
+        memcpy(entry.jointAngles, jointAngles + first, sizeof(entry.jointAngles));
+        memcpy(entry.confidence, confidence + first, sizeof(entry.confidence));
+        size += m_encoders[batch].Encode(entry, m_packets + size);
+    }
+    KeypointTraceFrame record = frame;
+    record.packetBytes = (uint32_t)size;
+    return fwrite(&record, sizeof(record), 1u, m_file) == 1u && fwrite(m_packets, 1u, size, m_file) == size;
+}
+
+bool CKeypointRecorder::AppendRaw(const KeypointTraceFrame &frame, const NvAR_Point2f *keypoints, const NvAR_Point3f *keypoints3D,
+    const NvAR_Quaternion *jointAngles, const float *confidence)
+{
+    //  Each run's arrays are contiguous in the driver, so an entry is four runs of joints written back to back
+    bool written = fwrite(&frame, sizeof(frame), 1u, m_file) == 1u;
+    for (size_t batch = 0; batch < m_header.batches && written; batch++)
+    {
+        size_t first = batch * BODY_JOINT_COUNT;
+        written = fwrite(keypoints + first, sizeof(NvAR_Point2f), BODY_JOINT_COUNT, m_file) == BODY_JOINT_COUNT
+            && fwrite(keypoints3D + first, sizeof(NvAR_Point3f), BODY_JOINT_COUNT, m_file) == BODY_JOINT_COUNT
+            && fwrite(jointAngles + first, sizeof(NvAR_Quaternion), BODY_JOINT_COUNT, m_file) == BODY_JOINT_COUNT
+            && fwrite(confidence + first, sizeof(float), BODY_JOINT_COUNT, m_file) == BODY_JOINT_COUNT;
+    }
+    return written;
+}
+
+void CKeypointRecorder::Append(const KeypointTraceFrame &frame, const NvAR_Point2f *keypoints, const NvAR_Point3f *keypoints3D,
+    const NvAR_Quaternion *jointAngles, const float *confidence)
+{
+    if (m_file == nullptr)
+        return;
+    bool written = m_encoders != nullptr ? AppendEncoded(frame, keypoints, keypoints3D, jointAngles, confidence)
+        : AppendRaw(frame, keypoints, keypoints3D, jointAngles, confidence);
+    if (!written)
+    {
+        //  Out of disk space or the like, the records written so far stay readable
+        vr_log("Keypoint trace stopped after %llu frames, the file could not be written", (unsigned long long)m_records);
+        Close();
+        return;
+    }
+    m_records++;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "CCommon.h"
+
+//  Start of every keypoint trace file, and the version of the layout below
+#define KEYPOINT_TRACE_MAGIC "NVBTKPT"
+#define KEYPOINT_TRACE_VERSION 1u
+//  Most inference runs of a frame a trace keeps, the oldest runs beyond that are left out
+#define KEYPOINT_TRACE_BATCHES_MAX 16u
+//  Bytes buffered before the file is written to, about a second of frames at the default settings
+#define KEYPOINT_TRACE_BUFFER (128u * 1024u)
+
+class CPoseEncoder;
+
+//  Flags of KeypointTraceHeader
+//  Records hold a pose packet (CPoseCodec.h) per inference run instead of a KeypointTraceEntry, so they vary in size
+#define KEYPOINT_TRACE_ENCODED 0x1u
+
+//  Raw SDK output of every inference frame, recorded so a session can be replayed without the person or the GPU
+//  A file is a KeypointTraceHeader followed by records of recordSize bytes: a KeypointTraceFrame, then one
+//  KeypointTraceEntry per inference run. Records are only ever appended, so a reader maps the file and indexes
+//  it directly, and a record cut short by a crash is ignored. Layout is little endian x64, as MSVC and GCC lay it out
+//  An encoded trace (KEYPOINT_TRACE_ENCODED) has a recordSize of 0: each KeypointTraceFrame is followed by packetBytes
+//  of packets, run by run in batch order, each run encoded against the same run of the record before. It is about a
+//  third of the size, but has to be read front to back from the first record
+struct KeypointTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    //  sizeof(KeypointTraceFrame) + batches * sizeof(KeypointTraceEntry)
+    uint32_t recordSize;
+    uint32_t joints;
+    //  Inference runs per record (Batches in settings.ini)
+    uint32_t batches;
+    //  Focal length the SDK was configured with (pixels)
+    float focalLength;
+    //  KEYPOINT_TRACE_* flags
+    uint32_t flags;
+    uint32_t reserved[2];
+
+    inline bool IsValid() const
+    {
+        return !memcmp(magic, KEYPOINT_TRACE_MAGIC, sizeof(KEYPOINT_TRACE_MAGIC)) && version == KEYPOINT_TRACE_VERSION
+            && joints == (uint32_t)BODY_JOINT_COUNT && batches >= 1u && batches <= KEYPOINT_TRACE_BATCHES_MAX;
+    }
+    inline bool IsEncoded() const { return (flags & KEYPOINT_TRACE_ENCODED) != 0u; }
+};
+
+//  Flags of the device poses in KeypointTraceFrame
+#define KEYPOINT_TRACE_POSE_VALID 0x1u
+#define KEYPOINT_TRACE_POSE_CONNECTED 0x2u
+
+//  Everything about an inference frame besides the keypoints
+struct KeypointTraceFrame
+{
+    //  Camera frame id, and when the frame was read (systime, the clock the poses are timed with)
+    uint64_t frameId;
+    double captureTime;
+    //  When grabbing the frame started (0 for injected frames), and when inference started and finished (LatencyNow)
+    int64_t captureStart;
+    int64_t inferenceStart;
+    int64_t inferenceEnd;
+    //  Camera placement the keypoints are relative to, position then rotation (x, y, z, w)
+    float camera[7];
+    //  Size of the image the SDK ran on
+    int32_t width;
+    int32_t height;
+    //  First bounding box of the SDK, and how many it reported
+    uint32_t boxCount;
+    NvAR_Rect box;
+    //  Raw HMD (0) and controller (1, 2) poses the frame was aligned with, and their KEYPOINT_TRACE_POSE_* flags
+    vr::HmdMatrix34_t devices[3];
+    uint32_t deviceFlags[3];
+    //  Bytes of pose packets after the frame in an encoded trace, 0 in a raw one
+    uint32_t packetBytes;
+};
+
+//  Outputs of one inference run, in the driver's batch order: entry 0 holds the newest run
+struct KeypointTraceEntry
+{
+    NvAR_Point2f keypoints[BODY_JOINT_COUNT];
+    NvAR_Point3f keypoints3D[BODY_JOINT_COUNT];
+    NvAR_Quaternion jointAngles[BODY_JOINT_COUNT];
+    float confidence[BODY_JOINT_COUNT];
+};
+
+static_assert(sizeof(KeypointTraceHeader) == 40u, "Keypoint trace header layout changed");
+static_assert(sizeof(KeypointTraceFrame) == 256u, "Keypoint trace frame layout changed");
+static_assert(sizeof(KeypointTraceEntry) == 40u * BODY_JOINT_COUNT, "Keypoint trace entry layout changed");
+
+//  Appends keypoint trace records, from one thread only (the session recorder's, see CSessionRecorder.h)
+//  Writes go through a stdio buffer, so a frame normally costs a few memcpy and the disk is hit about once a second
+class CKeypointRecorder
+{
+    FILE *m_file;
+    KeypointTraceHeader m_header;
+    uint64_t m_records;
+    //  One per inference run of an encoded trace, nullptr for a raw one
+    CPoseEncoder *m_encoders;
+    //  The packets of a record, sized for the largest ones at Open
+    uint8_t *m_packets;
+
+    bool AppendRaw(const KeypointTraceFrame &frame, const NvAR_Point2f *keypoints, const NvAR_Point3f *keypoints3D,
+        const NvAR_Quaternion *jointAngles, const float *confidence);
+    bool AppendEncoded(const KeypointTraceFrame &frame, const NvAR_Point2f *keypoints, const NvAR_Point3f *keypoints3D,
+        const NvAR_Quaternion *jointAngles, const float *confidence);
+
+    CKeypointRecorder(const CKeypointRecorder &that) = delete;
+    CKeypointRecorder &operator=(const CKeypointRecorder &that) = delete;
+public:
+    CKeypointRecorder();
+    ~CKeypointRecorder();
+
+    //  Create the file and write its header, batches is clamped to KEYPOINT_TRACE_BATCHES_MAX
+    //  An encoded trace stores the runs as pose packets (KEYPOINT_TRACE_ENCODED)
+    bool Open(const char *path, uint32_t batches, float focalLength, bool encoded = false);
+    void Close();
+
+    inline bool IsOpen() const { return m_file != nullptr; }
+    inline uint32_t GetBatches() const { return m_header.batches; }
+    inline bool IsEncoded() const { return m_header.IsEncoded(); }
+    inline uint64_t GetRecords() const { return m_records; }
+
+    //  The arrays hold GetBatches() runs of BODY_JOINT_COUNT values, laid out like the driver keeps the SDK outputs
+    void Append(const KeypointTraceFrame &frame, const NvAR_Point2f *keypoints, const NvAR_Point3f *keypoints3D,
+        const NvAR_Quaternion *jointAngles, const float *confidence);
+};
@@ -0,0 +1,150 @@
+#include "pch.h"
+#include "CLatencyHistogram.h"
+#include "CCommon.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+const char *LatencyStageName[] = {
+    "Capture",
+    "Decode",
+    "Transfer",
+    "Inference",
+    "Post-process",
+    "Submit",
+    "End to end"
+};
+
+static inline unsigned HighestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (unsigned)index;
+#else
+    return 63u - (unsigned)__builtin_clzll(value);
+#endif
+}
+
+CLatencyHistogram::CLatencyHistogram()
+{
+    Reset();
+}
+
+size_t CLatencyHistogram::BucketIndex(uint64_t micros)
+{
+    //  The first two ranges are exact, above that each power of two keeps LATENCY_SUB_BITS of precision
+    if (micros < 2u * LATENCY_SUB_BUCKETS)
+        return (size_t)micros;
+    unsigned shift = HighestBit(micros) - LATENCY_SUB_BITS;
+    size_t index = (size_t)(shift + 1u) * LATENCY_SUB_BUCKETS + (size_t)((micros >> shift) - LATENCY_SUB_BUCKETS);
+    return (std::min)(index, (size_t)LATENCY_BUCKETS - 1u);
+}
+
+double CLatencyHistogram::BucketValue(size_t index)
+{
+    if (index < 2u * LATENCY_SUB_BUCKETS)
+        return (double)index;
+    unsigned shift = (unsigned)(index / LATENCY_SUB_BUCKETS) - 1u;
+    double low = (double)((uint64_t)(LATENCY_SUB_BUCKETS + index % LATENCY_SUB_BUCKETS) << shift);
+    return low + (double)((uint64_t)1u << shift) * 0.5;
+}
+
+void CLatencyHistogram::Record(int64_t nanoseconds)
+{
+    uint64_t micros = nanoseconds > 0 ? (uint64_t)nanoseconds / 1000u : 0u;
+    m_buckets[BucketIndex(micros)].fetch_add(1u, std::memory_order_relaxed);
+    m_count.fetch_add(1u, std::memory_order_relaxed);
+    m_sum.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (micros > max && !m_max.compare_exchange_weak(max, micros, std::memory_order_relaxed))
+        ;
+}
+
+LatencySummary CLatencyHistogram::Summarize() const
+{
+    //  Counted from the buckets so the percentiles agree with each other even while others record
+    uint64_t counts[LATENCY_BUCKETS], total = 0u;
+    for (size_t index = 0; index < LATENCY_BUCKETS; index++)
+    {
+        counts[index] = m_buckets[index].load(std::memory_order_relaxed);
+        total += counts[index];
+    }
+
+    LatencySummary summary = { total, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    if (total == 0u)
+        return summary;
+    summary.mean = (double)m_sum.load(std::memory_order_relaxed) / (double)(std::max)(m_count.load(std::memory_order_relaxed), (uint64_t)1u) * 0.001;
+    summary.max = (double)m_max.load(std::memory_order_relaxed) * 0.001;
+
+    const double percentiles[3] = { 0.50, 0.95, 0.99 };
+    double *outputs[3] = { &summary.p50, &summary.p95, &summary.p99 };
+    uint64_t seen = 0u;
+    size_t next = 0;
+    for (size_t index = 0; index < LATENCY_BUCKETS && next < 3; index++)
+    {
+        seen += counts[index];
+        while (next < 3 && (double)seen >= percentiles[next] * (double)total)
+            *outputs[next++] = BucketValue(index) * 0.001;
+    }
+    return summary;
+}
+
+void CLatencyHistogram::Reset()
+{
+    for (size_t index = 0; index < LATENCY_BUCKETS; index++)
+        m_buckets[index].store(0u, std::memory_order_relaxed);
+    m_count = 0u;
+    m_sum = 0u;
+    m_max = 0u;
+}
+
+CLatencyStats::CLatencyStats()
+{
+    memset(m_closed, 0, sizeof(m_closed));
+    m_closedLength = 0.0;
+}
+
+void CLatencyStats::CloseWindow(double length)
+{
+    //  Samples recorded while the window is being reset may go either way, which is fine for statistics
+    for (size_t stage = 0; stage < (size_t)LATENCY_STAGE::COUNT; stage++)
+    {
+        m_closed[stage] = m_window[stage].Summarize();
+        m_window[stage].Reset();
+    }
+    m_closedLength = length;
+}
+
+void CLatencyStats::Reset()
+{
+    for (size_t stage = 0; stage < (size_t)LATENCY_STAGE::COUNT; stage++)
+    {
+        m_stages[stage].Reset();
+        m_window[stage].Reset();
+    }
+    memset(m_closed, 0, sizeof(m_closed));
+    m_closedLength = 0.0;
+}
+
+void CLatencyStats::Report() const
+{
+    for (size_t stage = 0; stage < (size_t)LATENCY_STAGE::COUNT; stage++)
+    {
+        const LatencySummary &summary = m_closed[stage];
+        if (summary.count == 0u)
+            continue;
+        vr_log(
+            "\t%-12s p50 %7.3f ms, p95 %7.3f ms, p99 %7.3f ms, max %7.3f ms (%llu samples), p99 since startup %7.3f ms",
+            LatencyStageName[stage],
+            summary.p50,
+            summary.p95,
+            summary.p99,
+            summary.max,
+            (unsigned long long)summary.count,
+            m_stages[stage].Summarize().p99
+        );
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+//  Each power of two range of latencies is split into this many linear buckets (2^4 = 16, about 6% resolution)
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB_BUCKETS (1u << LATENCY_SUB_BITS)
+//  Powers of two covered above the first linear range, microseconds up to 2^(LATENCY_MAGNITUDES + LATENCY_SUB_BITS)
+#define LATENCY_MAGNITUDES 31
+#define LATENCY_BUCKETS ((LATENCY_MAGNITUDES + 1u) * LATENCY_SUB_BUCKETS)
+
+//  Timestamps for latency measurements, in nanoseconds of the steady clock
+inline int64_t LatencyNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//  Percentiles of one histogram, in milliseconds
+struct LatencySummary
+{
+    uint64_t count;
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+//  Log-linear (HDR style) histogram of latencies with microsecond resolution
+//  Recording is a couple of relaxed atomic operations, so any thread can record without locks
+//  Readers get an approximate view while recording continues, which is fine for statistics
+class CLatencyHistogram
+{
+    std::atomic<uint64_t> m_buckets[LATENCY_BUCKETS];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+
+    static size_t BucketIndex(uint64_t micros);
+    //  Middle of the range of values a bucket holds (microseconds)
+    static double BucketValue(size_t index);
+
+    CLatencyHistogram(const CLatencyHistogram &that) = delete;
+    CLatencyHistogram &operator=(const CLatencyHistogram &that) = delete;
+public:
+    CLatencyHistogram();
+
+    void Record(int64_t nanoseconds);
+    LatencySummary Summarize() const;
+    void Reset();
+};
+
+//  Stages of the capture to publish pipeline, in the order a frame goes through them
+enum class LATENCY_STAGE
+{
+    //  Waiting for the camera to deliver a frame (VideoCapture::grab)
+    CAPTURE,
+    //  Decoding it, MJPEG for most webcams (VideoCapture::retrieve)
+    DECODE,
+    //  Uploading it to the GPU (NvCVImage_Transfer)
+    TRANSFER,
+    //  Every NvAR_Run batch
+    INFERENCE,
+    //  Alignment, rotations and filling the pose snapshot
+    POSTPROCESS,
+    //  One tracker handing its pose to vrserver
+    SUBMIT,
+    //  Start of capture until the first submission of that frame's poses
+    END_TO_END,
+    COUNT
+};
+extern const char *LatencyStageName[];
+
+//  Two histograms per pipeline stage: one since startup, and one for the current window, which the owner closes
+//  periodically so the percentiles of a laggy minute are not buried under hours of normal samples
+//  CloseWindow, the window summaries and Report belong to a single thread (the pose publisher's); any thread records
+class CLatencyStats
+{
+    CLatencyHistogram m_stages[(size_t)LATENCY_STAGE::COUNT];
+    CLatencyHistogram m_window[(size_t)LATENCY_STAGE::COUNT];
+    //  The last closed window, and how long it was (seconds, 0 until one was closed)
+    LatencySummary m_closed[(size_t)LATENCY_STAGE::COUNT];
+    double m_closedLength;
+public:
+    CLatencyStats();
+
+    inline void Record(LATENCY_STAGE stage, int64_t nanoseconds)
+    {
+        m_stages[(size_t)stage].Record(nanoseconds);
+        m_window[(size_t)stage].Record(nanoseconds);
+    }
+    //  Since startup
+    inline LatencySummary Summarize(LATENCY_STAGE stage) const { return m_stages[(size_t)stage].Summarize(); }
+    //  Over the last closed window
+    inline const LatencySummary &SummarizeWindow(LATENCY_STAGE stage) const { return m_closed[(size_t)stage]; }
+    inline double GetWindowLength() const { return m_closedLength; }
+    //  Summarize the current window, which lasted the given number of seconds, and start a new one
+    void CloseWindow(double length);
+    void Reset();
+    //  Write p50 / p95 / p99 of the last closed window to the log, for every stage that recorded anything in it
+    void Report() const;
+};
@@ -0,0 +1,247 @@
+#include "pch.h"
+#include "CLogger.h"
+
+CLogger g_logger;
+
+static inline int64_t LoggerNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CLogger::CLogger()
+{
+    for (size_t index = 0; index < LOG_QUEUE_SIZE; index++)
+        m_entries[index].sequence.store(index, std::memory_order_relaxed);
+    m_enqueue = 0u;
+    m_dequeue = 0u;
+
+    for (size_t index = 0; index < LOG_RATE_SLOTS; index++)
+    {
+        m_slots[index].format = nullptr;
+        m_slots[index].windowStart = 0;
+        m_slots[index].count = 0u;
+        m_slots[index].suppressed = 0u;
+    }
+
+    m_running = false;
+    m_stopped = false;
+    m_producers = 0u;
+    m_thread = nullptr;
+    m_sleeping = false;
+    m_signalled = false;
+    m_dropped = 0u;
+    m_reportedDrops = 0u;
+}
+
+CLogger::~CLogger()
+{
+    Stop();
+}
+
+void CLogger::Start()
+{
+    if (m_thread != nullptr)
+        return;
+    m_stopped = false;
+    m_running = true;
+    m_thread = new std::thread(&CLogger::Run, this);
+}
+
+void CLogger::Stop()
+{
+    //  Set before m_running is cleared, so a Post that sees the logger stopped never writes to the driver context
+    m_stopped.store(true, std::memory_order_seq_cst);
+    if (m_thread == nullptr)
+        return;
+    m_running.store(false, std::memory_order_seq_cst);
+    //  A Post that still saw the logger running finishes its push first, so the last drain below writes it out
+    while (m_producers.load(std::memory_order_seq_cst) != 0u)
+        std::this_thread::yield();
+    Wake();
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+    Drain();
+    Sweep();
+}
+
+CLogger::RateSlot *CLogger::FindSlot(const char *format)
+{
+    size_t hash = ((size_t)format >> 3) * 0x9E3779B1u;
+    for (size_t probe = 0; probe < LOG_RATE_SLOTS; probe++)
+    {
+        RateSlot &slot = m_slots[(hash + probe) % LOG_RATE_SLOTS];
+        const char *owner = slot.format.load(std::memory_order_acquire);
+        if (owner == format)
+            return &slot;
+        if (owner == nullptr && slot.format.compare_exchange_strong(owner, format, std::memory_order_acq_rel))
+            return &slot;
+        //  Another thread may have claimed it for the same format in between
+        if (owner == format)
+            return &slot;
+    }
+    return nullptr;
+}
+
+bool CLogger::Admit(const char *format)
+{
+    RateSlot *slot = FindSlot(format);
+    if (slot == nullptr)
+        return true;
+
+    int64_t now = LoggerNow();
+    int64_t start = slot->windowStart.load(std::memory_order_relaxed);
+    if (now - start >= (int64_t)(LOG_RATE_WINDOW * 1e9) && slot->windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+        slot->count.store(0u, std::memory_order_relaxed);
+
+    if (slot->count.fetch_add(1u, std::memory_order_relaxed) < LOG_RATE_LIMIT)
+        return true;
+    //  The first suppression has the logger thread schedule a summary, it may be sleeping with nothing else to do
+    if (slot->suppressed.fetch_add(1u, std::memory_order_seq_cst) == 0u && m_sleeping.load(std::memory_order_seq_cst))
+        Wake();
+    return false;
+}
+
+bool CLogger::Push(const char *text)
+{
+    size_t position = m_enqueue.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Entry &entry = m_entries[position & (LOG_QUEUE_SIZE - 1u)];
+        size_t sequence = entry.sequence.load(std::memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0)
+        {
+            if (m_enqueue.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed))
+            {
+                strncpy_s(entry.text, LOG_BUFFER_SIZE, text, _TRUNCATE);
+                entry.sequence.store(position + 1u, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            //  Full, the logger thread has not caught up
+            return false;
+        }
+        else
+        {
+            position = m_enqueue.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void CLogger::Post(const char *text)
+{
+    //  Counted in before m_running is read: either Stop sees this post and waits for it, or this post sees Stop
+    m_producers.fetch_add(1u, std::memory_order_seq_cst);
+    if (!m_running.load(std::memory_order_seq_cst))
+    {
+        m_producers.fetch_sub(1u, std::memory_order_release);
+        if (m_stopped.load(std::memory_order_seq_cst))
+            m_dropped.fetch_add(1u, std::memory_order_relaxed);
+        else
+            vr::VRDriverLog()->Log(text);
+        return;
+    }
+    if (Push(text))
+    {
+        //  Pairs with the fence in Run, either the logger thread sees the message or this sees it going to sleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleeping.load(std::memory_order_relaxed))
+            Wake();
+    }
+    else
+        m_dropped.fetch_add(1u, std::memory_order_relaxed);
+    m_producers.fetch_sub(1u, std::memory_order_release);
+}
+
+bool CLogger::Pending() const
+{
+    return m_entries[m_dequeue & (LOG_QUEUE_SIZE - 1u)].sequence.load(std::memory_order_acquire) == m_dequeue + 1u;
+}
+
+void CLogger::Wake()
+{
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_signalled = true;
+    m_wake.notify_one();
+}
+
+void CLogger::Drain()
+{
+    while (true)
+    {
+        Entry &entry = m_entries[m_dequeue & (LOG_QUEUE_SIZE - 1u)];
+        if (entry.sequence.load(std::memory_order_acquire) != m_dequeue + 1u)
+            break;
+        vr::VRDriverLog()->Log(entry.text);
+        entry.sequence.store(m_dequeue + LOG_QUEUE_SIZE, std::memory_order_release);
+        m_dequeue++;
+    }
+
+    char summary[LOG_BUFFER_SIZE];
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_reportedDrops)
+    {
+        sprintf_s(summary, LOG_BUFFER_SIZE, "Logger queue was full, %llu messages dropped so far", (unsigned long long)dropped);
+        vr::VRDriverLog()->Log(summary);
+        m_reportedDrops = dropped;
+    }
+}
+
+void CLogger::Sweep()
+{
+    char summary[LOG_BUFFER_SIZE];
+    for (size_t index = 0; index < LOG_RATE_SLOTS; index++)
+    {
+        unsigned suppressed = m_slots[index].suppressed.exchange(0u, std::memory_order_relaxed);
+        if (suppressed == 0u)
+            continue;
+        sprintf_s(summary, LOG_BUFFER_SIZE, "Suppressed %u more messages like: %s", suppressed, m_slots[index].format.load(std::memory_order_relaxed));
+        vr::VRDriverLog()->Log(summary);
+    }
+}
+
+bool CLogger::AnySuppressed() const
+{
+    for (size_t index = 0; index < LOG_RATE_SLOTS; index++)
+    {
+        if (m_slots[index].suppressed.load(std::memory_order_relaxed) != 0u)
+            return true;
+    }
+    return false;
+}
+
+void CLogger::Run()
+{
+    const int64_t window = (int64_t)(LOG_RATE_WINDOW * 1e9);
+    int64_t lastSweep = LoggerNow();
+    while (m_running.load(std::memory_order_acquire))
+    {
+        Drain();
+
+        //  Once per rate window, say how many messages each format string had suppressed
+        int64_t now = LoggerNow();
+        if (now - lastSweep >= window)
+        {
+            lastSweep = now;
+            Sweep();
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        //  Pairs with the fences in Post and Admit, a message pushed from here on either shows up below or wakes this
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_signalled && !Pending() && m_running.load(std::memory_order_relaxed))
+        {
+            //  Only a pending summary needs a timeout, otherwise the next message (or Stop) is what wakes the thread
+            if (AnySuppressed())
+                m_wake.wait_for(lock, std::chrono::nanoseconds((std::max)(lastSweep + window - LoggerNow(), (int64_t)0)), [this]() { return m_signalled; });
+            else
+                m_wake.wait(lock, [this]() { return m_signalled; });
+        }
+        m_signalled = false;
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+}
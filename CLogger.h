@@ -0,0 +1,91 @@
+#pragma once
+
+//  The maximum size of a single log message
+#define LOG_BUFFER_SIZE 1000
+//  Messages waiting for the logger thread before new ones are dropped (power of two)
+#define LOG_QUEUE_SIZE 256
+//  Messages with the same format string allowed per window, the rest are counted and summarised
+#define LOG_RATE_LIMIT 20u
+#define LOG_RATE_WINDOW 1.0
+//  Distinct format strings the rate limiter keeps track of, any beyond that are not limited
+#define LOG_RATE_SLOTS 64
+
+//  Writes log messages to vrserver.txt from a background thread
+//  Callers format into a buffer of their own thread and push it onto a bounded lock-free queue (any number of producers),
+//  so logging never blocks on I/O or on another thread. A full queue drops the message and counts it
+//  The logger thread sleeps until a message arrives (or a rate limit summary is due), so an idle driver never wakes it
+//  Before Start messages are written synchronously instead. After Stop they are only counted as dropped: a thread
+//  that missed the shutdown deadline may still log once the driver context is gone
+class CLogger
+{
+    struct Entry
+    {
+        //  Vyukov bounded queue: the entry is free for the producer at position n when sequence == n, readable when n + 1
+        std::atomic<size_t> sequence;
+        char text[LOG_BUFFER_SIZE];
+    };
+    struct RateSlot
+    {
+        std::atomic<const char *> format;
+        std::atomic<int64_t> windowStart;
+        std::atomic<unsigned> count;
+        std::atomic<unsigned> suppressed;
+    };
+
+    Entry m_entries[LOG_QUEUE_SIZE];
+    std::atomic<size_t> m_enqueue;
+    //  Only touched by the logger thread (or by Stop once it has joined)
+    size_t m_dequeue;
+
+    RateSlot m_slots[LOG_RATE_SLOTS];
+
+    std::atomic<bool> m_running;
+    //  Stop was called, and Start was not called again since
+    std::atomic<bool> m_stopped;
+    //  Posts between their check of m_running and the end of their push, Stop waits for them before its last drain
+    std::atomic<unsigned> m_producers;
+    std::thread *m_thread;
+    //  The logger thread is about to wait, or waiting, on m_wake; producers only take the mutex to wake it then
+    std::atomic<bool> m_sleeping;
+    bool m_signalled;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<uint64_t> m_dropped;
+    uint64_t m_reportedDrops;
+
+    bool Push(const char *text);
+    //  Only for the logger thread (or Stop once it has joined)
+    bool Pending() const;
+    void Drain();
+    void Sweep();
+    bool AnySuppressed() const;
+    void Wake();
+    void Run();
+    RateSlot *FindSlot(const char *format);
+
+    CLogger(const CLogger &that) = delete;
+    CLogger &operator=(const CLogger &that) = delete;
+public:
+    CLogger();
+    ~CLogger();
+
+    //  Needs the driver context (VRDriverLog) for as long as it runs
+    void Start();
+    //  Writes out everything still queued, and the summaries of what the rate limiter suppressed
+    void Stop();
+
+    //  Rate limit check for a format string, done before formatting so suppressed messages cost almost nothing
+    bool Admit(const char *format);
+    void Post(const char *text);
+
+    inline uint64_t GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+};
+
+extern CLogger g_logger;
+
+//  Formatting buffer of the calling thread
+inline char *vr_log_buffer()
+{
+    thread_local char buffer[LOG_BUFFER_SIZE];
+    return buffer;
+}
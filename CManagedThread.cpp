@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "CManagedThread.h"
+#include "CTraceRecorder.h"
+#include "CCommon.h"
+
+bool CStopToken::SleepFor(double seconds) const
+{
+    std::chrono::duration<double> duration(seconds);
+    return SleepUntil(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration));
+}
+
+bool CStopToken::SleepUntil(std::chrono::steady_clock::time_point time) const
+{
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    return !m_state->wake.wait_until(lock, time, [this]() { return StopRequested(); });
+}
+
+CManagedThread::CManagedThread(const char *name, Body body, std::function<void()> onStop)
+    : m_name(name), m_state(std::make_shared<StopState>()), m_onStop(onStop)
+{
+    //  The thread keeps its own reference to the state, so a detached thread never touches freed memory of ours
+    std::shared_ptr<StopState> state = m_state;
+    std::string threadName = m_name;
+    m_thread = std::thread([state, body, threadName]() {
+        TraceThreadName(threadName.c_str());
+        body(CStopToken(state));
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->finished = true;
+        state->done.notify_all();
+    });
+}
+
+CManagedThread::~CManagedThread()
+{
+    RequestStop();
+    Join();
+}
+
+void CManagedThread::RequestStop()
+{
+    if (m_state->stop.exchange(true, std::memory_order_acq_rel))
+        return;
+    {
+        //  Taken so a thread between checking the flag and sleeping cannot miss the wake up
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+    }
+    m_state->wake.notify_all();
+    if (m_onStop)
+        m_onStop();
+}
+
+bool CManagedThread::Join(double timeout)
+{
+    if (!m_thread.joinable())
+        return true;
+
+    bool finished;
+    {
+        std::unique_lock<std::mutex> lock(m_state->mutex);
+        std::chrono::duration<double> duration((std::max)(timeout, 0.0));
+        finished = m_state->done.wait_for(lock, duration, [this]() { return m_state->finished; });
+    }
+    if (finished)
+    {
+        m_thread.join();
+        return true;
+    }
+
+    vr_log("Thread %s did not stop within %.0f ms and was detached", m_name.c_str(), timeout * 1000.0);
+    m_thread.detach();
+    return false;
+}
+
+CThreadSupervisor::~CThreadSupervisor()
+{
+    StopAll();
+    for (auto thread : m_threads)
+        delete thread;
+    m_threads.clear();
+}
+
+CManagedThread *CThreadSupervisor::Spawn(const char *name, CManagedThread::Body body, std::function<void()> onStop)
+{
+    CManagedThread *thread = new CManagedThread(name, body, onStop);
+    m_threads.push_back(thread);
+    m_stopped = false;
+    return thread;
+}
+
+bool CThreadSupervisor::StopAll(double timeout)
+{
+    if (m_stopped)
+        return m_clean;
+    m_stopped = true;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> budget(timeout);
+    std::chrono::steady_clock::time_point deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget);
+
+    //  Every thread winds down in parallel, the joins only collect them
+    for (auto thread : m_threads)
+        thread->RequestStop();
+
+    m_clean = true;
+    for (auto it = m_threads.rbegin(); it != m_threads.rend(); ++it)
+    {
+        double remaining = std::chrono::duration<double>(deadline - std::chrono::steady_clock::now()).count();
+        if (!(*it)->Join(remaining))
+            m_clean = false;
+    }
+
+    m_shutdownLatency = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    vr_log(
+        "Stopped %u threads in %.1f ms%s",
+        (unsigned)m_threads.size(),
+        m_shutdownLatency * 1000.0,
+        m_clean ? "" : " (some were detached)"
+    );
+    return m_clean;
+}
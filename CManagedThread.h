@@ -0,0 +1,83 @@
+#pragma once
+
+//  How long (seconds) shutdown waits for threads to return before giving up on them
+#define THREAD_SHUTDOWN_TIMEOUT 0.5
+
+//  State shared between a managed thread and its owner, kept alive by whichever of them lives longer
+struct StopState
+{
+    std::atomic<bool> stop;
+    bool finished;
+    std::mutex mutex;
+    //  Signalled when a stop is requested (wakes sleeping threads) and when the body returns
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    StopState() : stop(false), finished(false) {}
+};
+
+//  Handed to the body of a managed thread to find out when it should return (std::stop_token for C++14)
+class CStopToken
+{
+    std::shared_ptr<StopState> m_state;
+public:
+    explicit CStopToken(const std::shared_ptr<StopState> &state) : m_state(state) {}
+
+    inline bool StopRequested() const { return m_state->stop.load(std::memory_order_acquire); }
+    //  Sleeps that return early when a stop is requested, false if one was
+    bool SleepFor(double seconds) const;
+    bool SleepUntil(std::chrono::steady_clock::time_point time) const;
+};
+
+//  A thread that can be asked to stop and joined with a deadline
+//  A thread that misses the deadline is detached and reported, never waited on forever
+class CManagedThread
+{
+public:
+    typedef std::function<void(const CStopToken &)> Body;
+private:
+    std::string m_name;
+    std::thread m_thread;
+    std::shared_ptr<StopState> m_state;
+    //  Called by RequestStop, for bodies that block somewhere a stop token cannot reach (e.g. a message loop)
+    std::function<void()> m_onStop;
+
+    CManagedThread(const CManagedThread &that) = delete;
+    CManagedThread &operator=(const CManagedThread &that) = delete;
+public:
+    CManagedThread(const char *name, Body body, std::function<void()> onStop = nullptr);
+    ~CManagedThread();
+
+    void RequestStop();
+    //  Wait at most timeout seconds for the body to return, returns false if it had to be detached
+    bool Join(double timeout = THREAD_SHUTDOWN_TIMEOUT);
+
+    inline const std::string &GetName() const { return m_name; }
+    inline bool StopRequested() const { return m_state->stop.load(std::memory_order_acquire); }
+};
+
+//  Owns the pipeline threads and stops them together within one deadline
+//  Threads stay allocated until the supervisor is destroyed, so pointers handed out by Spawn remain valid after StopAll
+class CThreadSupervisor
+{
+    std::vector<CManagedThread *> m_threads;
+    //  Time the last StopAll took (seconds), and whether every thread made it
+    double m_shutdownLatency;
+    bool m_clean;
+    //  Nothing was spawned since the last StopAll
+    bool m_stopped;
+
+    CThreadSupervisor(const CThreadSupervisor &that) = delete;
+    CThreadSupervisor &operator=(const CThreadSupervisor &that) = delete;
+public:
+    CThreadSupervisor() : m_shutdownLatency(0.0), m_clean(true), m_stopped(true) {}
+    ~CThreadSupervisor();
+
+    CManagedThread *Spawn(const char *name, CManagedThread::Body body, std::function<void()> onStop = nullptr);
+    //  Request a stop from every thread first, then join them newest first against a shared deadline
+    //  Returns false if any thread was detached, whatever it uses must then be leaked rather than freed
+    bool StopAll(double timeout = THREAD_SHUTDOWN_TIMEOUT);
+
+    inline double GetShutdownLatency() const { return m_shutdownLatency; }
+    inline bool WasClean() const { return m_clean; }
+};
@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "CMotionLatency.h"
+#include "CCommon.h"
+
+CMotionLatency::CMotionLatency() : m_latency(0.0), m_correlation(0.0), m_valid(false)
+{
+    Reset();
+}
+
+void CMotionLatency::Reset()
+{
+    m_referenceNext = 0u;
+    m_referenceCount = 0u;
+    m_sampleNext = 0u;
+    m_sampleCount = 0u;
+    m_lastSolve = 0.0;
+    m_lastReport = 0.0;
+    m_latency = 0.0;
+    m_correlation = 0.0;
+    m_valid = false;
+}
+
+void CMotionLatency::AddReference(const MotionSample &reference)
+{
+    //  RunFrame may not have run since the last camera frame, the same poses are only kept once
+    if (m_referenceCount > 0u && reference.time <= Reference(m_referenceCount - 1u).time)
+        return;
+    m_references[m_referenceNext] = reference;
+    m_referenceNext = (m_referenceNext + 1u) % MOTION_HISTORY;
+    m_referenceCount = (std::min)(m_referenceCount + 1u, (size_t)MOTION_HISTORY);
+}
+
+void CMotionLatency::AddSample(const MotionSample &sample)
+{
+    if (m_sampleCount > 0u && sample.time <= Sample(m_sampleCount - 1u).time)
+        return;
+    m_samples[m_sampleNext] = sample;
+    m_sampleNext = (m_sampleNext + 1u) % MOTION_HISTORY;
+    m_sampleCount = (std::min)(m_sampleCount + 1u, (size_t)MOTION_HISTORY);
+
+    if (sample.time - m_lastSolve >= MOTION_SOLVE_INTERVAL)
+    {
+        m_lastSolve = sample.time;
+        Solve(sample.time);
+    }
+}
+
+bool CMotionLatency::Interpolate(double time, int hand, glm::vec3 &position, size_t &cursor) const
+{
+    while (cursor + 1u < m_referenceCount && Reference(cursor + 1u).time <= time)
+        cursor++;
+    if (cursor + 1u >= m_referenceCount || Reference(cursor).time > time)
+        return false;
+    const MotionSample &from = Reference(cursor);
+    const MotionSample &to = Reference(cursor + 1u);
+    double span = to.time - from.time;
+    if (!from.valid[hand] || !to.valid[hand] || span > MOTION_GAP)
+        return false;
+    position = glm::mix(from.position[hand], to.position[hand], (float)((time - from.time) / span));
+    return true;
+}
+
+double CMotionLatency::Correlate(double lag, double &speed) const
+{
+    double product = 0.0, wristEnergy = 0.0, controllerEnergy = 0.0, distance = 0.0, duration = 0.0;
+    glm::vec3 controllers[MOTION_HISTORY];
+    bool valid[MOTION_HISTORY];
+    for (int hand = 0; hand < 2; hand++)
+    {
+        size_t cursor = 0u;
+        for (size_t index = 0; index < m_sampleCount; index++)
+        {
+            const MotionSample &sample = Sample(index);
+            valid[index] = sample.valid[hand] && Interpolate(sample.time - lag, hand, controllers[index], cursor);
+        }
+        //  Each sample is paired with the last one at least MOTION_BASELINE before it
+        size_t from = 0u;
+        for (size_t index = 0; index < m_sampleCount; index++)
+        {
+            double time = Sample(index).time;
+            while (from + 1u < index && Sample(from + 1u).time <= time - MOTION_BASELINE)
+                from++;
+            double elapsed = time - Sample(from).time;
+            if (!valid[index] || !valid[from] || elapsed < MOTION_BASELINE || elapsed > MOTION_BASELINE + MOTION_GAP)
+                continue;
+            //  Displacements over the same interval, velocities up to the common factor 1 / elapsed
+            glm::vec3 wrist = Sample(index).position[hand] - Sample(from).position[hand];
+            glm::vec3 moved = controllers[index] - controllers[from];
+            product += (double)glm::dot(wrist, moved);
+            wristEnergy += (double)glm::dot(wrist, wrist);
+            controllerEnergy += (double)glm::dot(moved, moved);
+            distance += (double)glm::length(moved);
+            duration += elapsed;
+        }
+    }
+    speed = duration > 0.0 ? distance / duration : 0.0;
+    double energy = sqrt(wristEnergy * controllerEnergy);
+    return energy > 0.0 ? product / energy : 0.0;
+}
+
+void CMotionLatency::Solve(double now)
+{
+    double scores[MOTION_LAG_STEPS + 1];
+    double speed = 0.0;
+    int best = 0;
+    for (int step = 0; step <= MOTION_LAG_STEPS; step++)
+    {
+        double stepSpeed;
+        scores[step] = Correlate(step * MOTION_LAG_STEP, stepSpeed);
+        if (scores[step] > scores[best])
+            best = step;
+    }
+    Correlate(best * MOTION_LAG_STEP, speed);
+
+    //  Hands at rest correlate noise with noise, whatever lag wins then means nothing
+    if (speed >= MOTION_MIN_SPEED && scores[best] >= MOTION_MIN_CORRELATION)
+    {
+        double lag = best * MOTION_LAG_STEP;
+        if (best > 0 && best < MOTION_LAG_STEPS)
+        {
+            double before = scores[best - 1], after = scores[best + 1];
+            double curvature = before - 2.0 * scores[best] + after;
+            if (curvature < 0.0)
+                lag += .5 * (before - after) / curvature * MOTION_LAG_STEP;
+        }
+        double latency = GetLatency();
+        m_latency = m_valid ? latency + MOTION_SMOOTHING * (lag - latency) : lag;
+        m_correlation = scores[best];
+        m_valid = true;
+    }
+
+    if (m_valid && now - m_lastReport >= MOTION_REPORT_INTERVAL)
+    {
+        m_lastReport = now;
+        vr_log("Motion latency %.1f ms behind the capture time (correlation %.2f)", GetLatency() * 1000.0, GetCorrelation());
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+//  Samples kept of the wrists and of the controllers, about eight seconds at 30 FPS
+#define MOTION_HISTORY 256u
+//  Lags tried, MOTION_LAG_STEP seconds apart from none up to 0.3 s, the longest a webcam pipeline plausibly has
+#define MOTION_LAG_STEP 0.002
+#define MOTION_LAG_STEPS 150
+//  How often the lag is solved again, and how often it is written to the log (seconds)
+#define MOTION_SOLVE_INTERVAL 1.0
+#define MOTION_REPORT_INTERVAL 10.0
+//  Velocities are taken over at least this long, a frame to frame difference is mostly keypoint noise (seconds)
+#define MOTION_BASELINE 0.1
+//  Controller poses further apart than this are a gap, nothing is interpolated across it; velocities are not taken
+//  over more than MOTION_BASELINE + MOTION_GAP either (seconds)
+#define MOTION_GAP 0.1
+//  Windows with slower hands or a weaker match than this leave the estimate as it was
+#define MOTION_MIN_SPEED 0.1
+#define MOTION_MIN_CORRELATION 0.5
+//  Weight given to each accepted solve
+#define MOTION_SMOOTHING 0.25
+
+//  Positions of both hands at one point in time, left (0) and right (1)
+struct MotionSample
+{
+    double time;
+    glm::vec3 position[2];
+    bool valid[2];
+};
+
+//  Estimates how far the wrist keypoints trail the real movement of the hands, taking the controllers as the truth
+//  The velocities of the wrists and controllers are cross-correlated over the history, and the lag with the best match
+//  wins (refined between steps with a parabola). Velocities are compared rather than positions, so a camera placement
+//  that is off by a constant offset or scale does not bias the result, only how well the windows correlate
+//  The lag is what passes between a hand moving and a camera frame time-stamped with that movement, the exposure and
+//  USB transfer the capture time cannot see plus any smoothing in the SDK. Published poses are that much older than
+//  their sample time says
+//  Samples are added from the camera thread only, the estimate can be read from any thread
+class CMotionLatency
+{
+    //  Rings in time order, m_count entries ending just before m_next
+    MotionSample m_references[MOTION_HISTORY];
+    size_t m_referenceNext;
+    size_t m_referenceCount;
+    MotionSample m_samples[MOTION_HISTORY];
+    size_t m_sampleNext;
+    size_t m_sampleCount;
+
+    double m_lastSolve;
+    double m_lastReport;
+    std::atomic<double> m_latency;
+    std::atomic<double> m_correlation;
+    std::atomic<bool> m_valid;
+
+    inline const MotionSample &Reference(size_t index) const { return m_references[(m_referenceNext + MOTION_HISTORY - m_referenceCount + index) % MOTION_HISTORY]; }
+    inline const MotionSample &Sample(size_t index) const { return m_samples[(m_sampleNext + MOTION_HISTORY - m_sampleCount + index) % MOTION_HISTORY]; }
+    //  Controller position at the given time, interpolated between references; cursor only moves forward between calls
+    bool Interpolate(double time, int hand, glm::vec3 &position, size_t &cursor) const;
+    //  Correlation of the wrist and controller velocities with the controllers shifted back by lag, and the
+    //  mean controller speed over the matched samples (m/s)
+    double Correlate(double lag, double &speed) const;
+    void Solve(double now);
+public:
+    CMotionLatency();
+
+    //  Controller positions as fetched by RunFrame, in the same space as the wrists
+    void AddReference(const MotionSample &reference);
+    //  Wrist keypoints of a camera frame at its capture time, solves again once MOTION_SOLVE_INTERVAL has passed
+    void AddSample(const MotionSample &sample);
+    void Reset();
+
+    //  Whether any window was good enough for an estimate yet
+    inline bool HasEstimate() const { return m_valid.load(std::memory_order_relaxed); }
+    //  Smoothed lag (seconds), 0 until there is an estimate
+    inline double GetLatency() const { return m_latency.load(std::memory_order_relaxed); }
+    //  How well the last accepted window matched, 1 for a perfect match
+    inline double GetCorrelation() const { return m_correlation.load(std::memory_order_relaxed); }
+};
@@ -4,6 +4,7 @@
 #include "CServerDriver.h"
 #include "CCameraDriver.h"
 #include "CDriverSettings.h"
+#include "CSessionRecorder.h"
 
 extern char g_modulePath[];
 
@@ -18,6 +19,7 @@ CNvSDKInterface::CNvSDKInterface() : m_tmpImage{}
     trackingActive = false;
     stabilization = true;
     m_imageLoaded = false;
+    m_postStart = 0;
     useCudaGraph = true;
     nvARMode = 1;
     focalLength = 800.0f;
@@ -140,9 +142,13 @@ void CNvSDKInterface::LoadImageFromCam(const cv::VideoCapture &cam)
 
 void CNvSDKInterface::UpdateImageFromCam(const cv::Mat image)
 {
+    int64_t start = LatencyNow();
     NvCVImage fxSrcChunkyCPU{};
     (void)NVWrapperForCVMat(&image, &fxSrcChunkyCPU);
     NvCVImage_Transfer(&fxSrcChunkyCPU, &m_inputImageBuffer, 1.f, m_stream, &m_tmpImage);
+    int64_t end = LatencyNow();
+    driver->GetLatency().Record(LATENCY_STAGE::TRANSFER, end - start);
+    driver->GetTrace().Record("Upload", driver->m_cameraDriver->GetFrameId(), start, end);
 }
 
 CNvSDKInterface::~CNvSDKInterface()
@@ -295,6 +301,11 @@ void CNvSDKInterface::AlignWithOffset()
     }
 }
 
+void CNvSDKInterface::RotateBatched(std::vector<NvAR_Point2f> &to)
+{
+    std::rotate(to.rbegin(), to.rbegin() + m_numKeyPoints, to.rend());
+}
+
 void CNvSDKInterface::RotateBatched(std::vector<float> &to)
 {
     std::rotate(to.rbegin(), to.rbegin() + m_numKeyPoints, to.rend());
@@ -461,7 +472,7 @@ void CNvSDKInterface::ComputeRotations()
     );
 }
 
-const glm::mat4x4 CNvSDKInterface::GetTransformFromRole(const TRACKER_ROLE &role) const
+const RigidTransform CNvSDKInterface::GetTransformFromRole(const TRACKER_ROLE &role) const
 {
     switch (role)
     {
@@ -544,6 +555,43 @@ void CNvSDKInterface::ComputeAvgConfidence()
     m_confidence = avg / (realBatches * batchSize * m_numKeyPoints);
 }
 
+void CNvSDKInterface::RecordFrame(uint64_t frame, int64_t start, const DevicePoses &devices)
+{
+    //  Records are laid out for the full body model and the batch count the trace was opened with
+    CSessionRecorder *recorder = driver->m_recorder;
+    if (m_numKeyPoints != BODY_JOINT_COUNT || m_keypoints3D.size() < (size_t)recorder->GetBatches() * m_numKeyPoints)
+        return;
+
+    KeypointTraceFrame record{};
+    const CCameraDriver *cameraDriver = driver->m_cameraDriver;
+    record.frameId = frame;
+    record.captureTime = cameraDriver->GetFrameTime();
+    record.captureStart = cameraDriver->GetCaptureStart();
+    record.inferenceStart = start;
+    record.inferenceEnd = m_postStart;
+
+    glm::vec3 position = GetCameraPos();
+    glm::quat rotation = GetCameraRot();
+    const float camera[7] = { position.x, position.y, position.z, rotation.x, rotation.y, rotation.z, rotation.w };
+    memcpy(record.camera, camera, sizeof(camera));
+    record.width = m_inputImageWidth;
+    record.height = m_inputImageHeight;
+
+    record.boxCount = m_outputBBoxes.num_boxes;
+    if (m_outputBBoxes.num_boxes > 0u)
+        record.box = m_outputBBoxes.boxes[0];
+
+    for (int index = 0; index < 3; index++)
+    {
+        const vr::TrackedDevicePose_t &pose = devices.poses[index];
+        record.devices[index] = pose.mDeviceToAbsoluteTracking;
+        record.deviceFlags[index] = (pose.bPoseIsValid ? KEYPOINT_TRACE_POSE_VALID : 0u) | (pose.bDeviceIsConnected ? KEYPOINT_TRACE_POSE_CONNECTED : 0u);
+    }
+
+    //  Runs beyond what the trace keeps are the oldest ones, at the end of the arrays
+    recorder->PushKeypoints(record, m_keypoints.data(), m_keypoints3D.data(), m_jointAngles.data(), m_keypointsConfidence.data());
+}
+
 void CNvSDKInterface::EmptyKeypoints()
 {
     m_realKeypoints3D.assign(m_numKeyPoints, { 0.f, 0.f, 0.f });
@@ -602,6 +650,31 @@ void CNvSDKInterface::DebugSequence(const std::vector<glm::quat> rot) const
     vr_log("");
 }
 
+void CNvSDKInterface::SampleControllers(const DevicePoses &devices)
+{
+    MotionSample reference;
+    reference.time = devices.time;
+    for (int hand = 0; hand < 2; hand++)
+    {
+        const vr::TrackedDevicePose_t &pose = devices.poses[1 + hand];
+        const vr::HmdMatrix34_t &mat = pose.mDeviceToAbsoluteTracking;
+        reference.valid[hand] = pose.bDeviceIsConnected && pose.bPoseIsValid;
+        reference.position[hand] = WorldToCam(glm::vec3(mat.m[0][3], mat.m[1][3], mat.m[2][3]));
+    }
+    motionLatency.AddReference(reference);
+}
+
+void CNvSDKInterface::SampleWrists()
+{
+    MotionSample sample;
+    sample.time = driver->m_cameraDriver->GetFrameTime();
+    sample.position[0] = GetPosition(BODY_JOINT::LEFT_WRIST);
+    sample.position[1] = GetPosition(BODY_JOINT::RIGHT_WRIST);
+    sample.valid[0] = GetConfidenceAcceptable(BODY_JOINT::LEFT_WRIST);
+    sample.valid[1] = GetConfidenceAcceptable(BODY_JOINT::RIGHT_WRIST);
+    motionLatency.AddSample(sample);
+}
+
 void CNvSDKInterface::RunFrame()
 {
     if(trackingActive)
@@ -609,33 +682,59 @@ void CNvSDKInterface::RunFrame()
         //NvAR_Run(m_keyPointDetectHandle);
         batchSize = 1;
         int code;
+        CTraceRecorder &trace = driver->GetTrace();
+        uint64_t frame = driver->m_cameraDriver->GetFrameId();
+        int64_t start = LatencyNow();
         for (int i = 0; i < realBatches; i++)
         {
+            //  The SDK only writes entry 0, every output moves the earlier runs along so each entry keeps its own run
             if (i > 0)
             {
+                RotateBatched(m_keypoints);
                 RotateBatched(m_keypointsConfidence);
                 RotateBatched(m_keypoints3D);
-                //RotateBatched(m_jointAngles);
+                RotateBatched(m_jointAngles);
             }
+            CTraceScope span(trace, "Inference", frame);
             code = (int)NvAR_Run(m_keyPointDetectHandle);
             if (code != 0) vr_log("NVIDIA SDK ERR CODE:\t%d", code);
         }
+        m_postStart = LatencyNow();
+        driver->GetLatency().Record(LATENCY_STAGE::INFERENCE, m_postStart - start);
+        //  Newest device poses published by the SteamVR thread, for the alignment and the recording
+        driver->m_devicePoses.Acquire();
+        const DevicePoses &devices = driver->m_devicePoses.Read();
+        SampleControllers(devices);
+        if (driver->m_recorder != nullptr && driver->m_recorder->IsRecordingKeypoints())
+            RecordFrame(frame, start, devices);
         ComputeAvgConfidence();
         //vr_log("CONFIDENCE: %.5f", m_confidence);
+        presence.Report(m_confidence >= confidenceRequirement, systime());
         if(m_confidence >= confidenceRequirement)
         {
-            FillBatched(m_keypointsConfidence, m_realConfidence);
-            FillBatched(m_keypoints3D, m_realKeypoints3D);
-            //FillBatched(m_jointAngles, m_realJointAngles);
-            if (m_alignHMD)
             {
-                AlignToHMD(driver->m_hmd_controller_pose[0]);
-                AlignToControllers(driver->m_hmd_controller_pose[1], driver->m_hmd_controller_pose[2]);
+                CTraceScope span(trace, "Fill", frame);
+                FillBatched(m_keypointsConfidence, m_realConfidence);
+                FillBatched(m_keypoints3D, m_realKeypoints3D);
+                //FillBatched(m_jointAngles, m_realJointAngles);
+            }
+            //  Alignment moves the wrists onto the controllers of this very moment, which would hide the lag
+            SampleWrists();
+            {
+                CTraceScope span(trace, "Align", frame);
+                if (m_alignHMD)
+                {
+                    AlignToHMD(devices.poses[0]);
+                    AlignToControllers(devices.poses[1], devices.poses[2]);
+                }
+                else
+                    AlignToMirror();
+                AlignWithOffset();
+            }
+            {
+                CTraceScope span(trace, "Rotations", frame);
+                ComputeRotations();
             }
-            else
-                AlignToMirror();
-            AlignWithOffset();
-            ComputeRotations();
             //DebugSequence(m_keypoints3D);
         }
         else
@@ -1,9 +1,13 @@
 #pragma once
+#include "CRigidTransform.h"
+#include "CPresenceProbe.h"
+#include "CMotionLatency.h"
 
 enum class TRACKING_FLAG;
 enum class BODY_JOINT;
 enum class TRACKER_ROLE;
 class CServerDriver;
+struct DevicePoses;
 
 //  NVIDIA AR SDK Interface, designed to simplify and handle the interpretation of data from the SDK
 class CNvSDKInterface
@@ -26,6 +30,8 @@ class CNvSDKInterface
     NvAR_BBoxes m_outputBBoxes{};
     int m_batchSize;
     float m_confidence;
+    //  When inference finished for the current frame (LatencyNow), post-processing is measured from here
+    int64_t m_postStart;
 
     TRACKING_FLAG m_flags;
     float m_fps;
@@ -41,6 +47,7 @@ class CNvSDKInterface
     void FillBatched(const std::vector<NvAR_Quaternion> &from, std::vector<glm::quat> &to);
     void ComputeRotations();
 
+    void RotateBatched(std::vector<NvAR_Point2f> &to);
     void RotateBatched(std::vector<float> &to);
     void RotateBatched(std::vector<NvAR_Point3f> &to);
     void RotateBatched(std::vector<NvAR_Quaternion> &to);
@@ -48,6 +55,11 @@ class CNvSDKInterface
     void EmptyKeypoints();
 
     void ComputeAvgConfidence();
+    //  Queue the raw outputs of the inference runs that just finished on the session recorder
+    void RecordFrame(uint64_t frame, int64_t start, const DevicePoses &devices);
+    //  Feed the latency estimate: controllers as fetched by the SteamVR thread, wrists as the SDK placed them (before alignment)
+    void SampleControllers(const DevicePoses &devices);
+    void SampleWrists();
 
     template<class T>
     inline T TableIndex(T *table, int index, int batch) { return table[batch * m_numKeyPoints + index]; }
@@ -73,8 +85,9 @@ protected:
 
     static inline const glm::vec3 CastPoint(const NvAR_Point3f &point) { return glm::vec3(point.x, point.y, point.z); }
     static inline const glm::quat CastQuaternion(const NvAR_Quaternion &quat) { return glm::quat(quat.w, quat.x, quat.y, quat.z); }
-    static inline const glm::mat4x4 CastMatrix(const glm::vec3 &point, const glm::quat &quat) { return Slide(glm::mat4_cast(quat), point); }
+    static inline const glm::mat4x4 CastMatrix(const glm::vec3 &point, const glm::quat &quat) { return RigidTransform(point, quat).Matrix(); }
     static inline const glm::mat4x4 CastMatrix(const NvAR_Point3f &point, const NvAR_Quaternion &quat) { return CastMatrix(CastPoint(point), CastQuaternion(quat)); }
+    static inline const RigidTransform CastTransform(const glm::vec3 &point, const glm::quat &quat) { return RigidTransform(point, quat); }
     inline const glm::vec3 GetDirection(const glm::vec3 &from, const glm::vec3 &to) { return glm::normalize(to - from); }
     inline const glm::vec3 GetDirection(const BODY_JOINT &from, const BODY_JOINT &to) { return GetDirection(GetPosition(from), GetPosition(to)); }
 
@@ -84,7 +97,9 @@ protected:
     void AlignToMirror();
 
     friend class CServerDriver;
+    friend class CDriverTestAccess;
 public:
+    inline int64_t GetPostStart() const { return m_postStart; }
     CServerDriver *driver;
 
     static inline const glm::mat4x4 Slide(glm::mat4x4 mat, const glm::vec3 vector) {
@@ -94,14 +109,8 @@ public:
         return mat;
     }
 
-    static inline const glm::mat4x4 InverseRotation(glm::mat4x4 mat) {
-        glm::vec3 temp = glm::vec3(mat[3]);
-        mat = glm::inverse(mat);
-        mat[3][0] = temp.x;
-        mat[3][1] = temp.y;
-        mat[3][2] = temp.z;
-        return mat;
-    }
+    static inline const glm::mat4x4 InverseRotation(const glm::mat4x4 &mat) { return RigidTransform(mat).InverseRotation().Matrix(); }
+    static inline const RigidTransform InverseRotation(const RigidTransform &transform) { return transform.InverseRotation(); }
 
     static inline const float ExtractAngleX(const glm::mat4x4 &mat)
     {
@@ -134,6 +143,11 @@ public:
 
     bool ready;
 
+    //  Lowers the inference rate while nobody is in frame, updated by every RunFrame
+    CPresenceProbe presence;
+    //  How far the wrists trail the controllers, updated by every confident RunFrame
+    CMotionLatency motionLatency;
+
     void Initialize();
     void Initialize(int w, int h, int batch_size = 1);
     void ResizeImage(int w, int h);
@@ -152,6 +166,7 @@ public:
     inline const glm::vec3 GetCameraPos() const { return glm::vec3(m_camMatrix[3][0], m_camMatrix[3][1], m_camMatrix[3][2]); }
     inline const glm::quat GetCameraRot() const { return glm::quat_cast(m_camMatrix); }
     inline const glm::mat4x4 GetCameraMatrix() const { return m_camMatrix; }
+    inline const RigidTransform GetCameraTransform() const { return RigidTransform(m_camMatrix); }
     inline bool GetConfidenceAcceptable() const { return m_confidence >= confidenceRequirement; }
 
     static inline const glm::quat MirrorQuaternionX(const glm::quat &ref)
@@ -167,18 +182,12 @@ public:
         return glm::quat(ref.w, -ref.x, -ref.y, ref.z);
     }
 
-    static inline const glm::mat4x4 MirrorRotationX(const glm::mat4x4 &ref)
-    {
-        return CastMatrix(glm::vec3(ref[3]), MirrorQuaternionX(glm::quat_cast(ref)));
-    }
-    static inline const glm::mat4x4 MirrorRotationY(const glm::mat4x4 &ref)
-    {
-        return CastMatrix(glm::vec3(ref[3]), MirrorQuaternionY(glm::quat_cast(ref)));
-    }
-    static inline const glm::mat4x4 MirrorRotationZ(const glm::mat4x4 &ref)
-    {
-        return CastMatrix(glm::vec3(ref[3]), MirrorQuaternionZ(glm::quat_cast(ref)));
-    }
+    static inline const glm::mat4x4 MirrorRotationX(const glm::mat4x4 &ref) { return RigidTransform(ref).MirrorX().Matrix(); }
+    static inline const glm::mat4x4 MirrorRotationY(const glm::mat4x4 &ref) { return RigidTransform(ref).MirrorY().Matrix(); }
+    static inline const glm::mat4x4 MirrorRotationZ(const glm::mat4x4 &ref) { return RigidTransform(ref).MirrorZ().Matrix(); }
+    static inline const RigidTransform MirrorRotationX(const RigidTransform &ref) { return ref.MirrorX(); }
+    static inline const RigidTransform MirrorRotationY(const RigidTransform &ref) { return ref.MirrorY(); }
+    static inline const RigidTransform MirrorRotationZ(const RigidTransform &ref) { return ref.MirrorZ(); }
 
     static const glm::vec3 c_x;
     static const glm::vec3 c_y;
@@ -213,25 +222,25 @@ public:
     inline void UpdatePosition(const BODY_JOINT &role, const glm::vec3 &vec) { m_realKeypoints3D[(int)role] = vec; }
     inline void UpdateRotation(const BODY_JOINT &role, const glm::quat &rot) { m_realJointAngles[(int)role] = rot; }
 
-    inline const glm::mat4x4 GetTransform(BODY_JOINT role) const { return CastMatrix(GetPosition(role), GetRotation(role)); }
-    inline const glm::mat4x4 GetTransform(BODY_JOINT role, BODY_JOINT rotation_owner) const { return CastMatrix(GetPosition(role), GetRotation(rotation_owner)); }
+    inline const RigidTransform GetTransform(BODY_JOINT role) const { return CastTransform(GetPosition(role), GetRotation(role)); }
+    inline const RigidTransform GetTransform(BODY_JOINT role, BODY_JOINT rotation_owner) const { return CastTransform(GetPosition(role), GetRotation(rotation_owner)); }
     inline const glm::vec3 GetPosition(BODY_JOINT role) const { return m_realKeypoints3D[(int)role]; }
     inline const glm::vec3 GetPosition(BODY_JOINT role, BODY_JOINT secondary) const { return glm::mix(GetPosition(role), GetPosition(secondary), .5f); }
     inline const glm::quat GetRotation(BODY_JOINT role) const { return m_realJointAngles[(int)role]; }
     inline const glm::quat GetRotation(BODY_JOINT role, BODY_JOINT secondary) const { return glm::slerp(GetRotation(role), GetRotation(secondary), .5f); }
-    inline const glm::mat4x4 GetAverageTransform(BODY_JOINT from, BODY_JOINT to) const { return InterpolateMatrix(GetTransform(from), GetTransform(to), .5f); }
-    static inline const glm::mat4x4 TransformSlide(const glm::vec3 &from, const glm::vec3 &to, const glm::quat &rotation_owner, const float &alpha = 0.f)
+    inline const RigidTransform GetAverageTransform(BODY_JOINT from, BODY_JOINT to) const { return InterpolateTransform(GetTransform(from), GetTransform(to), .5f); }
+    static inline const RigidTransform TransformSlide(const glm::vec3 &from, const glm::vec3 &to, const glm::quat &rotation_owner, const float &alpha = 0.f)
     {
-        return CastMatrix(
+        return CastTransform(
             glm::mix(from, to, alpha), 
             rotation_owner
         );
     }
-    inline const glm::mat4x4 GetInterpolatedTransform(BODY_JOINT from, BODY_JOINT to, BODY_JOINT rotation_owner, float alpha = 0.f) const
+    inline const RigidTransform GetInterpolatedTransform(BODY_JOINT from, BODY_JOINT to, BODY_JOINT rotation_owner, float alpha = 0.f) const
     { 
         return TransformSlide(GetPosition(from), GetPosition(to), GetRotation(rotation_owner), alpha);
     }
-    inline const glm::mat4x4 GetInterpolatedTransformMulti(BODY_JOINT from, BODY_JOINT middle, BODY_JOINT to, float alpha = 0.f) const
+    inline const RigidTransform GetInterpolatedTransformMulti(BODY_JOINT from, BODY_JOINT middle, BODY_JOINT to, float alpha = 0.f) const
     {
         if (alpha > 0.f)
             return GetInterpolatedTransform(middle, to, middle, alpha);
@@ -239,7 +248,7 @@ public:
             return GetInterpolatedTransform(middle, from, from, -alpha);
     }
     
-    const glm::mat4x4 GetTransformFromRole(const TRACKER_ROLE &role) const;
+    const RigidTransform GetTransformFromRole(const TRACKER_ROLE &role) const;
 
     static inline const glm::vec3 ObjectToWorldVector(const glm::mat4x4 &mat, const glm::vec3 &vec)
     {
@@ -254,14 +263,16 @@ public:
     }
 
     inline const glm::vec3 WorldToCam(const glm::vec3 &input) const {
-        return WorldToObjectVector(GetCameraMatrix(), input);
+        return GetCameraTransform().Inverse().Apply(input);
     }
 
     static inline const glm::mat4x4 InterpolateMatrix(const glm::mat4x4 &mat1, const glm::mat4x4 &mat2, const float &delta)
     {
-        glm::mat4x4 output = glm::mat4_cast(glm::slerp(glm::quat_cast(mat1), glm::quat_cast(mat2), delta));
-        output[3] = mat2[3] * delta + mat1[3] * (1.f - delta);
-        return output;
+        return InterpolateTransform(RigidTransform(mat1), RigidTransform(mat2), delta).Matrix();
+    }
+    static inline const RigidTransform InterpolateTransform(const RigidTransform &from, const RigidTransform &to, const float &delta)
+    {
+        return RigidTransform::Slerp(from, to, delta);
     }
 
     inline int GetImageWidth() const { return m_inputImageWidth; }
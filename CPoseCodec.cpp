@@ -0,0 +1,274 @@
+#include "pch.h"
+#include "CPoseCodec.h"
+#include <cmath>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define POSE_CODEC_SIMD 1
+#include <emmintrin.h>
+#else
+#define POSE_CODEC_SIMD 0
+#endif
+
+//  Joints of a channel covered by whole 8 value lanes, the rest is done one at a time
+#define POSE_CODEC_LANE_JOINTS (BODY_JOINT_COUNT & ~(size_t)7u)
+
+static const float c_channelScale[POSE_CHANNEL_COUNT] =
+{
+    POSE_CODEC_SCALE_3D, POSE_CODEC_SCALE_3D, POSE_CODEC_SCALE_3D,
+    POSE_CODEC_SCALE_2D, POSE_CODEC_SCALE_2D,
+    POSE_CODEC_SCALE_QUAT, POSE_CODEC_SCALE_QUAT, POSE_CODEC_SCALE_QUAT,
+    POSE_CODEC_SCALE_CONFIDENCE
+};
+
+//  Rounded to the nearest step and saturated, NaN (a joint the SDK lost) is stored as 0
+static inline int16_t Quantize(float value, float scale)
+{
+    float scaled = std::round(value * scale);
+    if (scaled != scaled)
+        return 0;
+    if (scaled <= (float)INT16_MIN)
+        return INT16_MIN;
+    if (scaled >= (float)INT16_MAX)
+        return INT16_MAX;
+    return (int16_t)scaled;
+}
+
+//  Drops the largest component of a unit quaternion, flipping the sign of the rest so it was positive
+static inline uint8_t QuantizeQuaternion(const NvAR_Quaternion &quat, int16_t &a, int16_t &b, int16_t &c)
+{
+    float q[4] = { quat.x, quat.y, quat.z, quat.w };
+    float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (!(length > 1e-6f))
+    {
+        //  Nothing was estimated for the joint, it goes out as the identity
+        a = b = c = 0;
+        return 3u;
+    }
+    uint8_t largest = 0u;
+    for (uint8_t index = 1u; index < 4u; index++)
+    {
+        if (std::fabs(q[index]) > std::fabs(q[largest]))
+            largest = index;
+    }
+    float scale = (q[largest] < 0.f ? -POSE_CODEC_SCALE_QUAT : POSE_CODEC_SCALE_QUAT) / length;
+    int16_t *out[3] = { &a, &b, &c };
+    for (uint8_t index = 0u, component = 0u; index < 4u; index++)
+    {
+        if (index != largest)
+            *out[component++] = Quantize(q[index], scale);
+    }
+    return largest;
+}
+
+CPoseEncoder::CPoseEncoder(uint32_t keyframeInterval)
+{
+    memset(m_state, 0, sizeof(m_state));
+    m_interval = keyframeInterval;
+    m_sinceKeyframe = 0u;
+    Reset();
+}
+
+void CPoseEncoder::Reset()
+{
+    m_sinceKeyframe = m_interval;
+}
+
+size_t CPoseEncoder::Encode(const KeypointTraceEntry &entry, uint8_t *packet)
+{
+    int16_t values[POSE_CHANNEL_COUNT][BODY_JOINT_COUNT];
+    uint8_t indices[POSE_PACKET_INDEX_BYTES];
+    memset(indices, 0, sizeof(indices));
+    for (size_t joint = 0; joint < BODY_JOINT_COUNT; joint++)
+    {
+        values[(size_t)POSE_CHANNEL::X3D][joint] = Quantize(entry.keypoints3D[joint].x, POSE_CODEC_SCALE_3D);
+        values[(size_t)POSE_CHANNEL::Y3D][joint] = Quantize(entry.keypoints3D[joint].y, POSE_CODEC_SCALE_3D);
+        values[(size_t)POSE_CHANNEL::Z3D][joint] = Quantize(entry.keypoints3D[joint].z, POSE_CODEC_SCALE_3D);
+        values[(size_t)POSE_CHANNEL::X2D][joint] = Quantize(entry.keypoints[joint].x, POSE_CODEC_SCALE_2D);
+        values[(size_t)POSE_CHANNEL::Y2D][joint] = Quantize(entry.keypoints[joint].y, POSE_CODEC_SCALE_2D);
+        values[(size_t)POSE_CHANNEL::CONFIDENCE][joint] = Quantize(entry.confidence[joint], POSE_CODEC_SCALE_CONFIDENCE);
+        uint8_t largest = QuantizeQuaternion(entry.jointAngles[joint], values[(size_t)POSE_CHANNEL::QUAT_A][joint],
+            values[(size_t)POSE_CHANNEL::QUAT_B][joint], values[(size_t)POSE_CHANNEL::QUAT_C][joint]);
+        indices[joint >> 2] |= (uint8_t)(largest << ((joint & 3u) * 2u));
+    }
+
+    bool keyframe = m_sinceKeyframe >= m_interval;
+    m_sinceKeyframe = keyframe ? 1u : m_sinceKeyframe + 1u;
+
+    PosePacketHeader header;
+    header.flags = keyframe ? (uint8_t)POSE_PACKET_KEYFRAME : 0u;
+    header.reserved = 0u;
+    header.wide = 0u;
+    uint8_t *data = packet + sizeof(header);
+    for (size_t channel = 0; channel < POSE_CHANNEL_COUNT; channel++)
+    {
+        //  Differences are taken as 16 bit integers, the same way the decoder adds them back
+        int16_t deltas[BODY_JOINT_COUNT];
+        bool narrow = !keyframe;
+        for (size_t joint = 0; joint < BODY_JOINT_COUNT; joint++)
+        {
+            deltas[joint] = (int16_t)(uint16_t)((uint16_t)values[channel][joint] - (uint16_t)m_state[channel][joint]);
+            narrow = narrow && deltas[joint] >= INT8_MIN && deltas[joint] <= INT8_MAX;
+        }
+        if (narrow)
+        {
+            for (size_t joint = 0; joint < BODY_JOINT_COUNT; joint++)
+                *data++ = (uint8_t)(int8_t)deltas[joint];
+            continue;
+        }
+        header.wide |= (uint16_t)(1u << channel);
+        memcpy(data, keyframe ? values[channel] : deltas, sizeof(deltas));
+        data += sizeof(deltas);
+    }
+    memcpy(data, indices, sizeof(indices));
+    data += sizeof(indices);
+    memcpy(packet, &header, sizeof(header));
+    memcpy(m_state, values, sizeof(m_state));
+    return (size_t)(data - packet);
+}
+
+CPoseDecoder::CPoseDecoder()
+{
+    Reset();
+}
+
+void CPoseDecoder::Reset()
+{
+    //  The padding past the last joint stays 0 and is never read back out
+    memset(m_state, 0, sizeof(m_state));
+    m_synced = false;
+}
+
+size_t CPoseDecoder::GetPacketSize(const uint8_t *packet, size_t size)
+{
+    PosePacketHeader header;
+    if (size < sizeof(header))
+        return 0u;
+    memcpy(&header, packet, sizeof(header));
+    size_t length = sizeof(header) + POSE_PACKET_INDEX_BYTES;
+    for (size_t channel = 0; channel < POSE_CHANNEL_COUNT; channel++)
+        length += (header.wide & (1u << channel)) ? BODY_JOINT_COUNT * sizeof(int16_t) : BODY_JOINT_COUNT;
+    return length <= size ? length : 0u;
+}
+
+//  Channel stored as 16 bit values: absolute in a keyframe, otherwise added to the previous values
+static inline void DecodeWide(const uint8_t *data, int16_t *state, bool keyframe)
+{
+    size_t joint = 0;
+#if POSE_CODEC_SIMD
+    for (; joint < POSE_CODEC_LANE_JOINTS; joint += 8u)
+    {
+        __m128i values = _mm_loadu_si128((const __m128i *)(data + joint * sizeof(int16_t)));
+        if (!keyframe)
+            values = _mm_add_epi16(values, _mm_load_si128((const __m128i *)(state + joint)));
+        _mm_store_si128((__m128i *)(state + joint), values);
+    }
+#endif
+    for (; joint < BODY_JOINT_COUNT; joint++)
+    {
+        int16_t value;
+        memcpy(&value, data + joint * sizeof(int16_t), sizeof(value));
+        state[joint] = keyframe ? value : (int16_t)(uint16_t)((uint16_t)state[joint] + (uint16_t)value);
+    }
+}
+
+//  Channel stored as 8 bit differences, sign extended and added to the previous values
+static inline void DecodeNarrow(const uint8_t *data, int16_t *state)
+{
+    size_t joint = 0;
+#if POSE_CODEC_SIMD
+    for (; joint < POSE_CODEC_LANE_JOINTS; joint += 8u)
+    {
+        __m128i deltas = _mm_loadl_epi64((const __m128i *)(data + joint));
+        //  Each byte lands in the top half of a 16 bit lane, the arithmetic shift brings it down with its sign
+        deltas = _mm_srai_epi16(_mm_unpacklo_epi8(deltas, deltas), 8);
+        __m128i values = _mm_add_epi16(_mm_load_si128((const __m128i *)(state + joint)), deltas);
+        _mm_store_si128((__m128i *)(state + joint), values);
+    }
+#endif
+    for (; joint < BODY_JOINT_COUNT; joint++)
+        state[joint] = (int16_t)(uint16_t)((uint16_t)state[joint] + (uint16_t)(int16_t)(int8_t)data[joint]);
+}
+
+//  Back to floats, the padding lanes included
+static inline void Dequantize(const int16_t *state, float scale, float *out)
+{
+    float step = 1.f / scale;
+#if POSE_CODEC_SIMD
+    __m128 factor = _mm_set1_ps(step);
+    for (size_t joint = 0; joint < POSE_CODEC_LANES; joint += 8u)
+    {
+        __m128i values = _mm_load_si128((const __m128i *)(state + joint));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+        _mm_store_ps(out + joint, _mm_mul_ps(_mm_cvtepi32_ps(low), factor));
+        _mm_store_ps(out + joint + 4u, _mm_mul_ps(_mm_cvtepi32_ps(high), factor));
+    }
+#else
+    for (size_t joint = 0; joint < POSE_CODEC_LANES; joint++)
+        out[joint] = (float)state[joint] * step;
+#endif
+}
+
+size_t CPoseDecoder::Decode(const uint8_t *packet, size_t size, KeypointTraceEntry &entry)
+{
+    size_t length = GetPacketSize(packet, size);
+    if (length == 0u)
+        return 0u;
+    PosePacketHeader header;
+    memcpy(&header, packet, sizeof(header));
+    bool keyframe = (header.flags & POSE_PACKET_KEYFRAME) != 0u;
+    if (!keyframe && !m_synced)
+        return 0u;
+    //  A keyframe with a narrow channel has nothing to add its differences to
+    if (keyframe && header.wide != (uint16_t)((1u << POSE_CHANNEL_COUNT) - 1u))
+        return 0u;
+
+    const uint8_t *data = packet + sizeof(header);
+    for (size_t channel = 0; channel < POSE_CHANNEL_COUNT; channel++)
+    {
+        if (header.wide & (1u << channel))
+        {
+            DecodeWide(data, m_state[channel], keyframe);
+            data += BODY_JOINT_COUNT * sizeof(int16_t);
+        }
+        else
+        {
+            DecodeNarrow(data, m_state[channel]);
+            data += BODY_JOINT_COUNT;
+        }
+    }
+    const uint8_t *indices = data;
+    m_synced = true;
+
+    alignas(16) float values[POSE_CHANNEL_COUNT][POSE_CODEC_LANES];
+    for (size_t channel = 0; channel < POSE_CHANNEL_COUNT; channel++)
+        Dequantize(m_state[channel], c_channelScale[channel], values[channel]);
+
+    for (size_t joint = 0; joint < BODY_JOINT_COUNT; joint++)
+    {
+        entry.keypoints3D[joint].x = values[(size_t)POSE_CHANNEL::X3D][joint];
+        entry.keypoints3D[joint].y = values[(size_t)POSE_CHANNEL::Y3D][joint];
+        entry.keypoints3D[joint].z = values[(size_t)POSE_CHANNEL::Z3D][joint];
+        entry.keypoints[joint].x = values[(size_t)POSE_CHANNEL::X2D][joint];
+        entry.keypoints[joint].y = values[(size_t)POSE_CHANNEL::Y2D][joint];
+        entry.confidence[joint] = values[(size_t)POSE_CHANNEL::CONFIDENCE][joint];
+
+        //  The dropped component is whatever keeps the quaternion at unit length
+        float small[3] =
+        {
+            values[(size_t)POSE_CHANNEL::QUAT_A][joint],
+            values[(size_t)POSE_CHANNEL::QUAT_B][joint],
+            values[(size_t)POSE_CHANNEL::QUAT_C][joint]
+        };
+        float largest = std::sqrt((std::max)(0.f, 1.f - small[0] * small[0] - small[1] * small[1] - small[2] * small[2]));
+        uint8_t dropped = (uint8_t)((indices[joint >> 2] >> ((joint & 3u) * 2u)) & 3u);
+        float q[4];
+        for (uint8_t index = 0u, component = 0u; index < 4u; index++)
+            q[index] = index == dropped ? largest : small[component++];
+        entry.jointAngles[joint].x = q[0];
+        entry.jointAngles[joint].y = q[1];
+        entry.jointAngles[joint].z = q[2];
+        entry.jointAngles[joint].w = q[3];
+    }
+    return length;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "CKeypointTrace.h"
+
+//  Fixed point steps of the quantized values: 1/2048 m for 3D keypoints (+-16 m), 1/4 pixel for 2D keypoints
+//  (+-8192 px), 1/1024 for confidences and 1/16384 for quaternion components, which are at most 1/sqrt(2) once the
+//  largest one is dropped. All are finer than the SDK's own jitter
+#define POSE_CODEC_SCALE_3D 2048.f
+#define POSE_CODEC_SCALE_2D 4.f
+#define POSE_CODEC_SCALE_CONFIDENCE 1024.f
+#define POSE_CODEC_SCALE_QUAT 16384.f
+//  Packets from one keyframe to the next by default, a second at 60 Hz: the longest a reader joining a stream waits
+#define POSE_CODEC_KEYFRAME_INTERVAL 60u
+//  Joints of a channel rounded up to whole 8 value lanes, the decoder's state is kept padded to it
+#define POSE_CODEC_LANES ((BODY_JOINT_COUNT + 7u) & ~(size_t)7u)
+
+//  Channels of a packet, each one value per joint. A quaternion is stored as its three smallest components,
+//  in x, y, z, w order with the largest one left out and its sign folded into the others
+enum class POSE_CHANNEL
+{
+    X3D,
+    Y3D,
+    Z3D,
+    X2D,
+    Y2D,
+    QUAT_A,
+    QUAT_B,
+    QUAT_C,
+    CONFIDENCE,
+    COUNT
+};
+#define POSE_CHANNEL_COUNT ((size_t)POSE_CHANNEL::COUNT)
+
+//  Flags of PosePacketHeader
+#define POSE_PACKET_KEYFRAME 0x1u
+
+//  One KeypointTraceEntry, quantized and encoded against the packet before it
+//  A packet is this header, then every channel in POSE_CHANNEL order, then which quaternion component was left out
+//  for every joint (2 bits each, 4 joints a byte). Keyframes store every channel as absolute 16 bit values; other
+//  packets store the difference to the previous packet's values, as 8 bit when the whole channel fits in it
+//  Differences wrap around like 16 bit integers do, so decoding is exact and never drifts from the encoder
+//  Nothing in a packet refers to the file or pipe it travels in, so traces and IPC export share the same packets
+struct PosePacketHeader
+{
+    uint8_t flags;
+    uint8_t reserved;
+    //  Bit n is set when channel n is stored as 16 bit values, always all of them in a keyframe
+    uint16_t wide;
+};
+
+#define POSE_PACKET_INDEX_BYTES ((BODY_JOINT_COUNT + 3u) / 4u)
+//  Largest a packet gets, a keyframe: less than half of a KeypointTraceEntry
+#define POSE_PACKET_MAX (sizeof(PosePacketHeader) + POSE_CHANNEL_COUNT * BODY_JOINT_COUNT * sizeof(int16_t) + POSE_PACKET_INDEX_BYTES)
+
+static_assert(sizeof(PosePacketHeader) == 4u, "Pose packet header layout changed");
+static_assert(POSE_CHANNEL_COUNT <= 16u, "Pose packet header has a bit per channel");
+
+//  Encodes consecutive entries of one stream, e.g. the newest inference run of every frame
+class CPoseEncoder
+{
+    //  Quantized values of the previous packet, what the decoder holds once it has read it
+    int16_t m_state[POSE_CHANNEL_COUNT][BODY_JOINT_COUNT];
+    uint32_t m_interval;
+    //  Packets since the last keyframe, the next packet is a keyframe once it reaches m_interval
+    uint32_t m_sinceKeyframe;
+public:
+    //  An interval of 0 makes every packet a keyframe
+    explicit CPoseEncoder(uint32_t keyframeInterval = POSE_CODEC_KEYFRAME_INTERVAL);
+
+    //  Make the next packet a keyframe, for a reader that just joined or lost packets
+    void Reset();
+    //  Write the entry's packet to packet (at least POSE_PACKET_MAX bytes) and return its size
+    size_t Encode(const KeypointTraceEntry &entry, uint8_t *packet);
+};
+
+//  Decodes the packets of one CPoseEncoder, in the order they were encoded
+//  Channels are rebuilt and converted back to floats 8 joints at a time with SSE2 where it is available
+class CPoseDecoder
+{
+    alignas(16) int16_t m_state[POSE_CHANNEL_COUNT][POSE_CODEC_LANES];
+    //  Whether a keyframe was read, the packets after it can only be decoded from there
+    bool m_synced;
+public:
+    CPoseDecoder();
+
+    //  Forget the stream, packets are skipped until the next keyframe
+    void Reset();
+    inline bool IsSynced() const { return m_synced; }
+    //  Size of the packet that starts at packet, 0 if fewer than size bytes are left for it
+    static size_t GetPacketSize(const uint8_t *packet, size_t size);
+    //  Decode the packet at packet into entry and return its size, or return 0 and leave entry alone when the
+    //  packet is cut short or follows no keyframe
+    size_t Decode(const uint8_t *packet, size_t size, KeypointTraceEntry &entry);
+};
@@ -0,0 +1,196 @@
+#include "pch.h"
+#include "CPosePublisher.h"
+#include "CServerDriver.h"
+#include "CTrackerBank.h"
+#include "CVirtualBodyTracker.h"
+#include "CVirtualBaseStation.h"
+#include "CStatsExport.h"
+#include "CCommon.h"
+
+CPosePublisher::CPosePublisher(CServerDriver *driver)
+{
+    m_driver = driver;
+    m_thread = nullptr;
+    m_period = 1.0 / 90.0;
+    m_lastFrame = -1.0;
+    m_frameId = 0u;
+    m_windowStart = systime();
+    m_jitterSum = 0.0;
+    m_jitterMax = 0.0;
+    m_frames = 0u;
+    m_overruns = 0u;
+    m_overrunTotal = 0u;
+    m_submitted = 0u;
+    m_skipped = 0u;
+    m_stats = { m_period.load(), 0.0, 0.0, 0u, 0u, 0u, 0u };
+    m_stationFlip = RigidTransform(glm::vec3(0.f), CServerDriver::DoEulerYXZ(0.f, M_PI, 0.f));
+}
+
+CPosePublisher::~CPosePublisher()
+{
+    Stop();
+}
+
+void CPosePublisher::Start(CThreadSupervisor &threads)
+{
+    if (m_thread != nullptr)
+        return;
+    //  Default Windows timer resolution (15.6 ms) is far too coarse to pace display frames
+    timeBeginPeriod(1);
+    m_thread = threads.Spawn("Publisher", [this](const CStopToken &token) { Run(token); });
+}
+
+bool CPosePublisher::Stop()
+{
+    if (m_thread == nullptr)
+        return true;
+    m_thread->RequestStop();
+    bool stopped = m_thread->Join();
+    //  The supervisor owns the thread object
+    m_thread = nullptr;
+    timeEndPeriod(1);
+    return stopped;
+}
+
+void CPosePublisher::ReportFrame(double now)
+{
+    if (m_lastFrame >= 0.0)
+    {
+        double interval = (std::min)((std::max)(now - m_lastFrame, PUBLISHER_PERIOD_MIN), PUBLISHER_PERIOD_MAX);
+        double period = m_period.load();
+        m_period.store(period + (interval - period) * PUBLISHER_PERIOD_SMOOTHING);
+    }
+    m_lastFrame = now;
+}
+
+const PublisherStats CPosePublisher::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void CPosePublisher::Run(const CStopToken &token)
+{
+    ApplyThreadPlacement(m_driver->GetThreadPlacement(THREAD_ROLE::PUBLISHER), THREAD_ROLE::PUBLISHER);
+    vr_log("Pose publisher started");
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    while (!token.StopRequested())
+    {
+        //  Nothing moves in standby, the devices keep their last submitted poses
+        if (m_driver->IsStandby())
+        {
+            //  The overlay still shows the driver as alive, and in standby
+            if (m_driver->m_statsExport != nullptr)
+                m_driver->m_statsExport->Update(*m_driver, systime());
+            if (!token.SleepFor(PUBLISHER_STANDBY_POLL))
+                break;
+            next = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        std::chrono::duration<double> period(m_period.load());
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        if (!token.SleepUntil(next))
+            break;
+
+        std::chrono::steady_clock::time_point woke = std::chrono::steady_clock::now();
+        double late = std::chrono::duration<double>(woke - next).count();
+        //  A whole period behind (the machine stalled), start over from now instead of publishing a burst
+        bool overrun = late > period.count();
+        if (overrun)
+            next = woke;
+
+        double now = systime();
+        Publish(now);
+        RecordTiming(late, overrun, now);
+        if (m_driver->m_statsExport != nullptr)
+            m_driver->m_statsExport->Update(*m_driver, now);
+    }
+    vr_log("Pose publisher stopped");
+}
+
+void CPosePublisher::Publish(double now)
+{
+    CServerDriver &driv = *m_driver;
+    int64_t start = LatencyNow();
+
+    //  Take in the newest inference, if the camera thread published one since the last submission
+    int64_t captureStart = 0;
+    if (driv.m_poseSnapshots->Acquire())
+    {
+        const PoseSnapshot &snapshot = driv.m_poseSnapshots->Read();
+        captureStart = snapshot.active ? snapshot.captureStart : 0;
+        m_frameId = snapshot.frameId;
+        driv.m_trackerBank->Ingest(snapshot);
+        for (auto tracker : driv.m_trackers)
+            tracker->SetStandby(!snapshot.valid[tracker->m_index]);
+        driv.m_station->SetStandby(!snapshot.active);
+        driv.m_station->SetTransform(snapshot.offset * m_stationFlip);
+    }
+
+    //  Every tracker is interpolated in one pass for this timestamp, then each submits its lane
+    driv.m_trackerBank->Evaluate(now);
+    int64_t submitStart = LatencyNow();
+    for (auto tracker : driv.m_trackers)
+        tracker->RunFrame();
+    driv.m_station->RunFrame();
+    int64_t end = LatencyNow();
+
+    //  The first submission of a frame's poses closes its end to end latency
+    if (captureStart != 0)
+        driv.GetLatency().Record(LATENCY_STAGE::END_TO_END, end - captureStart);
+    driv.GetTrace().Record("Submit", m_frameId, submitStart, end);
+    driv.GetTrace().Record("Publish", m_frameId, start, end);
+}
+
+void CPosePublisher::RecordTiming(double late, bool overrun, double now)
+{
+    m_jitterSum += late;
+    m_jitterMax = (std::max)(m_jitterMax, late);
+    m_frames++;
+    if (overrun)
+    {
+        m_overruns++;
+        m_overrunTotal++;
+    }
+
+    if (now - m_windowStart < PUBLISHER_REPORT_INTERVAL)
+        return;
+
+    uint64_t submitted = m_driver->m_station->GetSubmitCount(), skipped = m_driver->m_station->GetSkipCount();
+    for (auto tracker : m_driver->m_trackers)
+    {
+        submitted += tracker->GetSubmitCount();
+        skipped += tracker->GetSkipCount();
+    }
+
+    PublisherStats stats = {
+        m_period.load(), m_jitterSum / (double)m_frames, m_jitterMax, m_frames, m_overruns,
+        submitted - m_submitted, skipped - m_skipped
+    };
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats = stats;
+    }
+    vr_log(
+        "Pose publisher: %.1f Hz, jitter mean %.3f ms, max %.3f ms, %llu overruns in %llu frames, %llu poses submitted, %llu skipped",
+        1.0 / stats.period,
+        stats.jitterMean * 1000.0,
+        stats.jitterMax * 1000.0,
+        (unsigned long long)stats.overruns,
+        (unsigned long long)stats.frames,
+        (unsigned long long)stats.submitted,
+        (unsigned long long)stats.skipped
+    );
+    m_driver->GetLatency().CloseWindow(now - m_windowStart);
+    vr_log("Pipeline latency over the last %.0f s:", now - m_windowStart);
+    m_driver->GetLatency().Report();
+
+    m_windowStart = now;
+    m_jitterSum = 0.0;
+    m_jitterMax = 0.0;
+    m_frames = 0u;
+    m_overruns = 0u;
+    m_submitted = submitted;
+    m_skipped = skipped;
+}
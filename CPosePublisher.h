@@ -0,0 +1,86 @@
+#pragma once
+#include "CManagedThread.h"
+
+class CServerDriver;
+
+//  Weight given to each new RunFrame interval when estimating the display period
+#define PUBLISHER_PERIOD_SMOOTHING 0.05
+//  Bounds on the publishing period, in seconds
+#define PUBLISHER_PERIOD_MIN (1.0 / 240.0)
+#define PUBLISHER_PERIOD_MAX (1.0 / 30.0)
+//  How often the submission timing is written to the log, in seconds
+#define PUBLISHER_REPORT_INTERVAL 10.0
+//  How often the publisher checks whether standby ended (seconds)
+#define PUBLISHER_STANDBY_POLL 0.1
+
+//  Submission timing of the pose publisher over the last report interval
+struct PublisherStats
+{
+    //  Publishing period currently in use (seconds)
+    double period;
+    //  How late submissions started relative to their schedule (seconds)
+    double jitterMean;
+    double jitterMax;
+    //  Submissions made, and the ones that fell a whole period behind and were rescheduled
+    uint64_t frames;
+    uint64_t overruns;
+    //  Device poses handed to vrserver, and the unchanged ones that were skipped
+    uint64_t submitted;
+    uint64_t skipped;
+};
+
+//  Submits every tracker and base station pose from its own thread, paced to the measured display period
+//  It ingests the snapshots published by the camera thread and owns the tracker bank from then on,
+//  leaving CServerDriver::RunFrame with events, bindings and other control work
+class CPosePublisher
+{
+    CServerDriver *m_driver;
+    //  Owned by the driver's thread supervisor
+    CManagedThread *m_thread;
+
+    //  Estimated display period (seconds), measured from the RunFrame cadence
+    std::atomic<double> m_period;
+    double m_lastFrame;
+    //  Camera frame of the newest snapshot ingested, tags the publisher's trace spans
+    uint64_t m_frameId;
+
+    //  Timing of the current report window, only touched by the publisher thread
+    double m_windowStart;
+    double m_jitterSum;
+    double m_jitterMax;
+    uint64_t m_frames;
+    uint64_t m_overruns;
+    //  Overruns since startup, for the stats export
+    uint64_t m_overrunTotal;
+    //  Device submission totals at the start of the window
+    uint64_t m_submitted;
+    uint64_t m_skipped;
+
+    mutable std::mutex m_statsMutex;
+    PublisherStats m_stats;
+
+    //  Base station faces the play space, the camera looks the other way
+    RigidTransform m_stationFlip;
+
+    CPosePublisher(const CPosePublisher &that) = delete;
+    CPosePublisher &operator=(const CPosePublisher &that) = delete;
+
+    void Run(const CStopToken &token);
+    void RecordTiming(double late, bool overrun, double now);
+public:
+    explicit CPosePublisher(CServerDriver *driver);
+    ~CPosePublisher();
+
+    void Start(CThreadSupervisor &threads);
+    //  Returns false if the thread had to be detached, the publisher must then be leaked
+    bool Stop();
+
+    //  Ingest the newest snapshot and submit every pose for the given time, once per display frame on the publisher thread
+    void Publish(double now);
+    //  Called by RunFrame with its timestamp, the intervals between calls give the display period
+    void ReportFrame(double now);
+
+    const PublisherStats GetStats() const;
+    //  Publisher thread only
+    inline uint64_t GetOverrunTotal() const { return m_overrunTotal; }
+};
@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "CPresenceProbe.h"
+#include "CCommon.h"
+
+const char *PresenceModeName[] = {
+    "Tracking",
+    "Probing"
+};
+
+CPresenceProbe::CPresenceProbe()
+{
+    m_mode = PRESENCE_MODE::TRACKING;
+    m_probeInterval = 0.0;
+    m_absentLimit = 0u;
+    m_absent = 0u;
+    m_lastRun = -1.0;
+    m_modeStart = systime();
+    for (auto &time : m_modeTime)
+        time.store(0.0, std::memory_order_relaxed);
+    m_skipped = 0u;
+}
+
+void CPresenceProbe::Configure(double probeRate, unsigned absentFrames)
+{
+    m_probeInterval = probeRate > 0.0 ? 1.0 / probeRate : 0.0;
+    m_absentLimit = (std::max)(absentFrames, 1u);
+}
+
+void CPresenceProbe::Transition(PRESENCE_MODE mode, double now)
+{
+    PRESENCE_MODE previous = m_mode.exchange(mode, std::memory_order_relaxed);
+    if (previous == mode)
+        return;
+    //  Only this thread writes them, readers may briefly see the stretch that just ended in neither mode or in both
+    double start = m_modeStart.load(std::memory_order_relaxed);
+    m_modeTime[(size_t)previous].store(m_modeTime[(size_t)previous].load(std::memory_order_relaxed) + now - start, std::memory_order_relaxed);
+    m_modeStart.store(now, std::memory_order_relaxed);
+    vr_log(
+        "Presence: %s -> %s (%.1f s tracking, %.1f s probing, %llu frames skipped)",
+        PresenceModeName[(int)previous],
+        PresenceModeName[(int)mode],
+        m_modeTime[(size_t)PRESENCE_MODE::TRACKING].load(std::memory_order_relaxed),
+        m_modeTime[(size_t)PRESENCE_MODE::PROBING].load(std::memory_order_relaxed),
+        (unsigned long long)GetSkipped()
+    );
+}
+
+bool CPresenceProbe::ShouldRun(double now)
+{
+    if (GetMode() == PRESENCE_MODE::PROBING && now - m_lastRun < m_probeInterval)
+    {
+        m_skipped++;
+        return false;
+    }
+    m_lastRun = now;
+    return true;
+}
+
+void CPresenceProbe::Report(bool present, double now)
+{
+    if (present)
+    {
+        //  The very next frame runs at the full rate again
+        m_absent = 0u;
+        Transition(PRESENCE_MODE::TRACKING, now);
+        return;
+    }
+    if (m_probeInterval > 0.0 && ++m_absent >= m_absentLimit)
+        Transition(PRESENCE_MODE::PROBING, now);
+}
+
+double CPresenceProbe::GetTimeInMode(PRESENCE_MODE mode, double now) const
+{
+    double time = m_modeTime[(size_t)mode].load(std::memory_order_relaxed);
+    if (GetMode() == mode)
+        time += (std::max)(now - m_modeStart.load(std::memory_order_relaxed), 0.0);
+    return time;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+//  Whether a body is being tracked, or inference only runs now and then to find one
+enum class PRESENCE_MODE
+{
+    TRACKING,
+    PROBING,
+    COUNT
+};
+extern const char *PresenceModeName[];
+
+//  Drops inference to a low probe rate while nobody is in frame, and back to every frame as soon as a probe finds a body
+//  Only the camera thread calls into it, the mode is atomic so other threads can read it
+class CPresenceProbe
+{
+    std::atomic<PRESENCE_MODE> m_mode;
+    //  Seconds between inferences while probing (0 never probes), and inferences without a body before probing starts
+    double m_probeInterval;
+    unsigned m_absentLimit;
+
+    unsigned m_absent;
+    double m_lastRun;
+    //  Read by the stats export as well
+    std::atomic<double> m_modeStart;
+    //  Time spent in each mode before the current one started
+    std::atomic<double> m_modeTime[(size_t)PRESENCE_MODE::COUNT];
+    //  Read by the stats export as well
+    std::atomic<uint64_t> m_skipped;
+
+    void Transition(PRESENCE_MODE mode, double now);
+public:
+    CPresenceProbe();
+
+    void Configure(double probeRate, unsigned absentFrames);
+    //  Whether this camera frame should go through inference, frames skipped while probing are counted
+    bool ShouldRun(double now);
+    //  Result of an inference that did run
+    void Report(bool present, double now);
+
+    inline PRESENCE_MODE GetMode() const { return m_mode.load(std::memory_order_relaxed); }
+    //  Seconds spent in the mode since startup, the current stretch included; from any thread
+    double GetTimeInMode(PRESENCE_MODE mode, double now) const;
+    inline uint64_t GetSkipped() const { return m_skipped.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,501 @@
+#pragma once
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define RIGID_TRANSFORM_SIMD 1
+#include <emmintrin.h>
+#else
+#define RIGID_TRANSFORM_SIMD 0
+#endif
+
+#include <cmath>
+
+//  Dot products above this are blended linearly, as slerp becomes numerically unstable
+#define RIGID_SLERP_THRESHOLD 0.9995f
+
+//  A rotation followed by a translation, the only kind of transform trackers and the camera ever use
+//  Kept as two 16 byte lanes so compose / inverse / apply / blend never go through a 4x4 matrix
+//  Rotation is stored (x, y, z, w) and position (x, y, z, 0)
+struct alignas(16) RigidTransform
+{
+    float q[4];
+    float p[4];
+
+    inline RigidTransform()
+    {
+        q[0] = 0.f; q[1] = 0.f; q[2] = 0.f; q[3] = 1.f;
+        p[0] = 0.f; p[1] = 0.f; p[2] = 0.f; p[3] = 0.f;
+    }
+    inline RigidTransform(const glm::vec3 &pos, const glm::quat &rot)
+    {
+        SetRotation(rot);
+        SetPosition(pos);
+    }
+    //  Only valid for matrices without scale or shear
+    inline explicit RigidTransform(const glm::mat4x4 &mat) : RigidTransform(glm::vec3(mat[3]), glm::quat_cast(mat)) {}
+
+    inline void SetPosition(const glm::vec3 &pos) { p[0] = pos.x; p[1] = pos.y; p[2] = pos.z; p[3] = 0.f; }
+    inline void SetRotation(const glm::quat &rot) { q[0] = rot.x; q[1] = rot.y; q[2] = rot.z; q[3] = rot.w; }
+
+    inline const glm::vec3 Position() const { return glm::vec3(p[0], p[1], p[2]); }
+    inline const glm::quat Rotation() const { return glm::quat(q[3], q[0], q[1], q[2]); }
+    const glm::mat4x4 Matrix() const;
+
+    const RigidTransform operator*(const RigidTransform &other) const;
+    const RigidTransform Inverse() const;
+    //  Same translation, inverted rotation
+    const RigidTransform InverseRotation() const;
+    const glm::vec3 Apply(const glm::vec3 &point) const;
+    const glm::vec3 Rotate(const glm::vec3 &vector) const;
+
+    //  Flip the rotation about an axis, matching CNvSDKInterface::MirrorQuaternionX/Y/Z
+    const RigidTransform MirrorX() const;
+    const RigidTransform MirrorY() const;
+    const RigidTransform MirrorZ() const;
+
+    static const RigidTransform Nlerp(const RigidTransform &a, const RigidTransform &b, float t);
+    static const RigidTransform Slerp(const RigidTransform &a, const RigidTransform &b, float t);
+
+    static const glm::quat QuatMultiply(const glm::quat &a, const glm::quat &b);
+    static const glm::quat QuatNlerp(const glm::quat &a, const glm::quat &b, float t);
+};
+
+#if RIGID_TRANSFORM_SIMD
+
+namespace RigidSimd
+{
+    inline __m128 Dot4(__m128 a, __m128 b)
+    {
+        __m128 m = _mm_mul_ps(a, b);
+        m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+
+    inline __m128 Normalize4(__m128 a)
+    {
+        return _mm_div_ps(a, _mm_sqrt_ps(Dot4(a, a)));
+    }
+
+    inline __m128 Cross3(__m128 a, __m128 b)
+    {
+        __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    //  Hamilton product of two (x, y, z, w) quaternions
+    inline __m128 QuatMul(__m128 a, __m128 b)
+    {
+        const __m128 signW = _mm_set_ps(-0.f, 0.f, 0.f, 0.f);
+        __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+        __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 2, 1, 0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 3, 3)));
+        __m128 t2 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 0, 2)));
+        __m128 t3 = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 1, 0, 2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 0, 2, 1)));
+        __m128 r = _mm_add_ps(t0, _mm_xor_ps(_mm_add_ps(t1, t2), signW));
+        return _mm_sub_ps(r, t3);
+    }
+
+    inline __m128 QuatConjugate(__m128 a)
+    {
+        return _mm_xor_ps(a, _mm_set_ps(0.f, -0.f, -0.f, -0.f));
+    }
+
+    //  v + w * t + u x t, where t = 2 * (u x v)
+    inline __m128 QuatRotate(__m128 q, __m128 v)
+    {
+        __m128 t = Cross3(q, v);
+        t = _mm_add_ps(t, t);
+        __m128 w = _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 r = _mm_add_ps(v, _mm_add_ps(_mm_mul_ps(w, t), Cross3(q, t)));
+        //  Keep the unused lane at zero
+        return _mm_and_ps(r, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+    }
+
+    //  Flip b onto a's hemisphere without branching
+    inline __m128 AlignHemisphere(__m128 a, __m128 b, __m128 &dot)
+    {
+        dot = Dot4(a, b);
+        __m128 sign = _mm_and_ps(dot, _mm_set1_ps(-0.f));
+        dot = _mm_xor_ps(dot, sign);
+        return _mm_xor_ps(b, sign);
+    }
+
+    inline __m128 Lerp(__m128 a, __m128 b, __m128 t)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+}
+
+inline const RigidTransform RigidTransform::operator*(const RigidTransform &other) const
+{
+    RigidTransform result;
+    __m128 qa = _mm_load_ps(q);
+    _mm_store_ps(result.q, RigidSimd::QuatMul(qa, _mm_load_ps(other.q)));
+    _mm_store_ps(result.p, _mm_add_ps(_mm_load_ps(p), RigidSimd::QuatRotate(qa, _mm_load_ps(other.p))));
+    return result;
+}
+
+inline const RigidTransform RigidTransform::Inverse() const
+{
+    RigidTransform result;
+    __m128 inv = RigidSimd::QuatConjugate(_mm_load_ps(q));
+    _mm_store_ps(result.q, inv);
+    _mm_store_ps(result.p, _mm_sub_ps(_mm_setzero_ps(), RigidSimd::QuatRotate(inv, _mm_load_ps(p))));
+    return result;
+}
+
+inline const RigidTransform RigidTransform::InverseRotation() const
+{
+    RigidTransform result;
+    _mm_store_ps(result.q, RigidSimd::QuatConjugate(_mm_load_ps(q)));
+    _mm_store_ps(result.p, _mm_load_ps(p));
+    return result;
+}
+
+inline const glm::vec3 RigidTransform::Apply(const glm::vec3 &point) const
+{
+    alignas(16) float out[4];
+    __m128 v = _mm_set_ps(0.f, point.z, point.y, point.x);
+    _mm_store_ps(out, _mm_add_ps(_mm_load_ps(p), RigidSimd::QuatRotate(_mm_load_ps(q), v)));
+    return glm::vec3(out[0], out[1], out[2]);
+}
+
+inline const glm::vec3 RigidTransform::Rotate(const glm::vec3 &vector) const
+{
+    alignas(16) float out[4];
+    __m128 v = _mm_set_ps(0.f, vector.z, vector.y, vector.x);
+    _mm_store_ps(out, RigidSimd::QuatRotate(_mm_load_ps(q), v));
+    return glm::vec3(out[0], out[1], out[2]);
+}
+
+inline const RigidTransform RigidTransform::MirrorX() const
+{
+    RigidTransform result = *this;
+    _mm_store_ps(result.q, _mm_xor_ps(_mm_load_ps(q), _mm_set_ps(0.f, -0.f, -0.f, 0.f)));
+    return result;
+}
+
+inline const RigidTransform RigidTransform::MirrorY() const
+{
+    RigidTransform result = *this;
+    _mm_store_ps(result.q, _mm_xor_ps(_mm_load_ps(q), _mm_set_ps(0.f, -0.f, 0.f, -0.f)));
+    return result;
+}
+
+inline const RigidTransform RigidTransform::MirrorZ() const
+{
+    RigidTransform result = *this;
+    _mm_store_ps(result.q, _mm_xor_ps(_mm_load_ps(q), _mm_set_ps(0.f, 0.f, -0.f, -0.f)));
+    return result;
+}
+
+inline const RigidTransform RigidTransform::Nlerp(const RigidTransform &a, const RigidTransform &b, float t)
+{
+    RigidTransform result;
+    __m128 weight = _mm_set1_ps(t), dot;
+    __m128 qa = _mm_load_ps(a.q);
+    __m128 qb = RigidSimd::AlignHemisphere(qa, _mm_load_ps(b.q), dot);
+    _mm_store_ps(result.q, RigidSimd::Normalize4(RigidSimd::Lerp(qa, qb, weight)));
+    _mm_store_ps(result.p, RigidSimd::Lerp(_mm_load_ps(a.p), _mm_load_ps(b.p), weight));
+    return result;
+}
+
+inline const RigidTransform RigidTransform::Slerp(const RigidTransform &a, const RigidTransform &b, float t)
+{
+    __m128 dot;
+    __m128 qa = _mm_load_ps(a.q);
+    __m128 qb = RigidSimd::AlignHemisphere(qa, _mm_load_ps(b.q), dot);
+    float cosTheta = _mm_cvtss_f32(dot);
+    if (cosTheta > RIGID_SLERP_THRESHOLD)
+        return Nlerp(a, b, t);
+
+    RigidTransform result;
+    float theta = std::acos(cosTheta);
+    float invSin = 1.f / std::sin(theta);
+    __m128 wa = _mm_set1_ps(std::sin((1.f - t) * theta) * invSin);
+    __m128 wb = _mm_set1_ps(std::sin(t * theta) * invSin);
+    _mm_store_ps(result.q, _mm_add_ps(_mm_mul_ps(qa, wa), _mm_mul_ps(qb, wb)));
+    _mm_store_ps(result.p, RigidSimd::Lerp(_mm_load_ps(a.p), _mm_load_ps(b.p), _mm_set1_ps(t)));
+    return result;
+}
+
+inline const glm::quat RigidTransform::QuatMultiply(const glm::quat &a, const glm::quat &b)
+{
+    alignas(16) float out[4];
+    _mm_store_ps(out, RigidSimd::QuatMul(_mm_set_ps(a.w, a.z, a.y, a.x), _mm_set_ps(b.w, b.z, b.y, b.x)));
+    return glm::quat(out[3], out[0], out[1], out[2]);
+}
+
+inline const glm::quat RigidTransform::QuatNlerp(const glm::quat &a, const glm::quat &b, float t)
+{
+    alignas(16) float out[4];
+    __m128 dot;
+    __m128 qa = _mm_set_ps(a.w, a.z, a.y, a.x);
+    __m128 qb = RigidSimd::AlignHemisphere(qa, _mm_set_ps(b.w, b.z, b.y, b.x), dot);
+    _mm_store_ps(out, RigidSimd::Normalize4(RigidSimd::Lerp(qa, qb, _mm_set1_ps(t))));
+    return glm::quat(out[3], out[0], out[1], out[2]);
+}
+
+#else
+
+inline const glm::quat RigidTransform::QuatMultiply(const glm::quat &a, const glm::quat &b)
+{
+    return a * b;
+}
+
+inline const glm::quat RigidTransform::QuatNlerp(const glm::quat &a, const glm::quat &b, float t)
+{
+    glm::quat target = glm::dot(a, b) < 0.f ? -b : b;
+    return glm::normalize(glm::quat(
+        a.w + (target.w - a.w) * t,
+        a.x + (target.x - a.x) * t,
+        a.y + (target.y - a.y) * t,
+        a.z + (target.z - a.z) * t
+    ));
+}
+
+inline const RigidTransform RigidTransform::operator*(const RigidTransform &other) const
+{
+    return RigidTransform(Apply(other.Position()), Rotation() * other.Rotation());
+}
+
+inline const RigidTransform RigidTransform::Inverse() const
+{
+    glm::quat inv = glm::conjugate(Rotation());
+    return RigidTransform(-(inv * Position()), inv);
+}
+
+inline const RigidTransform RigidTransform::InverseRotation() const
+{
+    return RigidTransform(Position(), glm::conjugate(Rotation()));
+}
+
+inline const glm::vec3 RigidTransform::Apply(const glm::vec3 &point) const
+{
+    return Position() + Rotation() * point;
+}
+
+inline const glm::vec3 RigidTransform::Rotate(const glm::vec3 &vector) const
+{
+    return Rotation() * vector;
+}
+
+inline const RigidTransform RigidTransform::MirrorX() const
+{
+    RigidTransform result = *this;
+    result.q[1] = -q[1]; result.q[2] = -q[2];
+    return result;
+}
+
+inline const RigidTransform RigidTransform::MirrorY() const
+{
+    RigidTransform result = *this;
+    result.q[0] = -q[0]; result.q[2] = -q[2];
+    return result;
+}
+
+inline const RigidTransform RigidTransform::MirrorZ() const
+{
+    RigidTransform result = *this;
+    result.q[0] = -q[0]; result.q[1] = -q[1];
+    return result;
+}
+
+inline const RigidTransform RigidTransform::Nlerp(const RigidTransform &a, const RigidTransform &b, float t)
+{
+    return RigidTransform(glm::mix(a.Position(), b.Position(), t), QuatNlerp(a.Rotation(), b.Rotation(), t));
+}
+
+inline const RigidTransform RigidTransform::Slerp(const RigidTransform &a, const RigidTransform &b, float t)
+{
+    return RigidTransform(glm::mix(a.Position(), b.Position(), t), glm::slerp(a.Rotation(), b.Rotation(), t));
+}
+
+#endif
+
+inline const glm::mat4x4 RigidTransform::Matrix() const
+{
+    float xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+    float xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+    float wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+
+    glm::mat4x4 result(1.f);
+    result[0][0] = 1.f - 2.f * (yy + zz);
+    result[0][1] = 2.f * (xy + wz);
+    result[0][2] = 2.f * (xz - wy);
+
+    result[1][0] = 2.f * (xy - wz);
+    result[1][1] = 1.f - 2.f * (xx + zz);
+    result[1][2] = 2.f * (yz + wx);
+
+    result[2][0] = 2.f * (xz + wy);
+    result[2][1] = 2.f * (yz - wx);
+    result[2][2] = 1.f - 2.f * (xx + yy);
+
+    result[3][0] = p[0];
+    result[3][1] = p[1];
+    result[3][2] = p[2];
+    return result;
+}
+
+//  The most transforms a TransformLanes block holds (one per tracker), kept a multiple of 4 for the SIMD kernels
+#define TRANSFORM_LANES_MAX 16
+
+//  Structure-of-arrays block of rigid transforms, so a whole set of trackers can be blended in one pass
+//  Kernels work on groups of 4 lanes; unused lanes stay at identity and are processed along with the rest
+struct alignas(16) TransformLanes
+{
+    float px[TRANSFORM_LANES_MAX];
+    float py[TRANSFORM_LANES_MAX];
+    float pz[TRANSFORM_LANES_MAX];
+    float qx[TRANSFORM_LANES_MAX];
+    float qy[TRANSFORM_LANES_MAX];
+    float qz[TRANSFORM_LANES_MAX];
+    float qw[TRANSFORM_LANES_MAX];
+
+    inline TransformLanes()
+    {
+        for (size_t lane = 0; lane < TRANSFORM_LANES_MAX; lane++)
+            Set(lane, RigidTransform());
+    }
+
+    inline const RigidTransform Get(size_t lane) const
+    {
+        return RigidTransform(glm::vec3(px[lane], py[lane], pz[lane]), glm::quat(qw[lane], qx[lane], qy[lane], qz[lane]));
+    }
+    inline void Set(size_t lane, const RigidTransform &transform)
+    {
+        px[lane] = transform.p[0]; py[lane] = transform.p[1]; pz[lane] = transform.p[2];
+        qx[lane] = transform.q[0]; qy[lane] = transform.q[1]; qz[lane] = transform.q[2]; qw[lane] = transform.q[3];
+    }
+
+    //  Number of lanes the kernels actually touch for count transforms
+    static inline size_t Span(size_t count) { return (count + 3u) & ~(size_t)3u; }
+
+    //  out.p = a.p * weight (+ out.p when accumulating)
+    static void ScalePositions(const TransformLanes &a, float weight, TransformLanes &out, size_t count, bool accumulate);
+    //  out.p = lerp(a.p, b.p, t)
+    static void LerpPositions(const TransformLanes &a, const TransformLanes &b, float t, TransformLanes &out, size_t count);
+    //  out.q = normalize(lerp(a.q, b.q, t)), with b flipped onto a's hemisphere per lane
+    static void NlerpRotations(const TransformLanes &a, const TransformLanes &b, float t, TransformLanes &out, size_t count);
+    //  Flip each rotation of inout onto the hemisphere of the matching rotation in ref
+    static void AlignRotations(const TransformLanes &ref, TransformLanes &inout, size_t count);
+};
+
+#if RIGID_TRANSFORM_SIMD
+
+inline void TransformLanes::ScalePositions(const TransformLanes &a, float weight, TransformLanes &out, size_t count, bool accumulate)
+{
+    __m128 w = _mm_set1_ps(weight);
+    __m128 keep = accumulate ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : _mm_setzero_ps();
+    for (size_t lane = 0; lane < Span(count); lane += 4)
+    {
+        _mm_store_ps(out.px + lane, _mm_add_ps(_mm_and_ps(_mm_load_ps(out.px + lane), keep), _mm_mul_ps(_mm_load_ps(a.px + lane), w)));
+        _mm_store_ps(out.py + lane, _mm_add_ps(_mm_and_ps(_mm_load_ps(out.py + lane), keep), _mm_mul_ps(_mm_load_ps(a.py + lane), w)));
+        _mm_store_ps(out.pz + lane, _mm_add_ps(_mm_and_ps(_mm_load_ps(out.pz + lane), keep), _mm_mul_ps(_mm_load_ps(a.pz + lane), w)));
+    }
+}
+
+inline void TransformLanes::LerpPositions(const TransformLanes &a, const TransformLanes &b, float t, TransformLanes &out, size_t count)
+{
+    __m128 w = _mm_set1_ps(t);
+    for (size_t lane = 0; lane < Span(count); lane += 4)
+    {
+        _mm_store_ps(out.px + lane, RigidSimd::Lerp(_mm_load_ps(a.px + lane), _mm_load_ps(b.px + lane), w));
+        _mm_store_ps(out.py + lane, RigidSimd::Lerp(_mm_load_ps(a.py + lane), _mm_load_ps(b.py + lane), w));
+        _mm_store_ps(out.pz + lane, RigidSimd::Lerp(_mm_load_ps(a.pz + lane), _mm_load_ps(b.pz + lane), w));
+    }
+}
+
+inline void TransformLanes::NlerpRotations(const TransformLanes &a, const TransformLanes &b, float t, TransformLanes &out, size_t count)
+{
+    __m128 w = _mm_set1_ps(t);
+    for (size_t lane = 0; lane < Span(count); lane += 4)
+    {
+        __m128 ax = _mm_load_ps(a.qx + lane), ay = _mm_load_ps(a.qy + lane), az = _mm_load_ps(a.qz + lane), aw = _mm_load_ps(a.qw + lane);
+        __m128 bx = _mm_load_ps(b.qx + lane), by = _mm_load_ps(b.qy + lane), bz = _mm_load_ps(b.qz + lane), bw = _mm_load_ps(b.qw + lane);
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        __m128 sign = _mm_and_ps(dot, _mm_set1_ps(-0.f));
+        __m128 rx = RigidSimd::Lerp(ax, _mm_xor_ps(bx, sign), w);
+        __m128 ry = RigidSimd::Lerp(ay, _mm_xor_ps(by, sign), w);
+        __m128 rz = RigidSimd::Lerp(az, _mm_xor_ps(bz, sign), w);
+        __m128 rw = RigidSimd::Lerp(aw, _mm_xor_ps(bw, sign), w);
+        __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw))));
+        _mm_store_ps(out.qx + lane, _mm_div_ps(rx, len));
+        _mm_store_ps(out.qy + lane, _mm_div_ps(ry, len));
+        _mm_store_ps(out.qz + lane, _mm_div_ps(rz, len));
+        _mm_store_ps(out.qw + lane, _mm_div_ps(rw, len));
+    }
+}
+
+inline void TransformLanes::AlignRotations(const TransformLanes &ref, TransformLanes &inout, size_t count)
+{
+    for (size_t lane = 0; lane < Span(count); lane += 4)
+    {
+        __m128 bx = _mm_load_ps(inout.qx + lane), by = _mm_load_ps(inout.qy + lane), bz = _mm_load_ps(inout.qz + lane), bw = _mm_load_ps(inout.qw + lane);
+        __m128 dot = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_load_ps(ref.qx + lane), bx), _mm_mul_ps(_mm_load_ps(ref.qy + lane), by)),
+            _mm_add_ps(_mm_mul_ps(_mm_load_ps(ref.qz + lane), bz), _mm_mul_ps(_mm_load_ps(ref.qw + lane), bw))
+        );
+        __m128 sign = _mm_and_ps(dot, _mm_set1_ps(-0.f));
+        _mm_store_ps(inout.qx + lane, _mm_xor_ps(bx, sign));
+        _mm_store_ps(inout.qy + lane, _mm_xor_ps(by, sign));
+        _mm_store_ps(inout.qz + lane, _mm_xor_ps(bz, sign));
+        _mm_store_ps(inout.qw + lane, _mm_xor_ps(bw, sign));
+    }
+}
+
+#else
+
+inline void TransformLanes::ScalePositions(const TransformLanes &a, float weight, TransformLanes &out, size_t count, bool accumulate)
+{
+    for (size_t lane = 0; lane < Span(count); lane++)
+    {
+        out.px[lane] = (accumulate ? out.px[lane] : 0.f) + a.px[lane] * weight;
+        out.py[lane] = (accumulate ? out.py[lane] : 0.f) + a.py[lane] * weight;
+        out.pz[lane] = (accumulate ? out.pz[lane] : 0.f) + a.pz[lane] * weight;
+    }
+}
+
+inline void TransformLanes::LerpPositions(const TransformLanes &a, const TransformLanes &b, float t, TransformLanes &out, size_t count)
+{
+    for (size_t lane = 0; lane < Span(count); lane++)
+    {
+        out.px[lane] = a.px[lane] + (b.px[lane] - a.px[lane]) * t;
+        out.py[lane] = a.py[lane] + (b.py[lane] - a.py[lane]) * t;
+        out.pz[lane] = a.pz[lane] + (b.pz[lane] - a.pz[lane]) * t;
+    }
+}
+
+inline void TransformLanes::NlerpRotations(const TransformLanes &a, const TransformLanes &b, float t, TransformLanes &out, size_t count)
+{
+    for (size_t lane = 0; lane < Span(count); lane++)
+    {
+        float sign = (a.qx[lane] * b.qx[lane] + a.qy[lane] * b.qy[lane] + a.qz[lane] * b.qz[lane] + a.qw[lane] * b.qw[lane]) < 0.f ? -1.f : 1.f;
+        float rx = a.qx[lane] + (b.qx[lane] * sign - a.qx[lane]) * t;
+        float ry = a.qy[lane] + (b.qy[lane] * sign - a.qy[lane]) * t;
+        float rz = a.qz[lane] + (b.qz[lane] * sign - a.qz[lane]) * t;
+        float rw = a.qw[lane] + (b.qw[lane] * sign - a.qw[lane]) * t;
+        float len = std::sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+        out.qx[lane] = rx / len;
+        out.qy[lane] = ry / len;
+        out.qz[lane] = rz / len;
+        out.qw[lane] = rw / len;
+    }
+}
+
+inline void TransformLanes::AlignRotations(const TransformLanes &ref, TransformLanes &inout, size_t count)
+{
+    for (size_t lane = 0; lane < Span(count); lane++)
+    {
+        if (ref.qx[lane] * inout.qx[lane] + ref.qy[lane] * inout.qy[lane] + ref.qz[lane] * inout.qz[lane] + ref.qw[lane] * inout.qw[lane] < 0.f)
+        {
+            inout.qx[lane] = -inout.qx[lane];
+            inout.qy[lane] = -inout.qy[lane];
+            inout.qz[lane] = -inout.qz[lane];
+            inout.qw[lane] = -inout.qw[lane];
+        }
+    }
+}
+
+#endif
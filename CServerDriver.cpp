@@ -4,8 +4,12 @@
 #include "CDriverSettings.h"
 #include "CNvSDKInterface.h"
 #include "CVirtualBodyTracker.h"
+#include "CTrackerBank.h"
+#include "CPosePublisher.h"
 #include "CVirtualBaseStation.h"
 #include "CCameraDriver.h"
+#include "CSessionRecorder.h"
+#include "CStatsExport.h"
 #include "CCommon.h"
 
 #define ptrsafe(ptr) if((ptr) == nullptr) return
@@ -28,8 +32,15 @@ CServerDriver::CServerDriver()
     m_driverSettings = nullptr;
     m_nvInterface = nullptr;
     m_cameraDriver = nullptr;
+    m_recorder = nullptr;
+    m_statsExport = nullptr;
     m_station = nullptr;
+    m_trackerBank = nullptr;
+    m_poseSnapshots = nullptr;
+    m_publisher = nullptr;
     m_standby = false;
+    m_phaseCpu = ProcessCpuTime();
+    m_phaseStart = systime();
     m_trackingMode = TRACKING_FLAG::NONE;
     m_interpolation = INTERP_MODE::NONE;
     m_fpsCache = 30.f;
@@ -38,9 +49,21 @@ CServerDriver::CServerDriver()
     m_frame = 0u;
     m_scaleFactor = glm::vec3(1.f, 1.f, 1.f);
     m_activations = BINDING::NONE;
+    m_keySource = nullptr;
+    std::fill(m_keyDown, m_keyDown + KEY_CODE_COUNT, false);
+    std::fill(m_keyTapped, m_keyTapped + KEY_CODE_COUNT, false);
     m_camBryan = glm::vec3(.0f);
     m_camThread = nullptr;
+    m_exportThread = nullptr;
+    m_wasReady = false;
+    m_firstFrame = true;
+    m_lastClock = systime();
+    m_moveSpeed = .25f;
+    m_rotateSpeed = 45.f;
+    m_scaleSpeed = .125f;
     mirrored = false;
+    posePrediction = false;
+    latencyCompensation = false;
 }
 
 CServerDriver::~CServerDriver()
@@ -63,80 +86,104 @@ bool CServerDriver::BindingPressed(const BINDING &bind) const
     if (it == m_bindings.end())
         return false;
     else
-        return GetKeyDown(it->second) && !BindingActive(bind);
+        return (GetKeyDown(it->second) || GetKeyTapped(it->second)) && !BindingActive(bind);
+}
+void CServerDriver::PollKeys()
+{
+    if (m_keySource == nullptr)
+        return;
+    KeyEvent evnt;
+    while (m_keySource->Poll(evnt))
+    {
+        if (evnt.key < 0 || evnt.key >= KEY_CODE_COUNT)
+            continue;
+        m_keyDown[evnt.key] = evnt.down;
+        if (evnt.down)
+            m_keyTapped[evnt.key] = true;
+    }
 }
 void CServerDriver::UpdateBindings()
 {
     m_activations = BINDING::NONE;
     for (const auto &item : m_bindings)
     {
-        if (GetKeyDown(item.second))
+        if (GetKeyDown(item.second) || GetKeyTapped(item.second))
             m_activations = FLAG_OR(m_activations, item.first);
     }
+    std::fill(m_keyTapped, m_keyTapped + KEY_CODE_COUNT, false);
+}
+void CServerDriver::SetKeySource(CKeySource *source)
+{
+    delptr(m_keySource);
+    m_keySource = source;
+    std::fill(m_keyDown, m_keyDown + KEY_CODE_COUNT, false);
+    std::fill(m_keyTapped, m_keyTapped + KEY_CODE_COUNT, false);
+    if (m_keySource != nullptr && !m_keySource->Start())
+        vr_log("Hotkey source failed to start, bindings are unavailable");
 }
 
-bool CServerDriver::TrackerUpdate(CVirtualBodyTracker &tracker, const CNvSDKInterface &inter, const Proportions &props)
+bool CServerDriver::TrackerUpdate(const CVirtualBodyTracker &tracker, PoseSnapshot &snapshot, const CNvSDKInterface &inter, const Proportions &props)
 {
-    bool confidencePassed = false;
+    float confidence = 0.f;
     
     switch (tracker.role)
     {
     case TRACKER_ROLE::HIPS:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::PELVIS);
+        confidence = inter.GetConfidence(BODY_JOINT::PELVIS);
         break;
     case TRACKER_ROLE::LEFT_FOOT:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::LEFT_ANKLE);
+        confidence = inter.GetConfidence(BODY_JOINT::LEFT_ANKLE);
         break;
     case TRACKER_ROLE::RIGHT_FOOT:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::RIGHT_ANKLE);
+        confidence = inter.GetConfidence(BODY_JOINT::RIGHT_ANKLE);
         break;
     case TRACKER_ROLE::LEFT_ELBOW:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::LEFT_ELBOW);
+        confidence = inter.GetConfidence(BODY_JOINT::LEFT_ELBOW);
         break;
     case TRACKER_ROLE::RIGHT_ELBOW:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::RIGHT_ELBOW);
+        confidence = inter.GetConfidence(BODY_JOINT::RIGHT_ELBOW);
         break;
     case TRACKER_ROLE::LEFT_KNEE:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::LEFT_KNEE);
+        confidence = inter.GetConfidence(BODY_JOINT::LEFT_KNEE);
         break;
     case TRACKER_ROLE::RIGHT_KNEE:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::RIGHT_KNEE);
+        confidence = inter.GetConfidence(BODY_JOINT::RIGHT_KNEE);
         break;
     case TRACKER_ROLE::CHEST:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::TORSO);
+        confidence = inter.GetConfidence(BODY_JOINT::TORSO);
         break;
     case TRACKER_ROLE::LEFT_SHOULDER:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::LEFT_SHOULDER);
+        confidence = inter.GetConfidence(BODY_JOINT::LEFT_SHOULDER);
         break;
     case TRACKER_ROLE::RIGHT_SHOULDER:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::RIGHT_SHOULDER);
+        confidence = inter.GetConfidence(BODY_JOINT::RIGHT_SHOULDER);
         break;
     case TRACKER_ROLE::LEFT_TOE:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::LEFT_BIG_TOE, BODY_JOINT::LEFT_SMALL_TOE);
+        confidence = (inter.GetConfidence(BODY_JOINT::LEFT_BIG_TOE) + inter.GetConfidence(BODY_JOINT::LEFT_SMALL_TOE)) / 2.f;
         break;
     case TRACKER_ROLE::RIGHT_TOE:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::RIGHT_BIG_TOE, BODY_JOINT::RIGHT_SMALL_TOE);
+        confidence = (inter.GetConfidence(BODY_JOINT::RIGHT_BIG_TOE) + inter.GetConfidence(BODY_JOINT::RIGHT_SMALL_TOE)) / 2.f;
         break;
     case TRACKER_ROLE::HEAD:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::NOSE, BODY_JOINT::NECK);
+        confidence = (inter.GetConfidence(BODY_JOINT::NOSE) + inter.GetConfidence(BODY_JOINT::NECK)) / 2.f;
         break;
     case TRACKER_ROLE::LEFT_HAND:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::LEFT_WRIST);
+        confidence = inter.GetConfidence(BODY_JOINT::LEFT_WRIST);
         break;
     case TRACKER_ROLE::RIGHT_HAND:
-        confidencePassed = inter.GetConfidenceAcceptable(BODY_JOINT::RIGHT_WRIST);
+        confidence = inter.GetConfidence(BODY_JOINT::RIGHT_WRIST);
         break;
     }
+    snapshot.trackerConfidence[tracker.m_index] = confidence;
 
     //vr_log("Tracker %s confidence check?", TrackerRoleName[(int)tracker.role]);
 
-    if (!confidencePassed)
+    if (confidence < inter.confidenceRequirement)
         return false;
 
     //vr_log("Tracker %s passed confidence check", TrackerRoleName[(int)tracker.role]);
 
-    tracker.SetOffsetTransform(inter.GetCameraMatrix());
-    tracker.UpdateTransform(inter.GetTransformFromRole(tracker.role));
+    snapshot.targets.Set(tracker.m_index, inter.GetTransformFromRole(tracker.role));
 
     //vr_log("Tracker %s updated transform check", TrackerRoleName[(int)tracker.role]);
     //vr_log("transform info: %.3f %.3f %.3f", transform[3][0], transform[3][1], transform[3][2]);
@@ -146,32 +193,77 @@ bool CServerDriver::TrackerUpdate(CVirtualBodyTracker &tracker, const CNvSDKInte
 
 void CServerDriver::OnImageUpdate(const CCameraDriver &me, cv::Mat image)
 {
-    CServerDriver *driv = me.driver;
-    ptrsafe(driv);
-    CNvSDKInterface *track = driv->m_nvInterface;
+    ptrsafe(me.driver);
+    me.driver->DoImageUpdate(me);
+}
+
+void CServerDriver::OnImageRecord(const CCameraDriver &me, cv::Mat image)
+{
+    ptrsafe(me.driver);
+    ptrsafe(me.driver->m_recorder);
+    me.driver->m_recorder->PushFrame(image, me.GetFrameId(), me.GetFrameTime());
+}
+
+void CServerDriver::DoImageUpdate(const CCameraDriver &me, double now)
+{
+    CNvSDKInterface *track = m_nvInterface;
     ptrsafe(track);
+    ptrsafe(m_poseSnapshots);
+
+    //  Nobody in frame: most frames skip inference entirely, the trackers keep their last (disconnected) state
+    if (track->trackingActive && track->ready && !track->presence.ShouldRun(me.GetFrameTime()))
+        return;
+
+    //  Everything below goes into a private slot, the SteamVR thread only sees it once published
+    PoseSnapshot &snapshot = m_poseSnapshots->Edit();
+    snapshot.sampleTime = me.GetFrameTime();
+    snapshot.captureStart = me.GetCaptureStart();
+    snapshot.frameId = me.GetFrameId();
+    snapshot.active = track->trackingActive && track->ready;
     
-    if (track->trackingActive && track->ready)
+    if (snapshot.active)
     {
-        //vr_log("Updating the image from the camera (frame %d)\n", driv->m_frame);
+        //vr_log("Updating the image from the camera (frame %d)\n", m_frame);
         track->UpdateImageFromCam(me.GetImage());
-        //vr_log("Computing NVIDIA data (frame %d)\n", driv->m_frame);
+        //vr_log("Computing NVIDIA data (frame %d)\n", m_frame);
         track->RunFrame();
-        for (auto tracker : driv->m_trackers)
+
+        snapshot.offset = track->GetCameraTransform();
+        for (size_t index = 0; index < BODY_JOINT_COUNT; index++)
+        {
+            snapshot.keypoints[index] = track->GetPosition((BODY_JOINT)index);
+            snapshot.rotations[index] = track->GetRotation((BODY_JOINT)index);
+            snapshot.confidence[index] = track->GetConfidence((BODY_JOINT)index);
+        }
+        CTraceScope span(m_trace, "Tracker update", snapshot.frameId);
+        for (auto tracker : m_trackers)
         {
             //vr_log("Tracker %s is being updated", TrackerRoleName[(int)tracker->role]);
-            tracker->SetStandby(!TrackerUpdate(*tracker, *track, *driv->m_proportions));
-            //vr_log("CONNECTED? %s", tracker->IsConnected() ? "TRUE" : "FALSE");
+            snapshot.valid[tracker->m_index] = TrackerUpdate(*tracker, snapshot, *track, *m_proportions);
         }
     }
     else
     {
-        //vr_log("Trackers are not ready to be connected (frame %d)\n", driv->m_frame);
-        for (auto tracker : driv->m_trackers)
+        //vr_log("Trackers are not ready to be connected (frame %d)\n", m_frame);
+        snapshot.offset = track->GetCameraTransform();
+        for (size_t index = 0; index < BODY_JOINT_COUNT; index++)
+        {
+            snapshot.keypoints[index] = glm::vec3(0.f);
+            snapshot.rotations[index] = glm::quat(1.f, 0.f, 0.f, 0.f);
+            snapshot.confidence[index] = 0.f;
+        }
+        for (auto tracker : m_trackers)
         {
-            tracker->SetStandby(true);
+            snapshot.valid[tracker->m_index] = false;
+            snapshot.trackerConfidence[tracker->m_index] = 0.f;
         }
     }
+
+    if (snapshot.active)
+        m_latency.Record(LATENCY_STAGE::POSTPROCESS, LatencyNow() - track->GetPostStart());
+    //  Arrival is when the poses become visible to RunFrame, after inference and the tracker updates
+    snapshot.arrival = now < 0.0 ? systime() : now;
+    m_poseSnapshots->Publish();
 }
 
 void CServerDriver::OnCameraUpdate(const CCameraDriver &me, int index)
@@ -215,6 +307,26 @@ void CServerDriver::Startup()
 
     frameCacheSize = m_driverSettings->GetConfigInteger(SECTION_TRACKSET, KEY_FRAME_CACHE, 1);
     cacheImmediate = m_driverSettings->GetConfigBoolean(SECTION_TRACKSET, KEY_CACHE_IMMEDIATE, false);
+    posePrediction = m_driverSettings->GetConfigBoolean(SECTION_TRACKSET, KEY_POSE_PREDICTION, false);
+    vr_log("Pose prediction: %s", posePrediction ? "velocity (camera rate)" : "interpolated (display rate)");
+    latencyCompensation = m_driverSettings->GetConfigBoolean(SECTION_TRACKSET, KEY_LATENCY_COMPENSATION, false);
+    //  Prediction submits raw camera samples, so the bank skips interpolation entirely
+    m_trackerBank = new CTrackerBank(frameCacheSize, posePrediction ? INTERP_MODE::NONE : m_interpolation, cacheImmediate);
+    m_poseSnapshots = new CSnapshotBuffer<PoseSnapshot>();
+
+    float keepAliveRate = m_driverSettings->GetConfigFloat(SECTION_TRACKSET, KEY_KEEP_ALIVE, 1.f);
+    m_submitPolicy.positionEpsilon = m_driverSettings->GetConfigFloat(SECTION_TRACKSET, KEY_SUBMIT_DIST, 0.0005f);
+    m_submitPolicy.rotationEpsilon = glm::radians(m_driverSettings->GetConfigFloat(SECTION_TRACKSET, KEY_SUBMIT_ANGLE, 0.05f));
+    m_submitPolicy.keepAlive = keepAliveRate > 0.f ? 1.0 / keepAliveRate : 0.0;
+
+    //  The camera keeps the core it was always pinned to unless configured otherwise
+    m_threadPlacement[(size_t)THREAD_ROLE::CAMERA] = m_driverSettings->GetConfigThreadPlacement(SECTION_THREADS, THREAD_ROLE::CAMERA, { 0b10u, THREAD_PRIORITY::NORMAL, false });
+    m_threadPlacement[(size_t)THREAD_ROLE::PUBLISHER] = m_driverSettings->GetConfigThreadPlacement(SECTION_THREADS, THREAD_ROLE::PUBLISHER, { 0u, THREAD_PRIORITY::HIGHEST, false });
+    m_threadPlacement[(size_t)THREAD_ROLE::INPUT] = m_driverSettings->GetConfigThreadPlacement(SECTION_THREADS, THREAD_ROLE::INPUT, { 0u, THREAD_PRIORITY::ABOVE_NORMAL, false });
+
+    //  The ring has to exist before the first pipeline thread records into it
+    if (m_driverSettings->GetConfigBoolean(SECTION_TRACE, KEY_TRACE_ON, false))
+        m_trace.Enable((size_t)(std::max)(m_driverSettings->GetConfigInteger(SECTION_TRACE, KEY_TRACE_CAPACITY, (int)TRACE_DEFAULT_CAPACITY), 1));
 
     vr_log("Body proportions:");
 
@@ -237,6 +349,10 @@ void CServerDriver::Startup()
         m_nvInterface->nvARMode = m_driverSettings->GetConfigInteger(SECTION_SDKSET, KEY_NVAR, 1);
         m_nvInterface->confidenceRequirement = m_driverSettings->GetConfigFloat(SECTION_SDKSET, KEY_CONF, 0.0);
         m_nvInterface->trackingActive = m_driverSettings->GetConfigBoolean(SECTION_SDKSET, KEY_TRACKING, true);
+        m_nvInterface->presence.Configure(
+            m_driverSettings->GetConfigFloat(SECTION_SDKSET, KEY_PROBE_RATE, 2.f),
+            (unsigned)m_driverSettings->GetConfigInteger(SECTION_SDKSET, KEY_PROBE_AFTER, 30)
+        );
         m_camBryan = m_driverSettings->GetConfigVector(SECTION_ROT);
         m_nvInterface->SetCamera(
             m_driverSettings->GetConfigVector(SECTION_POS),
@@ -246,6 +362,25 @@ void CServerDriver::Startup()
         );
         m_nvInterface->Initialize();
         m_nvInterface->KeyInfoUpdated(true);
+        bool recordKeypoints = m_driverSettings->GetConfigBoolean(SECTION_RECORD, KEY_RECORD_KEYPOINTS, false);
+        bool recordVideo = m_driverSettings->GetConfigBoolean(SECTION_RECORD, KEY_RECORD_VIDEO, false);
+        if (recordKeypoints || recordVideo)
+        {
+            //  One name for every file of the session, the recorder adds the extensions
+            std::string path = GetSessionPath("session-%Y%m%d-%H%M%S");
+            m_recorder = new CSessionRecorder();
+            if (recordKeypoints)
+                m_recorder->OpenKeypoints(path, (uint32_t)(m_nvInterface->realBatches * m_nvInterface->batchSize), m_nvInterface->focalLength,
+                    m_driverSettings->GetConfigBoolean(SECTION_RECORD, KEY_RECORD_ENCODED, false));
+            if (recordVideo)
+                m_recorder->OpenVideo(path, m_driverSettings->GetConfigFloat(SECTION_RECORD, KEY_RECORD_VIDEO_FPS, 30.f));
+            //  Spawned before the camera thread, so it is joined after it and writes out everything the camera queued
+            m_threads.Spawn(
+                "Recorder",
+                [this](const CStopToken &token) { m_recorder->Run(token); },
+                [this]() { m_recorder->Wake(); }
+            );
+        }
     }
     catch (std::exception e)
     {
@@ -259,15 +394,17 @@ void CServerDriver::Startup()
     {
         m_cameraDriver = new CCameraDriver(this, m_driverSettings->GetConfigFloat(SECTION_CAMSET, KEY_RES_SCALE, 1.f));
         m_cameraDriver->show = m_driverSettings->GetConfigBoolean(SECTION_CAMSET, KEY_CAM_VIS, true);
+        m_cameraDriver->releaseInStandby = m_driverSettings->GetConfigBoolean(SECTION_CAMSET, KEY_CAM_RELEASE, false);
         m_cameraDriver->m_cameraIndex = m_driverSettings->GetConfigInteger(SECTION_CAMSET, KEY_CAM_INDEX, 0);
         m_cameraDriver->LoadCameras();
         vr_log("\tBinding events");
+        //  The frame is queued for the recorder before inference runs on it
+        if (m_recorder != nullptr && m_recorder->IsRecordingVideo())
+            m_cameraDriver->imageChanged += CFunctionFactory(OnImageRecord, void, const CCameraDriver &, cv::Mat);
         m_cameraDriver->imageChanged += CFunctionFactory(OnImageUpdate, void, const CCameraDriver &, cv::Mat);
         m_cameraDriver->cameraChanged += CFunctionFactory(OnCameraUpdate, void, const CCameraDriver &, int);
         vr_log("\tLaunching camera thread");
-        m_camThread = new std::thread(&CCameraDriver::RunAsync, m_cameraDriver);
-        SetThreadAffinityMask(m_camThread->native_handle(), 0b10u);
-        m_camThread->detach();
+        m_camThread = m_threads.Spawn("Camera", [this](const CStopToken &token) { m_cameraDriver->RunAsync(token); });
         vr_log("\tCamera thread launched asynchronously");
     }
     catch (std::exception e)
@@ -278,6 +415,7 @@ void CServerDriver::Startup()
     vr_log("OpenCV modules loaded successfully\n");
 
     m_station = new CVirtualBaseStation(this);
+    m_station->SetSubmitPolicy(m_submitPolicy);
     vr::VRServerDriverHost()->TrackedDeviceAdded(m_station->GetSerial().c_str(), vr::ETrackedDeviceClass::TrackedDeviceClass_TrackingReference, m_station);
 
     vr_log("Tracking enabled: %s\n", m_nvInterface->trackingActive ? "true" : "false");
@@ -295,9 +433,21 @@ void CServerDriver::Startup()
 
     vr_log("Trackers initialized");
 
-    vr_log("Binding inputs...");
+    m_statsExport = new CStatsExport();
+    if (!m_statsExport->Open())
+        delptr(m_statsExport);
+    m_publisher = new CPosePublisher(this);
+    m_publisher->Start(m_threads);
 
+    vr_log("Binding inputs...");
+    CKeySource *keys = CKeySource::Create();
+    keys->SetPlacement(GetThreadPlacement(THREAD_ROLE::INPUT));
+    SetKeySource(keys);
+    BindInputs();
+}
 
+void CServerDriver::BindInputs()
+{
     MapBinding(BINDING::SHIFT, VK_SHIFT);
 
     vr_log("\tWASD: Move the base station");
@@ -349,6 +499,9 @@ void CServerDriver::Startup()
 
     vr_log("\tCtrl + S: Attempt to save the configuration file");
     MapBinding(BINDING::SAVE_KEY, 'S');
+
+    vr_log("\tCtrl + P: Write the pipeline trace next to settings.ini (when tracing is enabled)");
+    MapBinding(BINDING::EXPORT_TRACE, 'P');
     MapBinding(BINDING::CTRL, VK_CONTROL);
 
     vr_log("All inputs bound successfully");
@@ -357,12 +510,87 @@ void CServerDriver::Startup()
 vr::EVRInitError CServerDriver::Init(vr::IVRDriverContext *pDriverContext)
 {
     VR_INIT_SERVER_DRIVER_CONTEXT(pDriverContext);
+    g_logger.Start();
 
     Startup();
 
     return vr::VRInitError_None;
 }
 
+std::string CServerDriver::GetSessionPath(const char *pattern) const
+{
+    std::string path = m_driverSettings->m_filePath;
+    path.erase(path.rfind('\\') + 1);
+    char name[64];
+    time_t now = time(nullptr);
+    tm local;
+    localtime_s(&local, &now);
+    strftime(name, sizeof(name), pattern, &local);
+    path.append(name);
+    return path;
+}
+
+void CServerDriver::ExportTrace(bool wait)
+{
+    if (!m_trace.IsEnabled())
+    {
+        vr_log("Tracing is disabled, enable it in the [%s] section of settings.ini", SECTION_TRACE);
+        return;
+    }
+    if (!m_trace.BeginExport())
+    {
+        vr_log("A trace is still being written");
+        return;
+    }
+
+    std::string path = GetSessionPath("trace-%Y%m%d-%H%M%S.json");
+
+    if (wait)
+    {
+        m_trace.Export(path.c_str());
+        m_trace.EndExport();
+        return;
+    }
+    //  Writing tens of thousands of spans takes far longer than a frame, so RunFrame only hands it to the export thread
+    if (m_exportThread == nullptr)
+    {
+        m_exportThread = m_threads.Spawn(
+            "Trace export",
+            [this](const CStopToken &token) { RunTraceExport(token); },
+            [this]() {
+                std::lock_guard<std::mutex> lock(m_exportMutex);
+                m_exportWake.notify_all();
+            }
+        );
+    }
+    std::lock_guard<std::mutex> lock(m_exportMutex);
+    m_exportPath = path;
+    m_exportWake.notify_all();
+}
+
+void CServerDriver::RunTraceExport(const CStopToken &token)
+{
+    std::unique_lock<std::mutex> lock(m_exportMutex);
+    while (true)
+    {
+        m_exportWake.wait(lock, [this, &token]() { return token.StopRequested() || !m_exportPath.empty(); });
+        std::string path;
+        path.swap(m_exportPath);
+        if (token.StopRequested())
+        {
+            //  A request that was never started is dropped, Cleanup writes the final trace itself
+            if (!path.empty())
+                m_trace.EndExport();
+            return;
+        }
+
+        lock.unlock();
+        m_trace.Export(path.c_str(), &token);
+        m_trace.EndExport();
+        lock.lock();
+    }
+}
+
 bool CServerDriver::TrySaveConfig() const
 {
     vr_log("Config save called");
@@ -389,7 +617,34 @@ void CServerDriver::Cleanup()
 {
     vr_log("Initiating full device cleanup...\n");
 
-    TrySaveConfig();
+    //  Not there when the driver was never started (or was set up by the benchmark)
+    if (m_driverSettings != nullptr)
+        TrySaveConfig();
+
+    //  Every pipeline thread has to be gone before anything it touches is freed
+    bool stopped = m_threads.StopAll();
+    m_camThread = nullptr;
+    m_exportThread = nullptr;
+    delptr(m_keySource);
+    if (!stopped)
+    {
+        //  A detached thread may still be inside the camera, SDK or publisher, so they are leaked instead
+        vr_log("Pipeline threads did not stop in time, skipping device cleanup\n");
+        g_logger.Stop();
+        vr::CleanupDriverContext();
+        return;
+    }
+
+    //  Every thread that records is gone, so the trace is complete up to the shutdown (it goes next to settings.ini)
+    if (m_trace.IsEnabled() && m_driverSettings != nullptr)
+        ExportTrace(true);
+
+    //  The recorder thread is gone too, whatever it had not written yet is written now
+    delptr(m_recorder);
+
+    //  Nothing may submit poses while the devices are torn down
+    delptr(m_publisher);
+    delptr(m_statsExport);
 
     m_trackers.clear();
     
@@ -397,22 +652,17 @@ void CServerDriver::Cleanup()
 
     delptr(m_station);
 
-    m_cameraDriver->m_working = false;
-
-    m_cameraDriver->Cleanup();
-
     delptr(m_nvInterface);
     delptr(m_proportions);
-
-    m_cameraDriver->m_working = false;
-
-    //m_camThread->join();
+    delptr(m_trackerBank);
+    delptr(m_poseSnapshots);
 
     delptr(m_cameraDriver);
-    delptr(m_camThread);
 
-    vr_log("Full device cleanup was successful\n");
+    vr_log("Full device cleanup was successful (threads stopped in %.1f ms)\n", m_threads.GetShutdownLatency() * 1000.0);
 
+    //  Everything still queued is written while the driver context is alive
+    g_logger.Stop();
     vr::CleanupDriverContext();
 }
 
@@ -428,23 +678,24 @@ void CServerDriver::Deactivate()
 
 void CServerDriver::RunFrame()
 {
-    static bool was_ready = false;
-    static double last_clock = systime();
-    double cur_clock = systime();
-    double clock_diff = cur_clock - last_clock;
-    static float move_speed = .25f, rotate_speed = 45.f, scale_speed = .125f;
+    DoRunFrame(systime());
+}
+
+void CServerDriver::DoRunFrame(double cur_clock)
+{
+    double clock_diff = cur_clock - m_lastClock;
     float move_amnt, rotate_amnt, scale_amnt;
-    static bool camup = false, camdn = false;
-    static bool first_time = true;
     vr::VREvent_t ev;
+    //  m_frame is only counted further down, once the device poses are published
+    CTraceScope span(m_trace, "RunFrame", (uint64_t)m_frame + 1u);
 
     ptrsafe(m_camThread);
 
-    if (first_time)
+    if (m_firstFrame)
     {
+        TraceThreadName("SteamVR");
         vr_log("HMD Alignment %s", m_nvInterface->m_alignHMD ? "enabled" : "disabled");
         vr_log("Camera %s mirrored", mirrored ? "is" : "is not");
-        SetThreadAffinityMask(m_camThread->native_handle(), 0b10u);
     }
     
 
@@ -452,6 +703,10 @@ void CServerDriver::RunFrame()
     //  hmd 0
     //  lc  1
     //  rc  2
+    DevicePoses &devices = m_devicePoses.Edit();
+    std::copy(m_hmd_controller_pose, m_hmd_controller_pose + 3, devices.poses);
+    devices.time = cur_clock;
+    m_devicePoses.Publish();
 
     m_frame++;
 
@@ -459,30 +714,34 @@ void CServerDriver::RunFrame()
     ptrsafe(m_cameraDriver);
     ptrsafe(m_station);
     ptrsafe(m_driverSettings);
+    ptrsafe(m_publisher);
 
     //ptrsafe(m_camThread);
 
-    LoadRefreshRate();
     m_refreshRateCache = (float)(1./clock_diff);
-    last_clock = cur_clock;
+    m_publisher->ReportFrame(cur_clock);
+    m_lastClock = cur_clock;
     LoadFPS();
 
-    move_amnt = (float)(move_speed * clock_diff);
-    rotate_amnt = (float)(rotate_speed * clock_diff);
-    scale_amnt = (float)(scale_speed * clock_diff);
+    move_amnt = (float)(m_moveSpeed * clock_diff);
+    rotate_amnt = (float)(m_rotateSpeed * clock_diff);
+    scale_amnt = (float)(m_scaleSpeed * clock_diff);
 
     while (vr::VRServerDriverHost()->PollNextEvent(&ev, sizeof(vr::VREvent_t)))
        ProcessEvent(ev);
 
+    PollKeys();
     if (BindingActive(BINDING::CTRL))
     {
         if (BindingPressed(BINDING::SAVE_KEY))
         {
             vr_log("Save key pressed");
-            vr_log(m_driverSettings->m_filePath.substr(0, 10000).c_str());
+            vr_log("%s", m_driverSettings->m_filePath.c_str());
             //vr_log(m_driverSettings->m_filePath.c_str());
             TrySaveConfig();
         }
+        if (BindingPressed(BINDING::EXPORT_TRACE))
+            ExportTrace();
     }
     else if (BindingActive(BINDING::SHIFT))
     {
@@ -579,38 +838,64 @@ void CServerDriver::RunFrame()
     //vr_log("Found FPS and Refresh Rates: %.2f %.2f", GetFPS(), GetRefreshRate());
 
     //vr_log("Fully rendered the camera");
-    if (was_ready != m_nvInterface->ready)
-    {
-        was_ready = m_nvInterface->ready;
-        vr_log("NVIDIA AR SDK is %s\n", was_ready ? "ready and accepting image data" : "currently inactive / disabled");
-    }
-    if (m_nvInterface->ready)
+    if (m_wasReady != m_nvInterface->ready)
     {
-        for (auto l_tracker : m_trackers)
-        {
-            l_tracker->RunFrame();
-        }
+        m_wasReady = m_nvInterface->ready;
+        vr_log("NVIDIA AR SDK is %s\n", m_wasReady ? "ready and accepting image data" : "currently inactive / disabled");
     }
-    else if (m_frame % 30u == 0u)
-        m_cameraDriver->ChangeCamera(0);
-
-    m_station->SetStandby(!m_nvInterface->trackingActive);
-    m_station->SetTransform(m_nvInterface->GetCameraMatrix() * glm::mat4_cast(DoEulerYXZ(0.f, M_PI, 0.f)));
-    m_station->RunFrame();
+    //  Poses are submitted by m_publisher on its own thread
 
     //LeaveStandby(); 
 
-    first_time = false;
+    m_firstFrame = false;
+}
+
+double CServerDriver::ProcessCpuTime()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    //  100 ns units
+    return (double)(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
 }
 
 void CServerDriver::EnterStandby()
 {
-    m_standby = true;
+    if (m_standby.exchange(true))
+        return;
+
+    //  Capture and inference run on the camera thread, so parking it idles the camera, decoder and GPU alike
+    //  The SDK keeps its models loaded, which is what makes waking up quick
+    if (m_cameraDriver != nullptr)
+        m_cameraDriver->SetParked(true);
+
+    double cpu = ProcessCpuTime(), now = systime();
+    vr_log("Entering standby, process used %.1f%% of a core while active", 100.0 * (cpu - m_phaseCpu) / (std::max)(now - m_phaseStart, 1e-3));
+    m_phaseCpu = cpu;
+    m_phaseStart = now;
 }
 
 void CServerDriver::LeaveStandby()
 {
-    m_standby = false;
+    if (!m_standby.exchange(false))
+        return;
+
+    if (m_cameraDriver != nullptr)
+        m_cameraDriver->SetParked(false);
+
+    double cpu = ProcessCpuTime(), now = systime();
+    vr_log("Leaving standby after %.1f s, process used %.1f%% of a core while idle", now - m_phaseStart, 100.0 * (cpu - m_phaseCpu) / (std::max)(now - m_phaseStart, 1e-3));
+    m_phaseCpu = cpu;
+    m_phaseStart = now;
 }
 
 bool CServerDriver::ShouldBlockStandbyMode()
@@ -631,7 +916,8 @@ void CServerDriver::SetupTracker(const char *name, TRACKING_FLAG flag, TRACKER_R
     
     if(enabled)
     {
-        tracker = new CVirtualBodyTracker(m_trackers.size(), role, frameCacheSize, cacheImmediate);
+        tracker = new CVirtualBodyTracker(m_trackerBank->AddTracker(), role);
+        tracker->SetSubmitPolicy(m_submitPolicy);
         m_trackers.push_back(tracker);
         vr::VRServerDriverHost()->TrackedDeviceAdded(tracker->GetSerial().c_str(), vr::ETrackedDeviceClass::TrackedDeviceClass_GenericTracker, tracker);
         tracker->driver = this;
@@ -645,12 +931,14 @@ void CServerDriver::SetupTracker(const char *name, TRACKING_FLAG flag, TRACKER_R
     //vr_log("\tTracking for %s %s\n", name, enabled ? "enabled" : "disabled");
     if(enabled)
     {
-        tracker = new CVirtualBodyTracker(m_trackers.size(), role, frameCacheSize, cacheImmediate);
+        tracker = new CVirtualBodyTracker(m_trackerBank->AddTracker(), role);
+        tracker->SetSubmitPolicy(m_submitPolicy);
         m_trackers.push_back(tracker);
         vr::VRServerDriverHost()->TrackedDeviceAdded(tracker->GetSerial().c_str(), vr::ETrackedDeviceClass::TrackedDeviceClass_GenericTracker, tracker);
         tracker->driver = this;
 
-        tracker = new CVirtualBodyTracker(m_trackers.size(), secondary, frameCacheSize, cacheImmediate);
+        tracker = new CVirtualBodyTracker(m_trackerBank->AddTracker(), secondary);
+        tracker->SetSubmitPolicy(m_submitPolicy);
         m_trackers.push_back(tracker);
         vr::VRServerDriverHost()->TrackedDeviceAdded(tracker->GetSerial().c_str(), vr::ETrackedDeviceClass::TrackedDeviceClass_GenericTracker, tracker);
         tracker->driver = this;
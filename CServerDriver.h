@@ -1,14 +1,34 @@
 #pragma once
+#include "CSnapshotBuffer.h"
+#include "CVirtualDevice.h"
+#include "CKeySource.h"
+#include "CThreadTopology.h"
+#include "CManagedThread.h"
+#include "CLatencyHistogram.h"
+#include "CTraceRecorder.h"
 
 class CDriverSettings;
 class CNvSDKInterface;
 class CVirtualBodyTracker;
 class CVirtualBaseStation;
+class CTrackerBank;
+class CPosePublisher;
 class CCameraDriver;
+class CSessionRecorder;
+class CStatsExport;
 enum class TRACKING_FLAG;
 enum class TRACKER_ROLE;
 enum class INTERP_MODE;
 struct Proportions;
+struct PoseSnapshot;
+
+//  Raw HMD (0) and controller (1, 2) poses, handed from the SteamVR thread to the camera thread for alignment
+struct DevicePoses
+{
+    vr::TrackedDevicePose_t poses[3];
+    //  When RunFrame fetched them (systime)
+    double time;
+};
 
 
 enum class BINDING : uint
@@ -44,7 +64,9 @@ enum class BINDING : uint
     SAVE_KEY = 0b10000000000000000000000,
 
     SHIFT = 0b100000000000000000000000,
-    CTRL = 0b1000000000000000000000000
+    CTRL = 0b1000000000000000000000000,
+
+    EXPORT_TRACE = 0b10000000000000000000000000
 };
 
 //  The main class responsible for managing data that is transferred between different classes
@@ -52,12 +74,31 @@ class CServerDriver final : public vr::IServerTrackedDeviceProvider
 {
     static void OnImageUpdate(const CCameraDriver &me, cv::Mat image);
     static void OnCameraUpdate(const CCameraDriver &me, int index);
+    static void OnImageRecord(const CCameraDriver &me, cv::Mat image);
 
     static const char *const ms_interfaces[];
 
     TRACKING_FLAG m_trackingMode;
-    bool m_standby;
-    std::thread *m_camThread;
+    //  SteamVR is in standby, the camera and publisher threads are parked
+    std::atomic<bool> m_standby;
+    //  Process CPU time and wall time when standby was last entered or left, to report the usage of each phase
+    double m_phaseCpu;
+    double m_phaseStart;
+
+    static double ProcessCpuTime();
+    //  Owns the camera and publisher threads, stopped first in Cleanup
+    CThreadSupervisor m_threads;
+    //  Owned by m_threads
+    CManagedThread *m_camThread;
+
+    //  Per frame state of RunFrame
+    bool m_wasReady;
+    bool m_firstFrame;
+    double m_lastClock;
+    //  Speed of the camera adjustment bindings, per second
+    float m_moveSpeed;
+    float m_rotateSpeed;
+    float m_scaleSpeed;
 
     // vr::IServerTrackedDeviceProvider
     vr::EVRInitError Init(vr::IVRDriverContext *pDriverContext) override;
@@ -71,21 +112,31 @@ class CServerDriver final : public vr::IServerTrackedDeviceProvider
     CServerDriver(const CServerDriver &that) = delete;
     CServerDriver &operator=(const CServerDriver &that) = delete;
 
-    static bool TrackerUpdate(CVirtualBodyTracker &tracker, const CNvSDKInterface &inter, const Proportions &props);
+    static bool TrackerUpdate(const CVirtualBodyTracker &tracker, PoseSnapshot &snapshot, const CNvSDKInterface &inter, const Proportions &props);
     void SetupTracker(const char *name, TRACKING_FLAG flag, TRACKER_ROLE role);
     void SetupTracker(const char *name, TRACKING_FLAG flag, TRACKER_ROLE role, TRACKER_ROLE secondary);
 
     inline void LoadRefreshRate() { m_refreshRateCache = vr::VRSettings()->GetFloat("driver_nvidiaBodyTracking", "displayFrequency"); }
 
     void ProcessEvent(const vr::VREvent_t &evnt);
-    static inline const bool GetKeyDown(const int &key) { return GetAsyncKeyState(key) < 0; }
+    inline bool GetKeyDown(const int &key) const { return key >= 0 && key < KEY_CODE_COUNT && m_keyDown[key]; }
+    inline bool GetKeyTapped(const int &key) const { return key >= 0 && key < KEY_CODE_COUNT && m_keyTapped[key]; }
     void MapBinding(const BINDING &binding, const int &key);
     bool BindingActive(const BINDING &bind) const;
     bool BindingPressed(const BINDING &bind) const;
     void Startup();
+    //  Map every hotkey binding to its key
+    void BindInputs();
+    //  Drain the key events queued since the last frame
+    void PollKeys();
     void UpdateBindings();
     BINDING m_activations;
     std::map<BINDING, int> m_bindings;
+    //  Hotkey events, pushed from the source's own thread
+    CKeySource *m_keySource;
+    //  Keys held, and keys pressed at any point since the last UpdateBindings (catches taps shorter than a frame)
+    bool m_keyDown[KEY_CODE_COUNT];
+    bool m_keyTapped[KEY_CODE_COUNT];
     
     static inline const glm::quat DoEulerYXZ(const float &x = 0.f, const float &y = 0.f, const float &z = 0.f) {
         return glm::quat(glm::vec3(0.f, y, 0.f)) * glm::quat(glm::vec3(x, 0.f, z));
@@ -98,17 +149,48 @@ class CServerDriver final : public vr::IServerTrackedDeviceProvider
     void DoRotateCam(T &axis, const float &amount = 0.f);
 
     bool TrySaveConfig() const;
+    //  A file next to settings.ini, named by formatting the pattern with strftime on the current local time
+    std::string GetSessionPath(const char *pattern) const;
+    //  Write the trace ring next to settings.ini, from the export thread unless asked to wait
+    void ExportTrace(bool wait = false);
+    //  Body of the export thread, writes each requested trace until a stop is requested
+    void RunTraceExport(const CStopToken &token);
     
     void LoadFPS();
 protected:
     CDriverSettings *m_driverSettings;
     CNvSDKInterface *m_nvInterface;
     std::vector<CVirtualBodyTracker *> m_trackers;
+    CTrackerBank *m_trackerBank;
+    //  Published once per inference by the camera thread, ingested by RunFrame
+    CSnapshotBuffer<PoseSnapshot> *m_poseSnapshots;
+    //  Published every frame by RunFrame, read by the camera thread
+    CSnapshotBuffer<DevicePoses> m_devicePoses;
+    //  Submits the poses on its own thread, paced to the display
+    CPosePublisher *m_publisher;
     CVirtualBaseStation *m_station;
     CCameraDriver *m_cameraDriver;
+    //  Camera frames and keypoints of the session, only there when recording is enabled in settings.ini
+    CSessionRecorder *m_recorder;
+    //  Pipeline stats for the dashboard overlay, written by the publisher thread
+    CStatsExport *m_statsExport;
     Proportions *m_proportions;
 
     INTERP_MODE m_interpolation;
+    //  When the trackers and base station hand their poses to vrserver
+    SubmitPolicy m_submitPolicy;
+    //  Applied by each thread to itself when it starts
+    ThreadPlacement m_threadPlacement[(size_t)THREAD_ROLE::COUNT];
+    //  Per stage latency of the capture to publish pipeline, recorded from every thread
+    CLatencyStats m_latency;
+    //  Pipeline spans of every thread, only recorded when tracing is enabled in settings.ini
+    CTraceRecorder m_trace;
+    //  Owned by m_threads, spawned by the first export request and kept waiting for the next one
+    CManagedThread *m_exportThread;
+    std::mutex m_exportMutex;
+    std::condition_variable m_exportWake;
+    //  Where the requested export goes, empty while none is waiting
+    std::string m_exportPath;
 
     float m_refreshRateCache;
     float m_fpsCache;
@@ -119,6 +201,9 @@ protected:
     int camIndex;
     int frameCacheSize;
     bool cacheImmediate;
+    bool posePrediction;
+    //  Pose time offsets include the motion latency estimate
+    bool latencyCompensation;
 
     vr::TrackedDevicePose_t m_hmd_controller_pose[3]{};
 
@@ -126,10 +211,25 @@ protected:
     friend class CVirtualBodyTracker;
     friend class CNvSDKInterface;
     friend class CCameraDriver;
+    friend class CPosePublisher;
+    friend class CStatsExport;
+    //  The benchmarks and tests, see Benchmark/CDriverTestAccess.h
+    friend class CDriverTestAccess;
 public:
     void Deactivate();
+    //  Process a single frame as if it ran at the given time (RunFrame uses the current time)
+    void DoRunFrame(double now);
+    //  Process a camera frame, its poses are stamped with the time they are published (systime)
+    //  unless a time of the simulated clock is given, as the benchmark does
+    void DoImageUpdate(const CCameraDriver &me, double now = -1.0);
+    //  Replace the hotkey source (the driver takes ownership), e.g. with a CScriptedKeySource
+    void SetKeySource(CKeySource *source);
     inline float GetFPS() const { return m_fpsCache; }
     inline float GetRefreshRate() const { return m_refreshRateCache; }
+    inline const ThreadPlacement &GetThreadPlacement(THREAD_ROLE role) const { return m_threadPlacement[(size_t)role]; }
+    inline CLatencyStats &GetLatency() { return m_latency; }
+    inline CTraceRecorder &GetTrace() { return m_trace; }
+    inline bool IsStandby() const { return m_standby.load(std::memory_order_relaxed); }
 
     CServerDriver();
     ~CServerDriver();
@@ -0,0 +1,227 @@
+#include "pch.h"
+#include "CSessionRecorder.h"
+#include "CManagedThread.h"
+
+CSessionRecorder::CSessionRecorder() : m_frameHead(0u), m_frameTail(0u), m_recordHead(0u), m_recordTail(0u),
+    m_recordKeypoints(false), m_recordVideo(false), m_framesWritten(0u), m_framesDropped(0u), m_recordsDropped(0u), m_sleeping(false)
+{
+    m_signalled = false;
+    m_videoIndex = nullptr;
+    m_videoFps = 30.0;
+    m_segment = 0u;
+    m_segmentFrames = 0u;
+}
+
+CSessionRecorder::~CSessionRecorder()
+{
+    Close();
+}
+
+bool CSessionRecorder::OpenKeypoints(const std::string &path, uint32_t batches, float focalLength, bool encoded)
+{
+    std::string file = path + ".bin";
+    if (!m_keypoints.Open(file.c_str(), batches, focalLength, encoded))
+    {
+        vr_log("Unable to create the keypoint trace %s", file.c_str());
+        return false;
+    }
+    //  Every slot is sized up front, pushing a record never allocates
+    size_t count = (size_t)m_keypoints.GetBatches() * BODY_JOINT_COUNT;
+    for (RecordSlot &slot : m_records)
+    {
+        slot.keypoints.resize(count);
+        slot.keypoints3D.resize(count);
+        slot.jointAngles.resize(count);
+        slot.confidence.resize(count);
+    }
+    m_recordKeypoints = true;
+    vr_log("Recording keypoints to %s", file.c_str());
+    return true;
+}
+
+bool CSessionRecorder::OpenVideo(const std::string &path, double fps)
+{
+    std::string file = path + ".csv";
+    if (fopen_s(&m_videoIndex, file.c_str(), "w") != 0 || m_videoIndex == nullptr)
+    {
+        m_videoIndex = nullptr;
+        vr_log("Unable to create the video index %s", file.c_str());
+        return false;
+    }
+    fprintf(m_videoIndex, "segment,index,frame,time\n");
+    m_videoPath = path;
+    m_videoFps = fps > 0.0 ? fps : 30.0;
+    //  The video itself is opened by the first frame, only then is its size known
+    m_recordVideo = true;
+    vr_log("Recording camera frames to %s", path.c_str());
+    return true;
+}
+
+void CSessionRecorder::PushFrame(const cv::Mat &image, uint64_t frameId, double time)
+{
+    if (!m_recordVideo.load(std::memory_order_relaxed) || image.empty())
+        return;
+    uint64_t head = m_frameHead.load(std::memory_order_relaxed);
+    if (head - m_frameTail.load(std::memory_order_acquire) >= SESSION_FRAME_QUEUE)
+    {
+        m_framesDropped.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+    //  The camera reads its next frame into the same buffer, so the image is copied; a slot only allocates for a new size
+    FrameSlot &slot = m_frames[head % SESSION_FRAME_QUEUE];
+    image.copyTo(slot.image);
+    slot.frameId = frameId;
+    slot.time = time;
+    m_frameHead.store(head + 1u, std::memory_order_release);
+    Notify();
+}
+
+void CSessionRecorder::PushKeypoints(const KeypointTraceFrame &frame, const NvAR_Point2f *keypoints, const NvAR_Point3f *keypoints3D,
+    const NvAR_Quaternion *jointAngles, const float *confidence)
+{
+    if (!m_recordKeypoints.load(std::memory_order_relaxed))
+        return;
+    uint64_t head = m_recordHead.load(std::memory_order_relaxed);
+    if (head - m_recordTail.load(std::memory_order_acquire) >= SESSION_RECORD_QUEUE)
+    {
+        m_recordsDropped.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+    RecordSlot &slot = m_records[head % SESSION_RECORD_QUEUE];
+    size_t count = slot.keypoints.size();
+    slot.frame = frame;
+    std::copy(keypoints, keypoints + count, slot.keypoints.begin());
+    std::copy(keypoints3D, keypoints3D + count, slot.keypoints3D.begin());
+    std::copy(jointAngles, jointAngles + count, slot.jointAngles.begin());
+    std::copy(confidence, confidence + count, slot.confidence.begin());
+    m_recordHead.store(head + 1u, std::memory_order_release);
+    Notify();
+}
+
+void CSessionRecorder::Notify()
+{
+    //  Pairs with the fence in Run, either the recorder thread sees the push or this sees it going to sleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed))
+        Wake();
+}
+
+void CSessionRecorder::Wake()
+{
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_signalled = true;
+    m_wake.notify_one();
+}
+
+bool CSessionRecorder::OpenSegment(const cv::Size &size)
+{
+    m_video.release();
+    char suffix[32];
+    sprintf_s(suffix, sizeof(suffix), "-%u.avi", m_segment + 1u);
+    std::string file = m_videoPath + suffix;
+    if (!m_video.open(file, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), m_videoFps, size))
+    {
+        vr_log("Unable to create the video %s, camera frames are no longer recorded", file.c_str());
+        return false;
+    }
+    m_segment++;
+    m_segmentFrames = 0u;
+    m_videoSize = size;
+    return true;
+}
+
+void CSessionRecorder::WriteFrame(const FrameSlot &slot)
+{
+    if (!m_recordVideo.load(std::memory_order_relaxed))
+        return;
+    cv::Size size = slot.image.size();
+    if ((!m_video.isOpened() || size != m_videoSize) && !OpenSegment(size))
+    {
+        m_recordVideo = false;
+        return;
+    }
+    m_video.write(slot.image);
+    fprintf(m_videoIndex, "%u,%llu,%llu,%.6f\n", m_segment, (unsigned long long)m_segmentFrames, (unsigned long long)slot.frameId, slot.time);
+    m_segmentFrames++;
+    m_framesWritten.fetch_add(1u, std::memory_order_relaxed);
+}
+
+void CSessionRecorder::Drain()
+{
+    //  Keypoints first, they are small and what a trace is mostly read for
+    uint64_t tail = m_recordTail.load(std::memory_order_relaxed);
+    while (tail != m_recordHead.load(std::memory_order_acquire))
+    {
+        const RecordSlot &slot = m_records[tail % SESSION_RECORD_QUEUE];
+        m_keypoints.Append(slot.frame, slot.keypoints.data(), slot.keypoints3D.data(), slot.jointAngles.data(), slot.confidence.data());
+        m_recordTail.store(++tail, std::memory_order_release);
+    }
+    //  A failed write closes the trace, what is still queued is let through and dropped
+    if (!m_keypoints.IsOpen())
+        m_recordKeypoints = false;
+
+    tail = m_frameTail.load(std::memory_order_relaxed);
+    while (tail != m_frameHead.load(std::memory_order_acquire))
+    {
+        WriteFrame(m_frames[tail % SESSION_FRAME_QUEUE]);
+        m_frameTail.store(++tail, std::memory_order_release);
+    }
+}
+
+bool CSessionRecorder::Pending() const
+{
+    return m_recordTail.load(std::memory_order_relaxed) != m_recordHead.load(std::memory_order_acquire) ||
+        m_frameTail.load(std::memory_order_relaxed) != m_frameHead.load(std::memory_order_acquire);
+}
+
+void CSessionRecorder::Run(const CStopToken &token)
+{
+    while (!token.StopRequested())
+    {
+        Drain();
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        //  Pairs with the fence in Notify, a push from here on either shows up below or wakes this
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        //  A stop requested after the check below still wakes this, the stop callback of the thread calls Wake
+        if (!m_signalled && !Pending() && !token.StopRequested())
+            m_wake.wait(lock, [this]() { return m_signalled; });
+        m_signalled = false;
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+    Drain();
+}
+
+void CSessionRecorder::CloseVideo()
+{
+    m_video.release();
+    if (m_videoIndex != nullptr)
+    {
+        fclose(m_videoIndex);
+        m_videoIndex = nullptr;
+    }
+}
+
+void CSessionRecorder::Close()
+{
+    bool keypoints = m_keypoints.IsOpen() || m_recordKeypoints;
+    bool video = m_videoIndex != nullptr;
+    if (!keypoints && !video)
+        return;
+    Drain();
+    m_recordKeypoints = false;
+    m_recordVideo = false;
+    if (keypoints)
+    {
+        vr_log("Keypoint trace closed after %llu frames (%llu dropped)",
+            (unsigned long long)m_keypoints.GetRecords(), (unsigned long long)GetRecordsDropped());
+        m_keypoints.Close();
+    }
+    if (video)
+    {
+        vr_log("Video closed after %llu frames in %u segments (%llu dropped)",
+            (unsigned long long)GetFramesWritten(), m_segment, (unsigned long long)GetFramesDropped());
+        CloseVideo();
+    }
+}
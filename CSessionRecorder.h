@@ -0,0 +1,108 @@
+#pragma once
+#include "CKeypointTrace.h"
+
+class CStopToken;
+
+//  Camera frames waiting for the recorder thread, about a quarter of a second at 30 FPS (each slot holds a full image)
+#define SESSION_FRAME_QUEUE 8u
+//  Keypoint records waiting for the recorder thread, about two seconds at 30 FPS
+#define SESSION_RECORD_QUEUE 64u
+
+//  Records a session for diagnosing tracking failures: camera frames to an MJPEG .avi, with a .csv giving the camera
+//  frame id and capture time of each, and the SDK outputs of every inference frame to a keypoint trace (see CKeypointTrace.h)
+//  The trace carries the same frame ids and capture times (systime), so video and keypoints line up frame for frame
+//  The camera thread only copies into preallocated queue slots, encoding and disk writes happen on the recorder thread.
+//  A full queue drops the new frame or record and counts it, so a slow disk costs data but never a camera frame
+class CSessionRecorder
+{
+    struct FrameSlot
+    {
+        cv::Mat image;
+        uint64_t frameId;
+        double time;
+    };
+    struct RecordSlot
+    {
+        KeypointTraceFrame frame;
+        std::vector<NvAR_Point2f> keypoints;
+        std::vector<NvAR_Point3f> keypoints3D;
+        std::vector<NvAR_Quaternion> jointAngles;
+        std::vector<float> confidence;
+    };
+
+    //  Single producer (the camera thread), single consumer (the recorder thread) rings
+    //  Heads only move on the camera thread and tails on the recorder thread, a slot belongs to whichever side is between them
+    FrameSlot m_frames[SESSION_FRAME_QUEUE];
+    std::atomic<uint64_t> m_frameHead;
+    std::atomic<uint64_t> m_frameTail;
+    RecordSlot m_records[SESSION_RECORD_QUEUE];
+    std::atomic<uint64_t> m_recordHead;
+    std::atomic<uint64_t> m_recordTail;
+
+    //  Only touched by the recorder thread once recording started
+    CKeypointRecorder m_keypoints;
+    cv::VideoWriter m_video;
+    FILE *m_videoIndex;
+    std::string m_videoPath;
+    double m_videoFps;
+    //  Frame size of the open video, a camera switch to another size starts the next segment
+    cv::Size m_videoSize;
+    unsigned m_segment;
+    uint64_t m_segmentFrames;
+
+    std::atomic<bool> m_recordKeypoints;
+    std::atomic<bool> m_recordVideo;
+    std::atomic<uint64_t> m_framesWritten;
+    std::atomic<uint64_t> m_framesDropped;
+    std::atomic<uint64_t> m_recordsDropped;
+
+    //  The recorder thread is about to wait, or waiting, on m_wake; the camera thread only takes the mutex to wake it then
+    std::atomic<bool> m_sleeping;
+    bool m_signalled;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+
+    //  Only for the recorder thread
+    bool Pending() const;
+    //  After a push, wakes the recorder thread if it went to sleep
+    void Notify();
+    void WriteFrame(const FrameSlot &slot);
+    bool OpenSegment(const cv::Size &size);
+    void CloseVideo();
+
+    CSessionRecorder(const CSessionRecorder &that) = delete;
+    CSessionRecorder &operator=(const CSessionRecorder &that) = delete;
+public:
+    CSessionRecorder();
+    ~CSessionRecorder();
+
+    //  Both only before the recorder thread starts. Paths are left without an extension, the recorder adds its own
+    //  batches is clamped to KEYPOINT_TRACE_BATCHES_MAX, fps only goes into the video header (the .csv has the real times)
+    //  An encoded keypoint trace stores the runs as pose packets, see CKeypointTrace.h
+    bool OpenKeypoints(const std::string &path, uint32_t batches, float focalLength, bool encoded = false);
+    bool OpenVideo(const std::string &path, double fps);
+
+    inline bool IsRecordingKeypoints() const { return m_recordKeypoints.load(std::memory_order_relaxed); }
+    inline bool IsRecordingVideo() const { return m_recordVideo.load(std::memory_order_relaxed); }
+    inline uint32_t GetBatches() const { return m_keypoints.GetBatches(); }
+
+    //  Camera thread only, neither waits for the recorder thread beyond taking its wake mutex when it sleeps
+    void PushFrame(const cv::Mat &image, uint64_t frameId, double time);
+    //  The arrays hold GetBatches() runs of BODY_JOINT_COUNT values, as in CKeypointRecorder::Append
+    void PushKeypoints(const KeypointTraceFrame &frame, const NvAR_Point2f *keypoints, const NvAR_Point3f *keypoints3D,
+        const NvAR_Quaternion *jointAngles, const float *confidence);
+
+    //  Write out everything queued so far, from the recorder thread (or the camera thread when no recorder thread runs)
+    void Drain();
+    //  Recorder thread body, sleeps until work is pushed and drains it, until a stop is requested and once more after
+    void Run(const CStopToken &token);
+    //  Wakes the recorder thread, the stop callback of its thread has to call it
+    void Wake();
+    //  Once the recorder thread is gone: write what is left, close the files and report the counters
+    void Close();
+
+    inline uint64_t GetFramesWritten() const { return m_framesWritten.load(std::memory_order_relaxed); }
+    inline uint64_t GetFramesDropped() const { return m_framesDropped.load(std::memory_order_relaxed); }
+    inline uint64_t GetRecordsWritten() const { return m_keypoints.GetRecords(); }
+    inline uint64_t GetRecordsDropped() const { return m_recordsDropped.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+//  Set on the shared slot index while it holds a value the reader has not taken yet
+#define SNAPSHOT_FRESH 0x4u
+#define SNAPSHOT_INDEX 0x3u
+
+//  Latest-value channel from one writer thread to one reader thread (a triple buffer)
+//  The writer fills its private slot and swaps it with the shared slot, the reader swaps the shared slot for its own
+//  Neither side ever blocks or spins, a slot is never written while it is being read, and older values are dropped
+template<class T>
+class CSnapshotBuffer
+{
+    T m_slots[3];
+    //  Index of the shared slot, plus SNAPSHOT_FRESH
+    std::atomic<unsigned> m_shared;
+    //  Owned by the writer and the reader respectively
+    unsigned m_write;
+    unsigned m_read;
+
+    CSnapshotBuffer(const CSnapshotBuffer &that) = delete;
+    CSnapshotBuffer &operator=(const CSnapshotBuffer &that) = delete;
+public:
+    CSnapshotBuffer() : m_slots(), m_shared(1u), m_write(0u), m_read(2u) {}
+
+    //  Writer: the slot to fill before publishing, it still holds an older value so every field must be written
+    inline T &Edit() { return m_slots[m_write]; }
+    inline void Publish() { m_write = m_shared.exchange(m_write | SNAPSHOT_FRESH, std::memory_order_acq_rel) & SNAPSHOT_INDEX; }
+
+    //  Reader: take the newest published value, returns false and keeps the current one when nothing new was published
+    inline bool Acquire()
+    {
+        if ((m_shared.load(std::memory_order_relaxed) & SNAPSHOT_FRESH) == 0u)
+            return false;
+        m_read = m_shared.exchange(m_read, std::memory_order_acq_rel) & SNAPSHOT_INDEX;
+        return true;
+    }
+    inline const T &Read() const { return m_slots[m_read]; }
+};
@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "CStatsExport.h"
+#include "CServerDriver.h"
+#include "CNvSDKInterface.h"
+#include "CCameraDriver.h"
+#include "CSessionRecorder.h"
+#include "CPosePublisher.h"
+#include "CTrackerBank.h"
+#include "CVirtualBodyTracker.h"
+#include "CCommon.h"
+
+CStatsExport::CStatsExport()
+{
+#ifdef _WIN32
+    m_mapping = nullptr;
+#endif
+    m_block = nullptr;
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_lastUpdate = -1.0;
+    memset(m_lastStages, 0, sizeof(m_lastStages));
+}
+
+CStatsExport::~CStatsExport()
+{
+    Close();
+}
+
+bool CStatsExport::Open()
+{
+    if (m_block != nullptr)
+        return true;
+#ifdef _WIN32
+    m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)sizeof(DriverStatsBlock), DRIVER_STATS_MAPPING);
+    if (m_mapping == nullptr)
+    {
+        vr_log("Unable to create the stats block %s (error %lu), the overlay shows no stats", DRIVER_STATS_MAPPING, GetLastError());
+        return false;
+    }
+    m_block = (DriverStatsBlock *)MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(DriverStatsBlock));
+    if (m_block == nullptr)
+    {
+        vr_log("Unable to map the stats block %s (error %lu), the overlay shows no stats", DRIVER_STATS_MAPPING, GetLastError());
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return false;
+    }
+    //  Fresh mappings are zeroed, one the overlay kept open across a driver restart carries on from its sequence
+    m_block->Write(m_stats);
+    m_block->version = DRIVER_STATS_VERSION;
+    vr_log("Publishing pipeline stats to %s", DRIVER_STATS_MAPPING);
+    return true;
+#else
+    vr_log("The stats block is only published on Windows");
+    return false;
+#endif
+}
+
+void CStatsExport::Close()
+{
+#ifdef _WIN32
+    if (m_block != nullptr)
+        UnmapViewOfFile(m_block);
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#endif
+    m_block = nullptr;
+}
+
+void CStatsExport::Update(CServerDriver &driver, double now)
+{
+    if (m_block == nullptr || (m_lastUpdate >= 0.0 && now - m_lastUpdate < DRIVER_STATS_INTERVAL))
+        return;
+    double elapsed = m_lastUpdate >= 0.0 ? now - m_lastUpdate : 0.0;
+    m_lastUpdate = now;
+
+    DriverStats &stats = m_stats;
+    stats.updates++;
+
+    //  Every stage is summarized once, the rates come from how much each histogram grew since the last update
+    LatencySummary stages[(size_t)LATENCY_STAGE::COUNT];
+    for (size_t stage = 0; stage < (size_t)LATENCY_STAGE::COUNT; stage++)
+        stages[stage] = driver.GetLatency().Summarize((LATENCY_STAGE)stage);
+    auto frames = [&](LATENCY_STAGE stage) { return stages[(size_t)stage].count - m_lastStages[(size_t)stage].count; };
+    //  Milliseconds spent in the stage since the last update
+    auto spent = [&](LATENCY_STAGE stage) {
+        const LatencySummary &current = stages[(size_t)stage], &last = m_lastStages[(size_t)stage];
+        return (std::max)(current.mean * (double)current.count - last.mean * (double)last.count, 0.0);
+    };
+    uint64_t inferences = frames(LATENCY_STAGE::INFERENCE);
+    stats.captureFps = elapsed > 0.0 ? (float)(frames(LATENCY_STAGE::CAPTURE) / elapsed) : 0.f;
+    stats.inferenceFps = elapsed > 0.0 ? (float)(inferences / elapsed) : 0.f;
+    stats.inferenceMs = inferences > 0u ? (float)(spent(LATENCY_STAGE::INFERENCE) / (double)inferences) : 0.f;
+    stats.gpuShare = elapsed > 0.0 ? (float)((spent(LATENCY_STAGE::TRANSFER) + spent(LATENCY_STAGE::INFERENCE)) * .001 / elapsed) : 0.f;
+    std::copy(stages, stages + (size_t)LATENCY_STAGE::COUNT, m_lastStages);
+
+    //  Percentiles of the last closed latency window, so a recent slowdown shows; until one closes, since startup
+    const CLatencyStats &latency = driver.GetLatency();
+    bool windowed = latency.GetWindowLength() > 0.0;
+    stats.stageWindow = (float)latency.GetWindowLength();
+    stats.stageCount = (uint32_t)(std::min)((size_t)LATENCY_STAGE::COUNT, (size_t)DRIVER_STATS_STAGES);
+    for (uint32_t stage = 0; stage < stats.stageCount; stage++)
+    {
+        DriverStageStats &entry = stats.stages[stage];
+        const LatencySummary &summary = windowed ? latency.SummarizeWindow((LATENCY_STAGE)stage) : stages[stage];
+        strncpy_s(entry.name, sizeof(entry.name), LatencyStageName[stage], _TRUNCATE);
+        entry.p50 = (float)summary.p50;
+        entry.p95 = (float)summary.p95;
+        entry.p99 = (float)summary.p99;
+    }
+
+    stats.standby = driver.IsStandby() ? 1u : 0u;
+    CNvSDKInterface *track = driver.m_nvInterface;
+    stats.probing = track != nullptr && track->presence.GetMode() == PRESENCE_MODE::PROBING ? 1u : 0u;
+    stats.framesSkipped = track != nullptr ? track->presence.GetSkipped() : 0u;
+    stats.trackingTime = track != nullptr ? track->presence.GetTimeInMode(PRESENCE_MODE::TRACKING, now) : 0.0;
+    stats.probingTime = track != nullptr ? track->presence.GetTimeInMode(PRESENCE_MODE::PROBING, now) : 0.0;
+    stats.motionLatencyMs = track != nullptr && track->motionLatency.HasEstimate() ? (float)(track->motionLatency.GetLatency() * 1000.0) : -1.f;
+
+    CCameraDriver *camera = driver.m_cameraDriver;
+    strncpy_s(stats.cameraState, sizeof(stats.cameraState), camera != nullptr ? CameraHealthName[(int)camera->GetHealth()] : "None", _TRUNCATE);
+    stats.cameraStalls = camera != nullptr ? camera->GetStalls() : 0u;
+
+    CSessionRecorder *recorder = driver.m_recorder;
+    stats.recorderFramesDropped = recorder != nullptr ? recorder->GetFramesDropped() : 0u;
+    stats.recorderRecordsDropped = recorder != nullptr ? recorder->GetRecordsDropped() : 0u;
+    stats.publisherOverruns = driver.m_publisher != nullptr ? driver.m_publisher->GetOverrunTotal() : 0u;
+
+    //  The snapshot the publisher ingested last, it stays put until this thread acquires the next one
+    const PoseSnapshot &snapshot = driver.m_poseSnapshots->Read();
+    stats.trackerCount = (uint32_t)(std::min)(driver.m_trackers.size(), (size_t)DRIVER_STATS_TRACKERS);
+    for (uint32_t index = 0; index < stats.trackerCount; index++)
+    {
+        const CVirtualBodyTracker &tracker = *driver.m_trackers[index];
+        DriverTrackerStats &entry = stats.trackers[index];
+        strncpy_s(entry.name, sizeof(entry.name), TrackerRoleName[(int)tracker.role], _TRUNCATE);
+        entry.confidence = snapshot.trackerConfidence[tracker.GetIndex()];
+        entry.standby = tracker.IsConnected() ? 0u : 1u;
+    }
+
+    m_block->Write(stats);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "CDriverStats.h"
+#include "CLatencyHistogram.h"
+
+class CServerDriver;
+
+//  Publishes the pipeline stats to shared memory for the dashboard overlay (see CDriverStats.h)
+//  Update runs on the publisher thread, which owns the tracker state it reads; everything else it reads is atomic
+//  or only ever grows. Rates are taken over the interval between two updates
+class CStatsExport
+{
+#ifdef _WIN32
+    HANDLE m_mapping;
+#endif
+    DriverStatsBlock *m_block;
+    DriverStats m_stats;
+
+    double m_lastUpdate;
+    uint64_t m_lastFrameId;
+    //  Count and mean (milliseconds) of each stage at the last update
+    LatencySummary m_lastStages[(size_t)LATENCY_STAGE::COUNT];
+
+    CStatsExport(const CStatsExport &that) = delete;
+    CStatsExport &operator=(const CStatsExport &that) = delete;
+public:
+    CStatsExport();
+    ~CStatsExport();
+
+    //  Create the shared memory, false (after logging why) when it cannot be; only on Windows
+    bool Open();
+    void Close();
+    inline bool IsOpen() const { return m_block != nullptr; }
+
+    //  Gather and write the stats, once DRIVER_STATS_INTERVAL passed since the last write
+    void Update(CServerDriver &driver, double now);
+};
@@ -0,0 +1,115 @@
+#include "pch.h"
+#include "CThreadTopology.h"
+#include "CCommon.h"
+
+#ifdef _WIN32
+#include <avrt.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *ThreadRoleName[] = {
+    "Camera",
+    "Publisher",
+    "Input"
+};
+
+const char *ThreadPriorityName[] = {
+    "Idle",
+    "Lowest",
+    "BelowNormal",
+    "Normal",
+    "AboveNormal",
+    "Highest",
+    "TimeCritical"
+};
+
+#ifdef _WIN32
+static const int ms_priorities[] = {
+    THREAD_PRIORITY_IDLE,
+    THREAD_PRIORITY_LOWEST,
+    THREAD_PRIORITY_BELOW_NORMAL,
+    THREAD_PRIORITY_NORMAL,
+    THREAD_PRIORITY_ABOVE_NORMAL,
+    THREAD_PRIORITY_HIGHEST,
+    THREAD_PRIORITY_TIME_CRITICAL
+};
+
+bool ApplyThreadPlacement(const ThreadPlacement &placement, THREAD_ROLE role)
+{
+    bool applied = true;
+    HANDLE thread = GetCurrentThread();
+
+    if (placement.affinity != 0u && SetThreadAffinityMask(thread, (DWORD_PTR)placement.affinity) == 0u)
+        applied = false;
+    if (!SetThreadPriority(thread, ms_priorities[(int)placement.priority]))
+        applied = false;
+    if (placement.realtime)
+    {
+        //  The task stays registered until the thread exits
+        DWORD taskIndex = 0u;
+        if (AvSetMmThreadCharacteristicsW(L"Games", &taskIndex) == nullptr)
+            applied = false;
+    }
+
+    vr_log(
+        "%s thread: affinity 0x%llx, priority %s%s%s",
+        ThreadRoleName[(int)role],
+        (unsigned long long)placement.affinity,
+        ThreadPriorityName[(int)placement.priority],
+        placement.realtime ? ", real-time" : "",
+        applied ? "" : " (partially refused)"
+    );
+    return applied;
+}
+#else
+//  Nice values for normal scheduling, and SCHED_FIFO levels (1 - 99) for real-time
+static const int ms_niceLevels[] = { 19, 10, 5, 0, -5, -10, -20 };
+static const int ms_fifoLevels[] = { 1, 10, 30, 50, 70, 90, 99 };
+
+bool ApplyThreadPlacement(const ThreadPlacement &placement, THREAD_ROLE role)
+{
+    bool applied = true;
+    pthread_t thread = pthread_self();
+
+    if (placement.affinity != 0u)
+    {
+        cpu_set_t cores;
+        CPU_ZERO(&cores);
+        for (int core = 0; core < 64 && core < CPU_SETSIZE; core++)
+        {
+            if ((placement.affinity >> core) & 1u)
+                CPU_SET(core, &cores);
+        }
+        if (pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cores) != 0)
+            applied = false;
+    }
+
+    if (placement.realtime)
+    {
+        sched_param param;
+        param.sched_priority = ms_fifoLevels[(int)placement.priority];
+        if (pthread_setschedparam(thread, SCHED_FIFO, &param) != 0)
+            applied = false;
+    }
+    //  Linux keeps a nice value per thread, addressed by its kernel id
+    else if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), ms_niceLevels[(int)placement.priority]) != 0)
+    {
+        applied = false;
+    }
+
+    vr_log(
+        "%s thread: affinity 0x%llx, priority %s%s%s",
+        ThreadRoleName[(int)role],
+        (unsigned long long)placement.affinity,
+        ThreadPriorityName[(int)placement.priority],
+        placement.realtime ? ", real-time" : "",
+        applied ? "" : " (partially refused)"
+    );
+    return applied;
+}
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+//  Threads whose placement is configured in settings.ini
+//  Capture, decode, inference and post-processing all run one after another on the camera thread
+enum class THREAD_ROLE
+{
+    CAMERA,
+    PUBLISHER,
+    INPUT,
+    COUNT
+};
+extern const char *ThreadRoleName[];
+
+//  Relative thread priority, mapped onto the platform's own levels
+enum class THREAD_PRIORITY
+{
+    IDLE,
+    LOWEST,
+    BELOW_NORMAL,
+    NORMAL,
+    ABOVE_NORMAL,
+    HIGHEST,
+    TIME_CRITICAL
+};
+extern const char *ThreadPriorityName[];
+
+//  Where and how urgently a thread runs
+struct ThreadPlacement
+{
+    //  Logical cores the thread may run on (bit n is core n), 0 leaves it to the scheduler
+    uint64_t affinity;
+    THREAD_PRIORITY priority;
+    //  Ask for real-time scheduling (MMCSS "Games" task on Windows, SCHED_FIFO on Linux)
+    bool realtime;
+};
+
+//  Apply a placement to the calling thread, each thread applies its own when it starts
+//  Returns false if any part was refused by the OS, the remaining parts are still applied
+bool ApplyThreadPlacement(const ThreadPlacement &placement, THREAD_ROLE role);
@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "CTraceRecorder.h"
+#include "CManagedThread.h"
+#include "CCommon.h"
+
+#ifndef _WIN32
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct TraceThread
+{
+    uint32_t id;
+    char name[TRACE_THREAD_NAME_SIZE];
+};
+
+//  Names belong to threads rather than to a recorder, so they are kept once for the whole process
+static std::mutex s_threadMutex;
+static TraceThread s_threads[TRACE_MAX_THREADS];
+static size_t s_threadCount = 0;
+
+uint32_t TraceThreadId()
+{
+    thread_local uint32_t id = 0u;
+    if (id == 0u)
+    {
+#ifdef _WIN32
+        id = (uint32_t)GetCurrentThreadId();
+#else
+        id = (uint32_t)syscall(SYS_gettid);
+#endif
+    }
+    return id;
+}
+
+void TraceThreadName(const char *name)
+{
+    uint32_t id = TraceThreadId();
+    std::lock_guard<std::mutex> lock(s_threadMutex);
+    size_t index = 0;
+    while (index < s_threadCount && s_threads[index].id != id)
+        index++;
+    if (index == TRACE_MAX_THREADS)
+        return;
+    if (index == s_threadCount)
+        s_threadCount++;
+    s_threads[index].id = id;
+    strncpy_s(s_threads[index].name, TRACE_THREAD_NAME_SIZE, name, _TRUNCATE);
+}
+
+CTraceRecorder::CTraceRecorder()
+{
+    m_slots = nullptr;
+    m_capacity = 0;
+    m_enabled = false;
+    m_next = 0u;
+    m_exporting = false;
+}
+
+CTraceRecorder::~CTraceRecorder()
+{
+    delete[] m_slots;
+}
+
+void CTraceRecorder::Enable(size_t capacity)
+{
+    if (m_slots != nullptr)
+        return;
+
+    //  A power of two, so the ring position is a mask away from the slot
+    m_capacity = 1;
+    while (m_capacity < (std::max)(capacity, (size_t)1u))
+        m_capacity <<= 1;
+    m_slots = new Slot[m_capacity];
+    for (size_t index = 0; index < m_capacity; index++)
+        m_slots[index].sequence.store(0u, std::memory_order_relaxed);
+    m_enabled.store(true, std::memory_order_release);
+    vr_log("Tracing enabled, keeping the last %u spans", (unsigned)m_capacity);
+}
+
+void CTraceRecorder::Record(const char *name, uint64_t frame, int64_t start, int64_t end)
+{
+    if (!m_enabled.load(std::memory_order_acquire))
+        return;
+
+    uint64_t position = m_next.fetch_add(1u, std::memory_order_relaxed);
+    Slot &slot = m_slots[position & (m_capacity - 1u)];
+    slot.sequence.store(0u, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.thread.store(TraceThreadId(), std::memory_order_relaxed);
+    slot.frame.store(frame, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(end - start, std::memory_order_relaxed);
+    slot.sequence.store(position + 1u, std::memory_order_release);
+}
+
+std::vector<TraceSpan> CTraceRecorder::Collect() const
+{
+    std::vector<TraceSpan> spans;
+    if (!m_enabled.load(std::memory_order_acquire))
+        return spans;
+
+    uint64_t end = m_next.load(std::memory_order_acquire);
+    uint64_t begin = end > m_capacity ? end - m_capacity : 0u;
+    spans.reserve((size_t)(end - begin));
+    for (uint64_t position = begin; position < end; position++)
+    {
+        const Slot &slot = m_slots[position & (m_capacity - 1u)];
+        //  Spans still being written, or already overwritten by a newer one, fail the sequence check and are left out
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1u)
+            continue;
+        TraceSpan span;
+        span.name = slot.name.load(std::memory_order_relaxed);
+        span.thread = slot.thread.load(std::memory_order_relaxed);
+        span.frame = slot.frame.load(std::memory_order_relaxed);
+        span.start = slot.start.load(std::memory_order_relaxed);
+        span.duration = slot.duration.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != position + 1u)
+            continue;
+        spans.push_back(span);
+    }
+    return spans;
+}
+
+bool CTraceRecorder::Export(const char *path, const CStopToken *token) const
+{
+    std::vector<TraceSpan> spans = Collect();
+
+    FILE *file = nullptr;
+    if (fopen_s(&file, path, "w") != 0 || file == nullptr)
+    {
+        vr_log("Unable to write the trace to %s", path);
+        return false;
+    }
+
+    //  Timestamps are made relative to the oldest span, Chrome trace events are in microseconds
+    int64_t origin = spans.empty() ? 0 : spans.front().start;
+    for (auto &span : spans)
+        origin = (std::min)(origin, span.start);
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"NVIDIA BodyTracking driver\"}}");
+    {
+        std::lock_guard<std::mutex> lock(s_threadMutex);
+        for (size_t index = 0; index < s_threadCount; index++)
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", s_threads[index].id, s_threads[index].name);
+    }
+    for (auto &span : spans)
+    {
+        if (token != nullptr && token->StopRequested())
+        {
+            fclose(file);
+            remove(path);
+            vr_log("Trace export to %s was cancelled", path);
+            return false;
+        }
+        fprintf(
+            file,
+            ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+            span.name,
+            span.thread,
+            (double)(span.start - origin) * 0.001,
+            (double)span.duration * 0.001,
+            (unsigned long long)span.frame
+        );
+    }
+    fprintf(file, "\n]}\n");
+
+    bool written = ferror(file) == 0;
+    written = fclose(file) == 0 && written;
+    if (written)
+        vr_log("Wrote %u trace spans to %s", (unsigned)spans.size(), path);
+    else
+        vr_log("Unable to write the trace to %s", path);
+    return written;
+}
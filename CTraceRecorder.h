@@ -0,0 +1,96 @@
+#pragma once
+#include "CLatencyHistogram.h"
+
+class CStopToken;
+
+//  Spans kept when tracing is enabled without a configured capacity (rounded up to a power of two)
+#define TRACE_DEFAULT_CAPACITY 65536u
+//  Longest thread name kept for the trace, including the terminator
+#define TRACE_THREAD_NAME_SIZE 32
+//  Threads the trace can name, any beyond that show up by id only
+#define TRACE_MAX_THREADS 16
+
+//  One timed section of the pipeline
+struct TraceSpan
+{
+    //  String literal, only the pointer is kept
+    const char *name;
+    uint32_t thread;
+    //  Camera frame for the camera and publisher threads, SteamVR frame for RunFrame
+    uint64_t frame;
+    //  LatencyNow timestamps, in nanoseconds
+    int64_t start;
+    int64_t duration;
+};
+
+//  Names the calling thread in every trace written afterwards (the name is copied)
+void TraceThreadName(const char *name);
+//  Small stable id of the calling thread, the OS thread id where there is one
+uint32_t TraceThreadId();
+
+//  Opt-in record of pipeline spans from every thread, exported as Chrome trace event JSON
+//  (chrome://tracing, ui.perfetto.dev) to see how the camera thread, the publisher and SteamVR's RunFrame interleave
+//  Spans go into a fixed ring, the oldest are overwritten. Recording is a fetch_add and a few relaxed stores,
+//  and costs a single relaxed load while tracing is off
+class CTraceRecorder
+{
+    struct Slot
+    {
+        //  Seqlock: 0 while a writer fills the slot, ring position + 1 once it is complete
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char *> name;
+        std::atomic<uint32_t> thread;
+        std::atomic<uint64_t> frame;
+        std::atomic<int64_t> start;
+        std::atomic<int64_t> duration;
+    };
+
+    Slot *m_slots;
+    size_t m_capacity;
+    std::atomic<bool> m_enabled;
+    std::atomic<uint64_t> m_next;
+    //  An export is being written, further requests are ignored until it finishes
+    std::atomic<bool> m_exporting;
+
+    CTraceRecorder(const CTraceRecorder &that) = delete;
+    CTraceRecorder &operator=(const CTraceRecorder &that) = delete;
+public:
+    CTraceRecorder();
+    ~CTraceRecorder();
+
+    //  Allocates the ring, only before any thread records
+    void Enable(size_t capacity = TRACE_DEFAULT_CAPACITY);
+    inline bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    void Record(const char *name, uint64_t frame, int64_t start, int64_t end);
+
+    //  Copies the complete spans still in the ring, oldest first
+    std::vector<TraceSpan> Collect() const;
+    //  Writes the ring to a Chrome trace JSON file, false if it could not be written
+    //  With a token the export gives up between spans once a stop is requested, and removes the partial file
+    bool Export(const char *path, const CStopToken *token = nullptr) const;
+
+    //  Guards against starting a second export while one is still being written
+    inline bool BeginExport() { return !m_exporting.exchange(true, std::memory_order_acq_rel); }
+    inline void EndExport() { m_exporting.store(false, std::memory_order_release); }
+};
+
+//  Records the lifetime of a scope as one span, nothing at all while tracing is off
+class CTraceScope
+{
+    CTraceRecorder &m_recorder;
+    const char *m_name;
+    uint64_t m_frame;
+    int64_t m_start;
+
+    CTraceScope(const CTraceScope &that) = delete;
+    CTraceScope &operator=(const CTraceScope &that) = delete;
+public:
+    CTraceScope(CTraceRecorder &recorder, const char *name, uint64_t frame)
+        : m_recorder(recorder), m_name(name), m_frame(frame), m_start(recorder.IsEnabled() ? LatencyNow() : 0) {}
+    ~CTraceScope()
+    {
+        if (m_start != 0)
+            m_recorder.Record(m_name, m_frame, m_start, LatencyNow());
+    }
+};
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "CTrackerBank.h"
+#include "CDriverSettings.h"
+
+CTrackerBank::CTrackerBank(size_t frameCache, INTERP_MODE mode, bool cacheImmediate) : m_history(frameCache, 0)
+{
+    m_interpolator = SelectInterpolator(mode, m_history.Size());
+    m_cacheImmediate = cacheImmediate;
+    m_count = 0;
+    for (size_t index = 0; index < TRANSFORM_LANES_MAX; index++)
+    {
+        m_valid[index] = false;
+        m_sampleTime[index] = 0.0;
+        m_velocity[index] = glm::vec3(0.f);
+        m_angularVelocity[index] = glm::vec3(0.f);
+    }
+    m_lastCall = systime();
+    m_interval = 1.0;
+    m_time = m_lastCall;
+}
+
+size_t CTrackerBank::AddTracker()
+{
+    if (m_count >= TRANSFORM_LANES_MAX)
+        return TRANSFORM_LANES_MAX;
+    m_history.SetLanes(m_count + 1);
+    return m_count++;
+}
+
+void CTrackerBank::EstimateVelocity(size_t index, const RigidTransform &transform, double sampleTime)
+{
+    double dt = sampleTime - m_sampleTime[index];
+    if (!m_valid[index] || dt <= 0.0 || dt > VELOCITY_MAX_GAP)
+    {
+        m_velocity[index] = glm::vec3(0.f);
+        m_angularVelocity[index] = glm::vec3(0.f);
+        return;
+    }
+
+    RigidTransform previous = m_targets.Get(index);
+    glm::vec3 velocity = (transform.Position() - previous.Position()) / (float)dt;
+
+    //  Rotation taken between the two samples, kept on the short arc
+    glm::quat delta = RigidTransform::QuatMultiply(transform.Rotation(), glm::conjugate(previous.Rotation()));
+    if (delta.w < 0.f)
+        delta = -delta;
+    glm::vec3 angularVelocity = glm::axis(delta) * (glm::angle(delta) / (float)dt);
+
+    m_velocity[index] = glm::mix(m_velocity[index], velocity, VELOCITY_SMOOTHING);
+    m_angularVelocity[index] = glm::mix(m_angularVelocity[index], angularVelocity, VELOCITY_SMOOTHING);
+}
+
+void CTrackerBank::SetSample(size_t index, const RigidTransform &transform, double sampleTime)
+{
+    EstimateVelocity(index, transform, sampleTime);
+
+    //  A tracker coming back from standby starts from its new sample rather than sweeping in from a stale history
+    if (!m_valid[index])
+    {
+        m_history.Fill(index, transform);
+        m_outputs.Set(index, transform);
+    }
+
+    m_targets.Set(index, transform);
+    m_sampleTime[index] = sampleTime;
+    m_valid[index] = true;
+}
+
+void CTrackerBank::InvalidateSample(size_t index)
+{
+    m_valid[index] = false;
+    m_velocity[index] = glm::vec3(0.f);
+    m_angularVelocity[index] = glm::vec3(0.f);
+}
+
+void CTrackerBank::Ingest(const PoseSnapshot &snapshot)
+{
+    m_offset = snapshot.offset;
+    for (size_t index = 0; index < m_count; index++)
+    {
+        if (snapshot.valid[index])
+            SetSample(index, snapshot.targets.Get(index), snapshot.sampleTime);
+        else
+            InvalidateSample(index);
+    }
+
+    //  Trackers without a new sample repeat their last one, which keeps every history in lockstep
+    m_history.Push(m_cacheImmediate ? m_targets : m_outputs);
+
+    m_interval += snapshot.arrival - m_lastCall;
+    m_interval /= 3.0;
+    m_lastCall = snapshot.arrival;
+}
+
+void CTrackerBank::Evaluate(double now)
+{
+    m_time = now;
+    float t = (std::min)((float)((now - m_lastCall) / m_interval), 1.5f);
+    m_interpolator(m_history, m_targets, m_outputs, t);
+
+    //  Trackers in standby hold their newest sample
+    for (size_t index = 0; index < m_count; index++)
+    {
+        if (!m_valid[index])
+            m_outputs.Set(index, m_targets.Get(index));
+    }
+}
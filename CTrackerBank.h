@@ -0,0 +1,99 @@
+#pragma once
+#include "CCommon.h"
+#include "CInterpolator.h"
+
+enum class INTERP_MODE;
+
+//  Weight given to the newest sample when smoothing the estimated velocities
+#define VELOCITY_SMOOTHING 0.5f
+//  Samples further apart than this (in seconds) do not produce a velocity
+#define VELOCITY_MAX_GAP 0.25
+
+//  Everything the camera thread produces for one inference, handed to the SteamVR thread as a whole
+//  The writer fills every field before publishing; lanes that are not valid carry no target
+struct PoseSnapshot
+{
+    //  Capture time of the camera frame, and when the snapshot was published
+    double sampleTime;
+    double arrival;
+    //  When capturing the frame started (LatencyNow), for the end to end latency
+    int64_t captureStart;
+    //  Camera frame the snapshot was computed from, for the trace
+    uint64_t frameId;
+    //  Whether body tracking ran on this frame at all
+    bool active;
+
+    //  Driver space of the skeleton (the camera transform)
+    RigidTransform offset;
+    //  Per tracker targets, and whether each tracker passed its confidence check
+    TransformLanes targets;
+    bool valid[TRANSFORM_LANES_MAX];
+    //  Confidence of the joints each tracker follows, what its check was made against
+    float trackerConfidence[TRANSFORM_LANES_MAX];
+
+    //  The post-processed skeleton, indexed by BODY_JOINT
+    glm::vec3 keypoints[BODY_JOINT_COUNT];
+    glm::quat rotations[BODY_JOINT_COUNT];
+    float confidence[BODY_JOINT_COUNT];
+};
+
+//  Pose state of every body tracker, laid out as structure-of-arrays so all of them are interpolated in one pass
+//  Owned by the SteamVR thread: it ingests each PoseSnapshot the camera thread publishes, evaluates the bank once per frame
+//  and each tracker then only copies its lane into the pose it submits
+class CTrackerBank
+{
+    CTransformHistory m_history;
+    InterpolatorFn m_interpolator;
+    bool m_cacheImmediate;
+    size_t m_count;
+
+    //  Newest sample of every tracker, and the transforms last handed to SteamVR
+    TransformLanes m_targets;
+    TransformLanes m_outputs;
+
+    //  Whether the newest sample of a tracker passed its confidence check
+    bool m_valid[TRANSFORM_LANES_MAX];
+    //  Capture time of the newest sample of a tracker
+    double m_sampleTime[TRANSFORM_LANES_MAX];
+    //  Velocities estimated from consecutive samples (driver space)
+    glm::vec3 m_velocity[TRANSFORM_LANES_MAX];
+    glm::vec3 m_angularVelocity[TRANSFORM_LANES_MAX];
+
+    //  Driver space of the newest sample set (the camera transform)
+    RigidTransform m_offset;
+
+    //  When the newest sample set arrived, and the smoothed interval between sets
+    double m_lastCall;
+    double m_interval;
+    //  The time the bank was last evaluated at
+    double m_time;
+
+    CTrackerBank(const CTrackerBank &that) = delete;
+    CTrackerBank &operator=(const CTrackerBank &that) = delete;
+
+    void EstimateVelocity(size_t index, const RigidTransform &transform, double sampleTime);
+    void SetSample(size_t index, const RigidTransform &transform, double sampleTime);
+    void InvalidateSample(size_t index);
+public:
+    CTrackerBank(size_t frameCache, INTERP_MODE mode, bool cacheImmediate);
+
+    //  Reserve the lane for a new tracker, returns TRANSFORM_LANES_MAX when the bank is full
+    size_t AddTracker();
+    inline size_t Size() const { return m_count; }
+
+    //  Take in a new sample set
+    void Ingest(const PoseSnapshot &snapshot);
+    //  Interpolate every tracker for the given time
+    void Evaluate(double now);
+
+    inline const RigidTransform GetOutput(size_t index) const { return m_outputs.Get(index); }
+    inline const RigidTransform GetTarget(size_t index) const { return m_targets.Get(index); }
+    inline const RigidTransform &GetOffset() const { return m_offset; }
+    inline bool IsValid(size_t index) const { return m_valid[index]; }
+    inline double GetSampleTime(size_t index) const { return m_sampleTime[index]; }
+    inline const glm::vec3 &GetVelocity(size_t index) const { return m_velocity[index]; }
+    inline const glm::vec3 &GetAngularVelocity(size_t index) const { return m_angularVelocity[index]; }
+    inline double GetLastCall() const { return m_lastCall; }
+    inline double GetInterval() const { return m_interval; }
+    inline double GetTime() const { return m_time; }
+};
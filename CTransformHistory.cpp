@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "CTransformHistory.h"
+
+CTransformHistory::CTransformHistory(size_t size, size_t lanes)
+{
+    Reset(size, lanes);
+}
+
+void CTransformHistory::Reset(size_t size, size_t lanes)
+{
+    m_size = (std::min)(size, (size_t)TRANSFORM_HISTORY_MAX);
+    m_lanes = (std::min)(lanes, (size_t)TRANSFORM_LANES_MAX);
+
+    //  Row (m_size - 1) of Pascal's triangle
+    if (m_size > 0)
+    {
+        m_binomials[0] = 1.f;
+        for (size_t index = 1; index < m_size; index++)
+            m_binomials[index] = m_binomials[index - 1] * (float)(m_size - index) / (float)index;
+    }
+
+    for (size_t index = 0; index < TRANSFORM_HISTORY_MAX; index++)
+    {
+        m_samples[index] = TransformLanes();
+        m_controls[index] = TransformLanes();
+    }
+}
+
+void CTransformHistory::SetLanes(size_t lanes)
+{
+    m_lanes = (std::min)(lanes, (size_t)TRANSFORM_LANES_MAX);
+}
+
+void CTransformHistory::Fill(size_t lane, const RigidTransform &transform)
+{
+    for (size_t index = 0; index < m_size; index++)
+    {
+        m_samples[index].Set(lane, transform);
+        m_controls[index].Set(lane, transform);
+    }
+}
+
+void CTransformHistory::ComputeControl(size_t index)
+{
+    if (index == 0 || index + 1 >= m_size)
+    {
+        m_controls[index] = m_samples[index];
+        return;
+    }
+    for (size_t lane = 0; lane < m_lanes; lane++)
+    {
+        m_controls[index].Set(lane, RigidTransform(glm::vec3(0.f), glm::intermediate(
+            m_samples[index - 1].Get(lane).Rotation(),
+            m_samples[index].Get(lane).Rotation(),
+            m_samples[index + 1].Get(lane).Rotation()
+        )));
+    }
+}
+
+void CTransformHistory::Push(const TransformLanes &sample)
+{
+    if (m_size == 0)
+        return;
+
+    std::copy(m_samples + 1, m_samples + m_size, m_samples);
+    std::copy(m_controls + 1, m_controls + m_size, m_controls);
+
+    m_samples[m_size - 1] = sample;
+    //  Keep neighbouring rotations on the same hemisphere so the spline takes the short path
+    if (m_size > 1)
+        TransformLanes::AlignRotations(m_samples[m_size - 2], m_samples[m_size - 1], m_lanes);
+
+    //  Only the end points and the control point next to the new sample change, the rest shifted along with their neighbours
+    ComputeControl(0);
+    if (m_size > 2)
+        ComputeControl(m_size - 2);
+    ComputeControl(m_size - 1);
+}
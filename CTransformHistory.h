@@ -0,0 +1,70 @@
+#pragma once
+#include "CRigidTransform.h"
+
+//  The largest number of frames a tracker is able to cache (FrameCache is clamped to this)
+#define TRANSFORM_HISTORY_MAX 16
+
+//  Fixed capacity history of transforms for a whole set of trackers, stored as structure-of-arrays blocks
+//  Every tracker receives a sample on each push, so the histories stay in lockstep and share their curve weights
+//  Positions are evaluated as a Bezier curve using closed-form Bernstein weights, rotations as a SQUAD spline
+//  Nothing in here allocates, so it is safe to evaluate on every SteamVR frame
+class CTransformHistory
+{
+    //  Samples ordered from oldest [0] to newest [m_size - 1]
+    TransformLanes m_samples[TRANSFORM_HISTORY_MAX];
+    //  Inner SQUAD control points (rotations only), updated whenever a sample is pushed
+    TransformLanes m_controls[TRANSFORM_HISTORY_MAX];
+    //  Binomial coefficients for a curve of m_size points
+    float m_binomials[TRANSFORM_HISTORY_MAX];
+
+    size_t m_size;
+    size_t m_lanes;
+
+    void ComputeControl(size_t index);
+public:
+    explicit CTransformHistory(size_t size = 0, size_t lanes = 0);
+
+    void Reset(size_t size, size_t lanes);
+    void SetLanes(size_t lanes);
+    //  Overwrite every cached sample of one tracker
+    void Fill(size_t lane, const RigidTransform &transform);
+    void Push(const TransformLanes &sample);
+
+    inline size_t Size() const { return m_size; }
+    inline size_t Lanes() const { return m_lanes; }
+    inline const TransformLanes &GetSample(size_t index) const { return m_samples[index]; }
+
+    //  Evaluate every tracker at t for a history of exactly N samples (see CInterpolator.h)
+    //  Loops over N are unrolled by the compiler and the SQUAD spline is approximated with nlerp, so nothing transcendental runs
+    template<size_t N> void Evaluate(float t, TransformLanes &out) const;
+};
+
+template<size_t N>
+inline void CTransformHistory::Evaluate(float t, TransformLanes &out) const
+{
+    static_assert(N >= 2 && N <= TRANSFORM_HISTORY_MAX, "Unsupported history depth");
+
+    //  Bernstein basis: C(n, i) * (1 - t)^(n - i) * t^i, shared by every tracker
+    float tPow[N], uPow[N];
+    float u = 1.f - t;
+    tPow[0] = 1.f;
+    uPow[0] = 1.f;
+    for (size_t index = 1; index < N; index++)
+    {
+        tPow[index] = tPow[index - 1] * t;
+        uPow[index] = uPow[index - 1] * u;
+    }
+    for (size_t index = 0; index < N; index++)
+        TransformLanes::ScalePositions(m_samples[index], m_binomials[index] * uPow[N - 1 - index] * tPow[index], out, m_lanes, index > 0);
+
+    //  Map t onto the segments of the spline, extrapolating a little past the newest sample
+    float span = t * (float)(N - 1);
+    size_t segment = (size_t)(std::min)((std::max)(span, 0.f), (float)(N - 2));
+    float h = (std::min)(span - (float)segment, 1.5f);
+
+    //  squad(q1, q2, s1, s2, h) = slerp(slerp(q1, q2, h), slerp(s1, s2, h), 2h(1 - h)), with each slerp replaced by nlerp
+    TransformLanes inner;
+    TransformLanes::NlerpRotations(m_samples[segment], m_samples[segment + 1], h, out, m_lanes);
+    TransformLanes::NlerpRotations(m_controls[segment], m_controls[segment + 1], h, inner, m_lanes);
+    TransformLanes::NlerpRotations(out, inner, 2.f * h * (1.f - h), out, m_lanes);
+}
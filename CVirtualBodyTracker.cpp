@@ -1,19 +1,16 @@
 #include "pch.h"
 #include "CVirtualBodyTracker.h"
 #include "CCommon.h"
-#include "CNvSDKInterface.h"
-#include "CDriverSettings.h"
+#include "CTrackerBank.h"
 #include "CServerDriver.h"
+#include "CNvSDKInterface.h"
 
-CVirtualBodyTracker::CVirtualBodyTracker(size_t p_index, TRACKER_ROLE rle, size_t frameSize, bool cachefast) : m_transformCache(frameSize), m_curTransform{0.f}, frame(0), m_wasSet(false)
+CVirtualBodyTracker::CVirtualBodyTracker(size_t p_index, TRACKER_ROLE rle)
 {
-    m_transformCache.assign(frameSize, glm::mat4x4());
     m_serial.assign(TrackerRoleName[(int)rle]);
     m_index = p_index;
     role = rle;
-    m_lCall = systime();
-    m_diff = 1.0;
-    cacheImmediate = cachefast;
+    m_submittedTime = -1.0;
 }
 
 CVirtualBodyTracker::~CVirtualBodyTracker()
@@ -139,70 +136,35 @@ void CVirtualBodyTracker::SetupProperties()
     vr::VRProperties()->SetBoolProperty(m_propertyHandle, vr::Prop_BlockServerShutdown_Bool, false);
 }
 
-void CVirtualBodyTracker::UpdateTransform(const glm::mat4x4 &newTransform)
-{
-    if (m_transformCache.size() > 0)
-    {
-        m_transformCache.pop_front();
-        m_transformCache.push_back(cacheImmediate ? newTransform : GetTransform());
-    }
-    m_curTransform = newTransform;
-    frame = 0.f;
-    m_diff += systime() - m_lCall;
-    m_diff /= 3.0;
-    m_lCall = systime();
-}
-
-const glm::mat4x4 InterpolateOverAll(float t, std::deque<glm::mat4x4> mats)
-{
-    InterpolateInPlace(t, mats, mats.size());
-    return mats[0];
-}
-void InterpolateInPlace(float t, std::deque<glm::mat4x4> &mats, size_t amount)
-{
-    if (amount < 2) return;
-    for (int index = 0; index < amount - 1; index++)
-        mats[index] = CNvSDKInterface::InterpolateMatrix(mats[index], mats[index + 1], t);
-    InterpolateInPlace(t, mats, amount - 1);
-}
-
-const glm::mat4x4 CVirtualBodyTracker::InterpolatedTransform() const
+void CVirtualBodyTracker::RunFrame()
 {
-    //vr_log("DO INTERPOLATION");
-    if (IsConnected() && m_transformCache.size() > 1)
+    int64_t start = LatencyNow();
+    const CTrackerBank &bank = *driver->m_trackerBank;
+    //  Sample times are capture times, the movement they show happened that much earlier still
+    double lag = driver->latencyCompensation ? driver->m_nvInterface->motionLatency.GetLatency() : 0.0;
+    if (driver->posePrediction)
     {
-        float t = (float)((systime() - m_lCall) / m_diff);
-        if (t > 1.5f)
-            t = 1.5f;
-        switch (driver->m_interpolation)
+        //  SteamVR extrapolates from the velocities, so the pose only moves on when a fresh camera sample arrives
+        if (m_submittedTime != bank.GetSampleTime(m_index))
         {
-        case INTERP_MODE::LINEAR:
-            break;
-        case INTERP_MODE::SINE:
-            t = -(std::cos(M_PI * t) - 1.f) / 2.f;
-            break;
-        case INTERP_MODE::QUAD:
-            t = t < 0.5f ? 2.f * t * t : 1.f - std::powf(-2.f * t + 2.f, 2.f) / 2.f;
-            break;
-        case INTERP_MODE::CUBIC:
-            t = t < 0.5f ? 4.f * t * t * t : 1.f - std::powf(-2.f * t + 2.f, 3.f) / 2.f;
-            break;
-        default:
-            return m_curTransform;
+            m_submittedTime = bank.GetSampleTime(m_index);
+            SetPoseTimeOffset(bank.GetSampleTime(m_index) - bank.GetTime() - lag);
+            SetTransform(bank.GetOutput(m_index));
+            SetVelocity(bank.GetVelocity(m_index));
+            SetAngularVelocity(bank.GetAngularVelocity(m_index));
         }
-        return CNvSDKInterface::InterpolateMatrix(GetTransform(), InterpolateOverAll(t, m_transformCache), t * 0.5f);
     }
     else
     {
-        return m_curTransform;
+        //  The interpolated pose trails the newest sample by roughly one sample interval
+        SetPoseTimeOffset(bank.GetSampleTime(m_index) - bank.GetLastCall() - bank.GetInterval() - lag);
+        SetTransform(bank.GetOutput(m_index));
+        SetVelocity(bank.GetVelocity(m_index));
+        SetAngularVelocity(bank.GetAngularVelocity(m_index));
     }
-}
+    SetOffsetTransform(bank.GetOffset());
 
-void CVirtualBodyTracker::RunFrame()
-{
-    SetTransform(InterpolatedTransform());
-    //frame += driver->GetFPS() / driver->GetRefreshRate();
-    
-    if (m_trackedDevice != vr::k_unTrackedDeviceIndexInvalid)
-        vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_trackedDevice, GetPose(), sizeof(vr::DriverPose_t));
-}
\ No newline at end of file
+    //  Unchanged poses (and connection state) are skipped by the submit policy
+    SubmitPose(bank.GetTime());
+    driver->GetLatency().Record(LATENCY_STAGE::SUBMIT, LatencyNow() - start);
+}
@@ -7,26 +7,14 @@ enum class TRACKER_ROLE;
 //  Allows different joints in the system to be available as tracking devices
 class CVirtualBodyTracker : public CVirtualDevice
 {
-    //  The index for the tracker
+    //  The index for the tracker (its lane in the tracker bank)
     size_t m_index;
 
     CVirtualBodyTracker(const CVirtualBodyTracker &that) = delete;
     CVirtualBodyTracker &operator=(const CVirtualBodyTracker &that) = delete;
 
-    //  The last set of transforms that was set (used for interpolation)
-    std::deque<glm::mat4x4> m_transformCache;
-    bool cacheImmediate;
-    //  The current transform set (used for interpolation)
-    glm::mat4x4 m_curTransform;
-
-    bool m_wasSet;
-
-    //  The frame number recorded by the tracker (used for interpolation)
-    float frame;
-    double m_lCall;
-    double m_diff;
-    //  Compute the transform based on the currently set values, and interpolate between them using the frame number
-    const glm::mat4x4 InterpolatedTransform() const;
+    //  Last sample taken from the bank, used to only move the pose on fresh samples when predicting
+    double m_submittedTime;
 
     void SetupProperties() override;
 
@@ -35,11 +23,10 @@ public:
     //  The role of this body tracker
     TRACKER_ROLE role;
 
+    //  Submit the pose for this tracker's lane of the (already evaluated) tracker bank
     void RunFrame() override;
+    inline size_t GetIndex() const { return m_index; }
 
-    //  Update the tracker with data from the body tracking service
-    void UpdateTransform(const glm::mat4x4 &newTransform);
-
-    explicit CVirtualBodyTracker(size_t p_index, TRACKER_ROLE rle, size_t frameSize, bool cachefast = false);
+    explicit CVirtualBodyTracker(size_t p_index, TRACKER_ROLE rle);
     ~CVirtualBodyTracker();
 };
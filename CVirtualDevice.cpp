@@ -30,6 +30,13 @@ CVirtualDevice::CVirtualDevice() : driver(nullptr)
 
     m_propertyHandle = vr::k_ulInvalidPropertyContainer;
     m_trackedDevice = vr::k_unTrackedDeviceIndexInvalid;
+
+    m_submittedPose = m_pose;
+    m_submittedAt = 0.0;
+    m_hasSubmitted = false;
+    m_submitCount = 0u;
+    m_skipCount = 0u;
+    SetSubmitPolicy({ 0.f, 0.f, 0.0 });
 }
 
 CVirtualDevice::~CVirtualDevice()
@@ -150,7 +157,11 @@ const glm::quat CVirtualDevice::GetRotation() const
 }
 const glm::mat4x4 CVirtualDevice::GetTransform() const
 {
-    return CNvSDKInterface::Slide(glm::mat4_cast(GetRotation()), GetPosition());
+    return GetRigidTransform().Matrix();
+}
+const RigidTransform CVirtualDevice::GetRigidTransform() const
+{
+    return RigidTransform(GetPosition(), GetRotation());
 }
 
 const glm::vec3 CVirtualDevice::GetOffsetPosition() const
@@ -172,7 +183,11 @@ const glm::quat CVirtualDevice::GetOffsetRotation() const
 }
 const glm::mat4x4 CVirtualDevice::GetOffsetTransform() const
 {
-    return CNvSDKInterface::Slide(glm::mat4_cast(GetOffsetRotation()), GetOffsetPosition());
+    return GetRigidOffsetTransform().Matrix();
+}
+const RigidTransform CVirtualDevice::GetRigidOffsetTransform() const
+{
+    return RigidTransform(GetOffsetPosition(), GetOffsetRotation());
 }
 
 void CVirtualDevice::SetPosition(const glm::vec3 &pos)
@@ -212,7 +227,17 @@ void CVirtualDevice::SetTransform(const glm::vec3 &pos, const glm::quat &quat)
 }
 void CVirtualDevice::SetTransform(const glm::mat4x4 &mat)
 {
-    SetTransform(glm::vec3(mat[3][0], mat[3][1], mat[3][2]), glm::quat_cast(mat));
+    SetTransform(RigidTransform(mat));
+}
+void CVirtualDevice::SetTransform(const RigidTransform &transform)
+{
+    m_pose.vecPosition[0U] = transform.p[0];
+    m_pose.vecPosition[1U] = transform.p[1];
+    m_pose.vecPosition[2U] = transform.p[2];
+    m_pose.qRotation.x = transform.q[0];
+    m_pose.qRotation.y = transform.q[1];
+    m_pose.qRotation.z = transform.q[2];
+    m_pose.qRotation.w = transform.q[3];
 }
 
 void CVirtualDevice::SetOffsetTransform(const glm::vec3 &pos, const glm::quat &quat)
@@ -222,7 +247,53 @@ void CVirtualDevice::SetOffsetTransform(const glm::vec3 &pos, const glm::quat &q
 }
 void CVirtualDevice::SetOffsetTransform(const glm::mat4x4 &mat)
 {
-    SetOffsetTransform(glm::vec3(mat[3][0], mat[3][1], mat[3][2]), glm::quat_cast(mat));
+    SetOffsetTransform(RigidTransform(mat));
+}
+void CVirtualDevice::SetOffsetTransform(const RigidTransform &transform)
+{
+    m_pose.vecWorldFromDriverTranslation[0U] = transform.p[0];
+    m_pose.vecWorldFromDriverTranslation[1U] = transform.p[1];
+    m_pose.vecWorldFromDriverTranslation[2U] = transform.p[2];
+    m_pose.qWorldFromDriverRotation.x = transform.q[0];
+    m_pose.qWorldFromDriverRotation.y = transform.q[1];
+    m_pose.qWorldFromDriverRotation.z = transform.q[2];
+    m_pose.qWorldFromDriverRotation.w = transform.q[3];
+}
+
+const glm::vec3 CVirtualDevice::GetVelocity() const
+{
+    return glm::vec3(
+        (float)m_pose.vecVelocity[0U],
+        (float)m_pose.vecVelocity[1U],
+        (float)m_pose.vecVelocity[2U]
+    );
+}
+const glm::vec3 CVirtualDevice::GetAngularVelocity() const
+{
+    return glm::vec3(
+        (float)m_pose.vecAngularVelocity[0U],
+        (float)m_pose.vecAngularVelocity[1U],
+        (float)m_pose.vecAngularVelocity[2U]
+    );
+}
+
+void CVirtualDevice::SetVelocity(const glm::vec3 &vel)
+{
+    m_pose.vecVelocity[0U] = vel.x;
+    m_pose.vecVelocity[1U] = vel.y;
+    m_pose.vecVelocity[2U] = vel.z;
+}
+
+void CVirtualDevice::SetAngularVelocity(const glm::vec3 &vel)
+{
+    m_pose.vecAngularVelocity[0U] = vel.x;
+    m_pose.vecAngularVelocity[1U] = vel.y;
+    m_pose.vecAngularVelocity[2U] = vel.z;
+}
+
+void CVirtualDevice::SetPoseTimeOffset(double offset)
+{
+    m_pose.poseTimeOffset = offset;
 }
 
 void CVirtualDevice::DebugTransform() const {
@@ -252,8 +323,59 @@ void CVirtualDevice::SetupProperties()
 {
 }
 
+void CVirtualDevice::SetSubmitPolicy(const SubmitPolicy &policy)
+{
+    m_submitPolicy = policy;
+    m_rotationDot = std::cos(policy.rotationEpsilon / 2.0);
+}
+
+static inline double RotationDot(const vr::HmdQuaternion_t &a, const vr::HmdQuaternion_t &b)
+{
+    return std::abs(a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z);
+}
+
+bool CVirtualDevice::PoseChanged() const
+{
+    const vr::DriverPose_t &last = m_submittedPose;
+    if (last.deviceIsConnected != m_pose.deviceIsConnected || last.poseIsValid != m_pose.poseIsValid || last.result != m_pose.result)
+        return true;
+
+    double distance = m_submitPolicy.positionEpsilon, angle = m_submitPolicy.rotationEpsilon;
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        if (std::abs(m_pose.vecPosition[axis] - last.vecPosition[axis]) > distance ||
+            std::abs(m_pose.vecWorldFromDriverTranslation[axis] - last.vecWorldFromDriverTranslation[axis]) > distance ||
+            std::abs(m_pose.vecVelocity[axis] - last.vecVelocity[axis]) > distance ||
+            std::abs(m_pose.vecAngularVelocity[axis] - last.vecAngularVelocity[axis]) > angle)
+            return true;
+    }
+
+    //  |dot| of two unit quaternions is the cosine of half the angle between them
+    return RotationDot(m_pose.qRotation, last.qRotation) < m_rotationDot ||
+        RotationDot(m_pose.qWorldFromDriverRotation, last.qWorldFromDriverRotation) < m_rotationDot;
+}
+
+bool CVirtualDevice::SubmitPose(double now)
+{
+    if (m_trackedDevice == vr::k_unTrackedDeviceIndexInvalid)
+        return false;
+
+    bool keepAlive = m_submitPolicy.keepAlive > 0.0 && now - m_submittedAt >= m_submitPolicy.keepAlive;
+    if (m_hasSubmitted && !keepAlive && !PoseChanged())
+    {
+        m_skipCount++;
+        return false;
+    }
+
+    vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_trackedDevice, m_pose, sizeof(vr::DriverPose_t));
+    m_submittedPose = m_pose;
+    m_submittedAt = now;
+    m_hasSubmitted = true;
+    m_submitCount++;
+    return true;
+}
+
 void CVirtualDevice::RunFrame()
 {
-    if(m_trackedDevice != vr::k_unTrackedDeviceIndexInvalid)
-        vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_trackedDevice, GetPose(), sizeof(vr::DriverPose_t));
+    SubmitPose(systime());
 }
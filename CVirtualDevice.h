@@ -1,13 +1,36 @@
 #pragma once
+#include "CRigidTransform.h"
 
 class CServerDriver;
 
+//  Decides when a device's pose is handed to vrserver
+struct SubmitPolicy
+{
+    //  Smallest change in position / velocity (meters) and rotation (radians) that counts as a new pose
+    float positionEpsilon;
+    float rotationEpsilon;
+    //  Unchanged poses are still submitted at least this often (seconds, 0 to never resubmit them)
+    double keepAlive;
+};
+
 class CVirtualDevice : public vr::ITrackedDeviceServerDriver
 {
     vr::DriverPose_t m_pose;
     bool m_connected;
     bool m_forcedConnected;
 
+    //  The last pose handed to vrserver, and when
+    vr::DriverPose_t m_submittedPose;
+    double m_submittedAt;
+    bool m_hasSubmitted;
+    SubmitPolicy m_submitPolicy;
+    //  cos(rotationEpsilon / 2), the |dot| below which two rotations differ
+    double m_rotationDot;
+    uint64_t m_submitCount;
+    uint64_t m_skipCount;
+
+    bool PoseChanged() const;
+
     CVirtualDevice(const CVirtualDevice &that) = delete;
     CVirtualDevice &operator=(const CVirtualDevice &that) = delete;
 
@@ -37,20 +60,39 @@ public:
     const glm::vec3 GetPosition() const;
     const glm::quat GetRotation() const;
     const glm::mat4x4 GetTransform() const;
+    const RigidTransform GetRigidTransform() const;
 
     const glm::vec3 GetOffsetPosition() const;
     const glm::quat GetOffsetRotation() const;
     const glm::mat4x4 GetOffsetTransform() const;
+    const RigidTransform GetRigidOffsetTransform() const;
 
     void SetPosition(const glm::vec3 &pos);
     void SetRotation(const glm::quat &quat);
     void SetTransform(const glm::vec3 &pos, const glm::quat &quat);
     void SetTransform(const glm::mat4x4 &mat);
+    void SetTransform(const RigidTransform &transform);
 
     void SetOffsetPosition(const glm::vec3 &pos);
     void SetOffsetRotation(const glm::quat &quat);
     void SetOffsetTransform(const glm::vec3 &pos, const glm::quat &quat);
     void SetOffsetTransform(const glm::mat4x4 &mat);
+    void SetOffsetTransform(const RigidTransform &transform);
+
+    const glm::vec3 GetVelocity() const;
+    const glm::vec3 GetAngularVelocity() const;
+
+    //  Velocities are expressed in driver space, the same space as the position
+    void SetVelocity(const glm::vec3 &vel);
+    void SetAngularVelocity(const glm::vec3 &vel);
+    //  Age of the pose relative to the TrackedDevicePoseUpdated call, negative when the pose is in the past
+    void SetPoseTimeOffset(double offset);
+
+    void SetSubmitPolicy(const SubmitPolicy &policy);
+    //  Hand the pose to vrserver if it changed beyond the policy epsilons, its state changed or the keep-alive elapsed
+    bool SubmitPose(double now);
+    inline uint64_t GetSubmitCount() const { return m_submitCount; }
+    inline uint64_t GetSkipCount() const { return m_skipCount; }
 
     void DebugTransform() const;
     void DebugOffsetTransform() const;
@@ -3,6 +3,19 @@
 
 COverlayManager::COverlayManager(CServerDriver *drv) : driver(drv)
 {
+    m_vrSystem = nullptr;
+    m_dashboardOverlay = vr::k_ulOverlayHandleInvalid;
+    m_dashboardOverlayThumbnail = vr::k_ulOverlayHandleInvalid;
+    m_dashboardTexture = { 0 };
+    m_mousePosition = sf::Vector2i(0, 0);
+    m_lastRender = std::chrono::steady_clock::time_point();
+    m_statsMapping = nullptr;
+    m_statsBlock = nullptr;
+    m_stats = { 0 };
+    m_statsValid = false;
+    m_statsChanged = std::chrono::steady_clock::now();
+    m_active = false;
+
     m_renderTexture = new sf::RenderTexture();
     if (!m_renderTexture->create(1024U, 512U)) throw std::runtime_error("Unable to create render target for GUI overlay");
 
@@ -52,7 +65,154 @@ void COverlayManager::Init()
 
 void COverlayManager::Cleanup()
 {
+    CloseStats();
+    if (m_vrSystem)
+    {
+        vr::VR_Shutdown();
+        m_vrSystem = nullptr;
+    }
+    if (m_renderTexture)
+    {
+        ImGui::SFML::Shutdown();
+        delete m_renderTexture;
+        m_renderTexture = nullptr;
+    }
+    m_active = false;
+}
+
+bool COverlayManager::OpenStats()
+{
+    if (m_statsBlock) return true;
+    m_statsMapping = OpenFileMappingA(FILE_MAP_READ, FALSE, DRIVER_STATS_MAPPING);
+    if (!m_statsMapping) return false; // the driver is not running (yet)
+    m_statsBlock = reinterpret_cast<const DriverStatsBlock *>(MapViewOfFile(m_statsMapping, FILE_MAP_READ, 0, 0, sizeof(DriverStatsBlock)));
+    if (!m_statsBlock)
+    {
+        CloseHandle(m_statsMapping);
+        m_statsMapping = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void COverlayManager::CloseStats()
+{
+    if (m_statsBlock) UnmapViewOfFile(m_statsBlock);
+    if (m_statsMapping) CloseHandle(m_statsMapping);
+    m_statsBlock = nullptr;
+    m_statsMapping = nullptr;
+    m_statsValid = false;
+}
 
+void COverlayManager::ReadStats(std::chrono::steady_clock::time_point p_now)
+{
+    if (!OpenStats() || (m_statsBlock->version != DRIVER_STATS_VERSION))
+    {
+        m_statsValid = false;
+        return;
+    }
+
+    // A block that keeps changing under the reader keeps the previous copy until the next refresh
+    DriverStats l_stats;
+    if (m_statsBlock->Read(l_stats))
+    {
+        if (!m_statsValid || (l_stats.updates != m_stats.updates)) m_statsChanged = p_now;
+        m_stats = l_stats;
+        m_statsValid = true;
+    }
+    if (std::chrono::duration<double>(p_now - m_statsChanged).count() > OVERLAY_STATS_TIMEOUT)
+    {
+        // The driver is gone; its block is let go so a restarted driver is found again
+        CloseStats();
+    }
+}
+
+void COverlayManager::DrawStats()
+{
+    if (!m_statsValid)
+    {
+        ImGui::TextUnformatted("Waiting for the NVIDIA Body Tracking driver...");
+        return;
+    }
+
+    ImGui::BeginChild("Pipeline", ImVec2(ImGui::GetContentRegionAvail().x * .55f, 0.f));
+    {
+        const char *l_state = m_stats.standby ? "Standby" : (m_stats.probing ? "Probing (nobody in frame)" : "Tracking");
+        ImGui::Text("%s, camera %s", l_state, m_stats.cameraState);
+        ImGui::Separator();
+        ImGui::Text("Capture        %6.1f fps", m_stats.captureFps);
+        ImGui::Text("Inference      %6.1f fps  %6.2f ms", m_stats.inferenceFps, m_stats.inferenceMs);
+        ImGui::Text("GPU time share %6.1f %%", m_stats.gpuShare * 100.f);
+        if (m_stats.motionLatencyMs >= 0.f) ImGui::Text("Motion latency %6.1f ms", m_stats.motionLatencyMs);
+        else ImGui::TextUnformatted("Motion latency    n/a (move the controllers in view)");
+        ImGui::Separator();
+        ImGui::Text("Camera stalls %llu, frames skipped while probing %llu", (unsigned long long)m_stats.cameraStalls, (unsigned long long)m_stats.framesSkipped);
+        ImGui::Text("Tracking %.0f s, probing %.0f s", m_stats.trackingTime, m_stats.probingTime);
+        ImGui::Text("Publisher overruns %llu", (unsigned long long)m_stats.publisherOverruns);
+        ImGui::Text("Recorder drops %llu frames, %llu records", (unsigned long long)m_stats.recorderFramesDropped, (unsigned long long)m_stats.recorderRecordsDropped);
+        ImGui::Separator();
+
+        if (m_stats.stageWindow > 0.f) ImGui::Text("Stage latency over the last %.0f s", m_stats.stageWindow);
+        else ImGui::TextUnformatted("Stage latency since startup");
+        if (ImGui::BeginTable("Stages", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+        {
+            ImGui::TableSetupColumn("Stage (ms)");
+            ImGui::TableSetupColumn("p50");
+            ImGui::TableSetupColumn("p95");
+            ImGui::TableSetupColumn("p99");
+            ImGui::TableHeadersRow();
+            for (uint32_t i = 0U; i < (std::min)(m_stats.stageCount, (uint32_t)DRIVER_STATS_STAGES); i++)
+            {
+                const DriverStageStats &l_stage = m_stats.stages[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(l_stage.name);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", l_stage.p50);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", l_stage.p95);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", l_stage.p99);
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::EndChild();
+
+    ImGui::SameLine();
+
+    ImGui::BeginChild("Trackers");
+    if (ImGui::BeginTable("Trackers", 3, ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Tracker");
+        ImGui::TableSetupColumn("Confidence", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("State");
+        ImGui::TableHeadersRow();
+        for (uint32_t i = 0U; i < (std::min)(m_stats.trackerCount, (uint32_t)DRIVER_STATS_TRACKERS); i++)
+        {
+            const DriverTrackerStats &l_tracker = m_stats.trackers[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(l_tracker.name);
+            ImGui::TableNextColumn(); ImGui::ProgressBar(l_tracker.confidence, ImVec2(-1.f, 0.f));
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(l_tracker.standby ? "Standby" : "Active");
+        }
+        ImGui::EndTable();
+    }
+    ImGui::EndChild();
+}
+
+void COverlayManager::Render(float p_delta)
+{
+    m_renderTexture->setActive(true);
+    const sf::Vector2u l_size = m_renderTexture->getSize();
+    ImGui::SFML::Update(m_mousePosition, sf::Vector2f(static_cast<float>(l_size.x), static_cast<float>(l_size.y)), sf::seconds(p_delta));
+
+    ImGui::SetNextWindowPos(ImVec2(0.f, 0.f));
+    ImGui::SetNextWindowSize(ImVec2(static_cast<float>(l_size.x), static_cast<float>(l_size.y)));
+    ImGui::Begin("NVIDIA Body Tracking", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings);
+    DrawStats();
+    ImGui::End();
+
+    m_renderTexture->clear();
+    ImGui::SFML::Render(*m_renderTexture);
+    m_renderTexture->display();
+    SetOverlayTexture(m_renderTexture->getTexture().getNativeHandle());
 }
 
 void COverlayManager::Pulse()
@@ -67,6 +227,7 @@ void COverlayManager::Pulse()
             l_event.type = sf::Event::EventType::MouseMoved;
             l_event.mouseMove.x = m_event.data.mouse.x;
             l_event.mouseMove.y = m_event.data.mouse.y;
+            m_mousePosition = sf::Vector2i(l_event.mouseMove.x, l_event.mouseMove.y);
             ImGui::SFML::ProcessEvent(l_event);
         } break;
         case vr::VREvent_MouseButtonDown: case vr::VREvent_MouseButtonUp:
@@ -81,7 +242,26 @@ void COverlayManager::Pulse()
         }
     }
 
-    if (IsOverlayVisible()) vr::VROverlay()->SetOverlayTexture(m_dashboardOverlay, &m_dashboardTexture);
+    while (m_vrSystem->PollNextEvent(&m_event, sizeof(vr::VREvent_t)))
+    {
+        if (m_event.eventType == vr::VREvent_Quit)
+        {
+            // SteamVR is shutting down, the main loop ends and Cleanup lets go of it
+            m_active = false;
+            return;
+        }
+    }
+
+    // Nothing is read or drawn while the dashboard does not show the overlay
+    if (!IsOverlayVisible()) return;
+    const auto l_now = std::chrono::steady_clock::now();
+    const double l_delta = std::chrono::duration<double>(l_now - m_lastRender).count();
+    if (l_delta < OVERLAY_RENDER_INTERVAL) return;
+    m_lastRender = l_now;
+
+    ReadStats(l_now);
+    Render(static_cast<float>((std::min)(l_delta, 1.0)));
+    vr::VROverlay()->SetOverlayTexture(m_dashboardOverlay, &m_dashboardTexture);
 }
 
 bool COverlayManager::IsOverlayVisible() const
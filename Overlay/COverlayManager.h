@@ -1,7 +1,13 @@
 #pragma once
+#include "CDriverStats.h"
 
 class CServerDriver;
 
+//  How often the HUD is drawn while the dashboard shows it (seconds), the driver writes its stats at the same rate
+#define OVERLAY_RENDER_INTERVAL DRIVER_STATS_INTERVAL
+//  Stats that stopped changing for this long belong to a driver that is gone (seconds)
+#define OVERLAY_STATS_TIMEOUT 2.0
+
 class COverlayManager
 {
     vr::IVRSystem *m_vrSystem;
@@ -17,7 +23,23 @@ class COverlayManager
     vr::VREvent_t m_event;
 
     sf::RenderTexture *m_renderTexture;
-    
+    sf::Vector2i m_mousePosition;
+    std::chrono::steady_clock::time_point m_lastRender;
+
+    //  The driver's stats block (see CDriverStats.h), opened once the driver created it
+    HANDLE m_statsMapping;
+    const DriverStatsBlock *m_statsBlock;
+    DriverStats m_stats;
+    bool m_statsValid;
+    //  When m_stats.updates last moved
+    std::chrono::steady_clock::time_point m_statsChanged;
+
+    bool OpenStats();
+    void CloseStats();
+    void ReadStats(std::chrono::steady_clock::time_point p_now);
+    void DrawStats();
+    void Render(float p_delta);
+
 public:
     CServerDriver *driver;
 
@@ -25,6 +47,7 @@ public:
 
     void Init();
     void Cleanup();
+    //  Handles the overlay events, and redraws the HUD at most every OVERLAY_RENDER_INTERVAL while it is visible
     void Pulse();
     void SetOverlayTexture(unsigned int p_name);
     bool IsOverlayVisible() const;
@@ -32,4 +55,3 @@ public:
     COverlayManager(CServerDriver *dr);
     ~COverlayManager();
 };
-
@@ -0,0 +1,25 @@
+#include "pch.h"
+#include "COverlayManager.h"
+
+// How often overlay events are handled, the HUD itself is only redrawn every OVERLAY_RENDER_INTERVAL
+#define OVERLAY_PULSE_INTERVAL std::chrono::milliseconds(50)
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        COverlayManager l_manager(nullptr);
+        l_manager.Init();
+        while (l_manager.m_active)
+        {
+            l_manager.Pulse();
+            std::this_thread::sleep_for(OVERLAY_PULSE_INTERVAL);
+        }
+    }
+    catch (const std::exception &l_exception)
+    {
+        fprintf(stderr, "%s\n", l_exception.what());
+        return 1;
+    }
+    return 0;
+}
@@ -4,6 +4,8 @@
 // Windows Header Files
 #include <windows.h>
 
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <sstream>
 #include <vector>
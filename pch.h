@@ -1,26 +1,66 @@
 #pragma once
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 // Windows Header Files
 #include <windows.h>
+#include <timeapi.h>
+#endif
 
 #include <string>
 #include <sstream>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <memory>
 #include <atomic>
 #include <chrono>
+#include <ctime>
 #include <limits>
 #include <algorithm>
 #include <functional>
 #include <future>
 #include <map>
+#include <utility>
+
+#ifndef _WIN32
+//  Stand-ins for the few Windows / MSVC functions used outside platform specific code,
+//  so the pipeline can be built on Linux for the benchmark (Benchmark/CMakeLists.txt)
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#define _TRUNCATE ((size_t)-1)
+#define sprintf_s snprintf
+inline int strncpy_s(char *dest, size_t size, const char *src, size_t count)
+{
+    size_t length = (std::min)(strlen(src), (std::min)(count, size - 1u));
+    memcpy(dest, src, length);
+    dest[length] = '\0';
+    return 0;
+}
+inline int fopen_s(FILE **file, const char *path, const char *mode) { *file = fopen(path, mode); return *file == nullptr; }
+inline int localtime_s(tm *result, const time_t *time) { return localtime_r(time, result) == nullptr; }
+inline int _itoa_s(int value, char *buffer, int radix) { snprintf(buffer, 16, radix == 16 ? "%x" : "%d", value); return 0; }
+//  The default timer resolution is fine everywhere else
+inline unsigned timeBeginPeriod(unsigned) { return 0u; }
+inline unsigned timeEndPeriod(unsigned) { return 0u; }
+//  Virtual key codes the hotkeys are bound to
+#define VK_SHIFT 0x10
+#define VK_CONTROL 0x11
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN 0x28
+#define VK_OEM_COMMA 0xBC
+#define VK_OEM_PERIOD 0xBE
+#endif
 
 #include "openvr_driver.h"
 #include "opencv2/opencv.hpp"
 #include "opencv2/highgui.hpp"
 #include "glm/gtc/quaternion.hpp"
+#include "glm/gtx/quaternion.hpp"
 #include "glm/gtx/transform.hpp"
 #include "glm/gtx/euler_angles.hpp"
 #include "glm/gtx/matrix_interpolation.hpp"